@@ -0,0 +1,168 @@
+#include "AdcBurst.h"
+
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+#define ADC_BURST_ATTEN ADC_ATTEN_DB_11
+#define ADC_NOMINAL_FULL_SCALE_MV 2500
+
+static esp_adc_cal_characteristics_t adcChars;
+static bool efuseCalibrated = false;
+static uint32_t calTableQ4[4096 / ADC_CAL_TABLE_STEP + 1];  // Corrected reading at every ADC_CAL_TABLE_STEP counts
+static bool burstActive = false;
+static uint8_t burstSamples = 8;
+static adc_channel_t burstChannel;
+static uint8_t dmaBuf[ADC_BURST_MAX_SAMPLES * ADC_BURST_RESULT_BYTES];
+
+bool adcBurstSetup(uint8_t pin, uint8_t samples_per_burst) {
+    int8_t channel = digitalPinToAnalogChannel(pin);
+    if (channel < 0 || channel >= SOC_ADC_CHANNEL_NUM(0)) {
+        return false; // Not an ADC1 pin
+    }
+    if (burstActive) {
+        adcBurstEnd();
+    }
+
+    burstChannel = (adc_channel_t)channel;
+    burstSamples = constrain(samples_per_burst, 1, ADC_BURST_MAX_SAMPLES);
+
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = sizeof(dmaBuf) * 2;
+    init.conv_num_each_intr = burstSamples * ADC_BURST_RESULT_BYTES; // One interrupt per burst
+    init.adc1_chan_mask = BIT(channel);
+    init.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&init) != ESP_OK) {
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = ADC_BURST_ATTEN;
+    pattern.channel = channel;
+    pattern.unit = 0; // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = false;
+    config.conv_limit_num = 250;
+    config.pattern_num = 1;
+    config.adc_pattern = &pattern;
+    config.sample_freq_hz = ADC_BURST_SAMPLE_RATE;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+    if (adc_digi_controller_configure(&config) != ESP_OK) {
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    esp_adc_cal_value_t source = esp_adc_cal_characterize(ADC_UNIT_1, ADC_BURST_ATTEN, ADC_WIDTH_BIT_12, 0, &adcChars);
+    efuseCalibrated = (source == ESP_ADC_CAL_VAL_EFUSE_TP);
+    // Scaled so the chip's own full scale stays at 4095: the table removes the
+    // offset and bow of the transfer curve but keeps readings in 12-bit range
+    uint32_t fullScaleMv = max(adcRawToMillivolts(4095), (uint32_t)1);
+    for (uint16_t k = 0; k < sizeof(calTableQ4) / sizeof(calTableQ4[0]); k++) {
+        uint16_t raw = min(k * ADC_CAL_TABLE_STEP, 4095);
+        calTableQ4[k] = min(adcRawToMillivolts(raw) * (4095 * 16) / fullScaleMv, (uint32_t)(4095 << 4));
+    }
+
+    burstActive = true;
+    return true;
+}
+
+void adcBurstEnd() {
+    if (!burstActive) {
+        return;
+    }
+    adc_digi_stop();
+    adc_digi_deinitialize();
+    burstActive = false;
+}
+
+uint8_t adcBurstRead(uint16_t* out, uint32_t budget_us) {
+    if (!burstActive) {
+        return 0;
+    }
+
+    uint32_t start = micros();
+    uint8_t count = 0;
+    adc_digi_start();
+    while (count < burstSamples && micros() - start < budget_us) {
+        uint32_t got = 0;
+        uint32_t want = (burstSamples - count) * ADC_BURST_RESULT_BYTES;
+        if (adc_digi_read_bytes(dmaBuf, want, &got, 1) != ESP_OK) {
+            continue;
+        }
+        for (uint32_t i = 0; i + ADC_BURST_RESULT_BYTES <= got && count < burstSamples; i += ADC_BURST_RESULT_BYTES) {
+            adc_digi_output_data_t* result = (adc_digi_output_data_t*)&dmaBuf[i];
+            if (result->type2.unit == 0 && result->type2.channel == burstChannel) {
+                out[count++] = result->type2.data;
+            }
+        }
+    }
+    adc_digi_stop();
+
+    // Drop anything converted after the burst filled so the next channel starts clean
+    uint32_t got = 0;
+    while (adc_digi_read_bytes(dmaBuf, sizeof(dmaBuf), &got, 0) == ESP_OK && got > 0) {
+    }
+    return count;
+}
+
+// Insertion sort: n is at most ADC_BURST_MAX_SAMPLES and usually 8
+static void sortSamples(uint16_t* samples, uint8_t n) {
+    for (uint8_t i = 1; i < n; i++) {
+        uint16_t v = samples[i];
+        int8_t j = i - 1;
+        while (j >= 0 && samples[j] > v) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = v;
+    }
+}
+
+uint32_t adcReduceMedianQ4(uint16_t* samples, uint8_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    sortSamples(samples, n);
+    if (n & 1) {
+        return (uint32_t)samples[n / 2] << 4;
+    }
+    return ((uint32_t)samples[n / 2 - 1] + samples[n / 2]) << 3;
+}
+
+uint32_t adcReduceTrimmedMeanQ4(uint16_t* samples, uint8_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    sortSamples(samples, n);
+    uint8_t trim = n / 4;
+    uint32_t sum = 0;
+    for (uint8_t i = trim; i < n - trim; i++) {
+        sum += samples[i];
+    }
+    uint8_t kept = n - 2 * trim;
+    return ((sum << 4) + kept / 2) / kept;
+}
+
+uint32_t adcRawToMillivolts(uint16_t raw) {
+    if (adcChars.coeff_a == 0) {
+        return (uint32_t)raw * ADC_NOMINAL_FULL_SCALE_MV / 4095;
+    }
+    return esp_adc_cal_raw_to_voltage(raw, &adcChars);
+}
+
+uint32_t adcCalibrateQ4(uint32_t rawQ4) {
+    if (!efuseCalibrated) {
+        return rawQ4;
+    }
+    const uint32_t span = ADC_CAL_TABLE_STEP * 16;
+    uint32_t k = min(rawQ4 / span, (uint32_t)(sizeof(calTableQ4) / sizeof(calTableQ4[0]) - 2));
+    int32_t frac = rawQ4 - k * span;
+    int32_t corrected = (int32_t)calTableQ4[k] + ((int32_t)(calTableQ4[k + 1] - calTableQ4[k]) * frac) / (int32_t)span;
+    return corrected < 0 ? 0 : corrected;
+}
+
+bool adcHasEfuseCalibration() {
+    return efuseCalibrated;
+}
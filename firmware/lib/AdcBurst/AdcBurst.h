@@ -0,0 +1,67 @@
+#ifndef ADC_BURST_H
+#define ADC_BURST_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define ADC_BURST_MAX_SAMPLES 32        // Upper bound on K
+#define ADC_BURST_SAMPLE_RATE 80000     // Hz, just under the C3 DMA limit of 83.3 kHz
+#define ADC_BURST_RESULT_BYTES 4        // One TYPE2 conversion result
+#define ADC_CAL_TABLE_STEP 128          // Raw counts between points of the calibration table
+
+/**
+ * Puts ADC1 into continuous (DMA) mode on the given GPIO and loads the eFuse
+ * calibration. While active, analogRead() must not be used on ADC1.
+ * @param pin GPIO of the ADC1 input
+ * @param samples_per_burst Conversions collected per adcBurstRead() call
+ * @return false if the pin is not on ADC1 or the driver could not be started
+ */
+bool adcBurstSetup(uint8_t pin, uint8_t samples_per_burst);
+
+/**
+ * Releases the continuous driver so one-shot analogRead() works again.
+ */
+void adcBurstEnd();
+
+/**
+ * Runs one burst of conversions. The DMA stays stopped between bursts so no
+ * sample taken before the call (e.g. before a mux switch) is returned.
+ * @param out Buffer for up to ADC_BURST_MAX_SAMPLES raw 12-bit values
+ * @param budget_us Give up once this much time has passed
+ * @return Number of samples written to out
+ */
+uint8_t adcBurstRead(uint16_t* out, uint32_t budget_us);
+
+/**
+ * Median of n samples, in 1/16 counts. Reorders samples.
+ */
+uint32_t adcReduceMedianQ4(uint16_t* samples, uint8_t n);
+
+/**
+ * Mean after discarding the lowest and highest quarter, in 1/16 counts. Reorders samples.
+ */
+uint32_t adcReduceTrimmedMeanQ4(uint16_t* samples, uint8_t n);
+
+/**
+ * Converts a raw reading to millivolts using the eFuse calibration loaded by
+ * adcBurstSetup(), or the nominal transfer curve if the chip has none.
+ */
+uint32_t adcRawToMillivolts(uint16_t raw);
+
+/**
+ * Corrects a reduced reading with the eFuse calibration, keeping the units and
+ * range of the raw ADC: the result is linear in input voltage, with 0 and 4095
+ * (in 1/16 counts) where the chip reads 0 mV and its own full scale. This
+ * removes the offset and curvature of the chip's transfer curve, while a
+ * chip's overall gain is left to the per-glove calibration tables. Piecewise
+ * linear through a table adcBurstSetup() builds, i.e. one multiply and divide
+ * per channel. Returns the reading unchanged if the chip has no eFuse calibration.
+ */
+uint32_t adcCalibrateQ4(uint32_t rawQ4);
+
+/**
+ * True if eFuse two-point calibration values were found.
+ */
+bool adcHasEfuseCalibration();
+
+#endif
@@ -1,4 +1,6 @@
 #include "BNO085.h"
+#include "DeferredLog.h"
+#include "ImuHistory.h"
 
 Adafruit_BNO08x bno08x;
 sh2_SensorValue_t sensorValue;
@@ -16,6 +18,49 @@ float linear_x = 0;
 float linear_y = 0;
 float linear_z = 0;
 
+float gyro_x = 0;
+float gyro_y = 0;
+float gyro_z = 0;
+
+float gravity_x = 0;
+float gravity_y = 0;
+float gravity_z = 0;
+
+Bno085Counters bno085Counters;
+
+struct ReportConfig {
+    sh2_SensorId_t sensorId;
+    uint32_t interval_us;
+    uint32_t batch_us;
+};
+
+static const ReportConfig reportConfigs[] = {
+    {SH2_ARVR_STABILIZED_RV, BNO085_RV_INTERVAL_US, 0},
+    {SH2_GYROSCOPE_CALIBRATED, BNO085_GYRO_INTERVAL_US, BNO085_BATCH_INTERVAL_US},
+    {SH2_LINEAR_ACCELERATION, BNO085_LINEAR_INTERVAL_US, BNO085_BATCH_INTERVAL_US},
+    {SH2_GRAVITY, BNO085_GRAVITY_INTERVAL_US, BNO085_BATCH_INTERVAL_US},
+};
+
+// One FIFO per vector type; the sensor callback writes, bno085SampleAt() reads.
+// Both run in the loop() task. Gravity is not buffered, nothing needs its history.
+static struct {
+    ImuVectorSample samples[IMU_VECTOR_BUFFER_SIZE];
+    uint32_t head;
+    uint32_t tail;
+} vectorBuffers[IMU_VECTOR_TYPE_COUNT];
+
+static_assert((IMU_VECTOR_BUFFER_SIZE & (IMU_VECTOR_BUFFER_SIZE - 1)) == 0, "IMU_VECTOR_BUFFER_SIZE must be a power of two");
+
+static volatile bool imuPresent = false;
+static uint32_t imuReadyMs = 0;
+static TaskHandle_t initTask = nullptr;
+static StackType_t initStack[BNO085_INIT_TASK_STACK];
+static StaticTask_t initTaskBuffer;
+static bool imuResetSeen = false;
+static unsigned long lastResetMs = 0;
+static uint8_t imuAccuracy = 0;
+static unsigned long lastRotationMs = 0;
+
 void printBNO085Values() {
     // Serial.println("Quaternion Values:");
     // Serial.print("X: "); Serial.print(quaternion_x, 4);
@@ -36,77 +81,194 @@ void printBNO085Values() {
     // Serial.print(" Z: "); Serial.println(linear_z);
 }
 
-void setReports() {
-    // ARVR stabilized rotation vector at 5ms interval (200Hz)
-    if (!bno08x.enableReport(SH2_ARVR_STABILIZED_RV, 1)) {
-        Serial.println("Could not enable stabilized rotation vector");
+static void pushVector(ImuVectorType type, uint32_t timestamp_us, float x, float y, float z) {
+    auto& buffer = vectorBuffers[type];
+    if (buffer.head - buffer.tail == IMU_VECTOR_BUFFER_SIZE) {
+        buffer.tail++;
+        bno085Counters.overwritten++;
     }
+    buffer.samples[buffer.head & (IMU_VECTOR_BUFFER_SIZE - 1)] = {timestamp_us, x, y, z};
+    buffer.head++;
+    bno085Counters.vectors[type]++;
+}
 
-    // // Use regular accelerometer at 2.5ms interval (400Hz)
-    // // Changed from LINEAR_ACCELERATION to regular ACCELEROMETER
-    // if (!bno08x.enableReport(SH2_ACCELEROMETER)) {
-    //     Serial.println("Could not enable accelerometer");
-    // }
+bool bno085SampleAt(ImuVectorType type, uint32_t timestamp_us, ImuVectorSample* out) {
+    auto& buffer = vectorBuffers[type];
+    if (buffer.head == buffer.tail) {
+        return false;
+    }
+    // Samples before the last one at or before timestamp_us are never needed again.
+    // The newest sample is always kept so a frame without a fresh report still has one.
+    const uint32_t mask = IMU_VECTOR_BUFFER_SIZE - 1;
+    while (buffer.head - buffer.tail >= 2 &&
+           (int32_t)(buffer.samples[(buffer.tail + 1) & mask].timestamp_us - timestamp_us) <= 0) {
+        buffer.tail++;
+    }
+    *out = buffer.samples[buffer.tail & mask];
+    if (buffer.head - buffer.tail >= 2) {
+        const ImuVectorSample& next = buffer.samples[(buffer.tail + 1) & mask];
+        if (abs((int32_t)(next.timestamp_us - timestamp_us)) < abs((int32_t)(out->timestamp_us - timestamp_us))) {
+            *out = next;
+        }
+    }
+    return true;
+}
 
-    // // Add linear acceleration reporting
-    // if (!bno08x.enableReport(SH2_LINEAR_ACCELERATION)) {
-    //     Serial.println("Could not enable linear acceleration");
-    // }
+// Replaces the Adafruit handler, which keeps only the last event of a
+// transfer. Called from sh2_service() once for every report in the transfer.
+static void sensorHandler(void* cookie, sh2_SensorEvent_t* event) {
+    if (sh2_decodeSensorEvent(&sensorValue, event) != SH2_OK) {
+        return;
+    }
+
+    // SH2 timestamps are on the host clock, corrected for the sensor's report delay
+    uint32_t timestamp = (uint32_t)sensorValue.timestamp;
+    switch (sensorValue.sensorId) {
+        case SH2_ARVR_STABILIZED_RV:
+            quaternion_x = sensorValue.un.arvrStabilizedRV.j;
+            quaternion_y = sensorValue.un.arvrStabilizedRV.k;
+            quaternion_z = sensorValue.un.arvrStabilizedRV.i;
+            quaternion_w = sensorValue.un.arvrStabilizedRV.real;
+            imuAccuracy = sensorValue.status & IMU_STATUS_ACCURACY_MASK;
+            lastRotationMs = millis();
+            imuHistoryPush(timestamp, quaternion_x, quaternion_y, quaternion_z, quaternion_w);
+            bno085Counters.rotation++;
+            break;
+
+        case SH2_GYROSCOPE_CALIBRATED:
+            gyro_x = sensorValue.un.gyroscope.x;
+            gyro_y = sensorValue.un.gyroscope.y;
+            gyro_z = sensorValue.un.gyroscope.z;
+            pushVector(IMU_GYRO, timestamp, gyro_x, gyro_y, gyro_z);
+            break;
+
+        case SH2_LINEAR_ACCELERATION:
+            linear_x = sensorValue.un.linearAcceleration.x;
+            linear_y = sensorValue.un.linearAcceleration.y;
+            linear_z = sensorValue.un.linearAcceleration.z;
+            pushVector(IMU_LINEAR_ACCEL, timestamp, linear_x, linear_y, linear_z);
+            break;
+
+        case SH2_GRAVITY:
+            gravity_x = sensorValue.un.gravity.x;
+            gravity_y = sensorValue.un.gravity.y;
+            gravity_z = sensorValue.un.gravity.z;
+            bno085Counters.vectors[IMU_GRAVITY]++;
+            break;
+    }
 }
 
-void setupBNO085() {
+static uint32_t reportTotal() {
+    uint32_t total = bno085Counters.rotation;
+    for (uint8_t i = 0; i < IMU_VECTOR_TYPE_COUNT; i++) {
+        total += bno085Counters.vectors[i];
+    }
+    return total;
+}
+
+void setReports() {
+    for (const ReportConfig& report : reportConfigs) {
+        sh2_SensorConfig_t config = {};
+        config.reportInterval_us = report.interval_us;
+        config.batchInterval_us = report.batch_us;
+        if (sh2_setSensorConfig(report.sensorId, &config) != SH2_OK) {
+            Serial.print("Could not enable SH2 report ");
+            Serial.println(report.sensorId);
+        }
+    }
+}
+
+// Runs next to the rest of startup: begin_I2C() resets the sensor and waits
+// for it in delay(), which would otherwise hold up the first frames
+static void initLoop(void* param) {
     Wire.begin(I2C_SDA, I2C_SCL);
-    
-    // Try to initialize the sensor
-    if (!bno08x.begin_I2C(0x4B)) {
-        Serial.println("Failed to find BNO085 chip");
-        while (1) { delay(10); }
+
+    bool reported = false;
+    while (!bno08x.begin_I2C(0x4B)) {
+        if (!reported) {
+            LOG(LOG_IMU_MISSING, BNO085_RETRY_MS);
+            reported = true;
+        }
+        vTaskDelay(pdMS_TO_TICKS(BNO085_RETRY_MS));
     }
-    
-    Serial.println("BNO085 Found!");
+
+    sh2_setSensorCallback(sensorHandler, nullptr);
     setReports();
+    imuReadyMs = millis();
+    // loop() owns the bus from here on
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    imuPresent = true;
+    LOG(LOG_IMU_READY, imuReadyMs);
+    initTask = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void setupBNO085() {
+    if (imuPresent || initTask != nullptr) {
+        return;
+    }
+    initTask = xTaskCreateStatic(initLoop, "bno085_init", BNO085_INIT_TASK_STACK, nullptr, BNO085_INIT_TASK_PRIORITY,
+                                 initStack, &initTaskBuffer);
+    if (initTask == nullptr) {
+        Serial.println("Failed to start the BNO085 init task");
+    }
+}
+
+bool bno085Ready() {
+    return imuPresent;
+}
+
+uint32_t bno085ReadyMs() {
+    return imuPresent ? imuReadyMs : 0;
 }
 
 void updateBNO085() {
     static unsigned long lastPrint = 0;
     const unsigned long PRINT_INTERVAL = 100; // Print every 100ms
 
+    if (!imuPresent) {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
     if (bno08x.wasReset()) {
-        Serial.println("BNO085 was reset");
+        LOG(LOG_IMU_RESET);
+        imuHistoryReset();
+        imuResetSeen = true;
+        lastResetMs = millis();
         setReports();
     }
     
-    if (bno08x.getSensorEvent(&sensorValue)) {
-        switch (sensorValue.sensorId) {
-            case SH2_ARVR_STABILIZED_RV:
-                quaternion_x = sensorValue.un.arvrStabilizedRV.j;
-                quaternion_y = sensorValue.un.arvrStabilizedRV.k;
-                quaternion_z = sensorValue.un.arvrStabilizedRV.i;
-                quaternion_w = sensorValue.un.arvrStabilizedRV.real;
-                quaternionToEuler();
-                break;
-                
-            case SH2_ACCELEROMETER:
-                linear_x = sensorValue.un.accelerometer.x;
-                linear_y = sensorValue.un.accelerometer.y;
-                linear_z = sensorValue.un.accelerometer.z;
-                break;
-            
-            case SH2_LINEAR_ACCELERATION:
-                linear_x = sensorValue.un.linearAcceleration.x;
-                linear_y = sensorValue.un.linearAcceleration.y;
-                linear_z = sensorValue.un.linearAcceleration.z;
-                break;
+    // Drain every transfer the sensor has queued; each can carry several batched reports
+    uint32_t rotationsBefore = bno085Counters.rotation;
+    for (uint8_t pass = 0; pass < BNO085_MAX_SERVICE_PASSES; pass++) {
+        uint32_t before = reportTotal();
+        sh2_service();
+        if (reportTotal() == before) {
+            break;
         }
+        bno085Counters.transfers++;
+    }
 
-        // Only print every PRINT_INTERVAL milliseconds
-        if (millis() - lastPrint >= PRINT_INTERVAL) {
-            printBNO085Values();
-            lastPrint = millis();
-        }
+    if (bno085Counters.rotation != rotationsBefore) {
+        quaternionToEuler();
+    }
+
+    // Only log every PRINT_INTERVAL milliseconds; deferred so it never stalls the loop
+    if (millis() - lastPrint >= PRINT_INTERVAL) {
+        LOG(LOG_IMU_EULER, imuAccuracy, ypr.yaw, ypr.pitch, ypr.roll);
+        lastPrint = millis();
     }
 }
 
+uint8_t bno085Status() {
+    uint8_t status = imuAccuracy;
+    if (imuPresent) status |= IMU_STATUS_PRESENT;
+    if (imuResetSeen && millis() - lastResetMs < IMU_RESET_FLAG_MS) status |= IMU_STATUS_RESET;
+    if (!imuPresent || millis() - lastRotationMs > IMU_STALE_MS) status |= IMU_STATUS_STALE;
+    return status;
+}
+
 void quaternionToEuler() {
     float sqr = sq(quaternion_w);
     float sqi = sq(quaternion_x);
@@ -145,3 +307,12 @@ void quaternionToEuler() {
     //     ypr.roll += 180;
     // }
 }
+
+void printBNO085Stats() {
+    Serial.print("BNO085 reports rotation: "); Serial.print(bno085Counters.rotation);
+    Serial.print(" gyro: "); Serial.print(bno085Counters.vectors[IMU_GYRO]);
+    Serial.print(" linear: "); Serial.print(bno085Counters.vectors[IMU_LINEAR_ACCEL]);
+    Serial.print(" gravity: "); Serial.print(bno085Counters.vectors[IMU_GRAVITY]);
+    Serial.print(" transfers: "); Serial.print(bno085Counters.transfers);
+    Serial.print(" overwritten: "); Serial.println(bno085Counters.overwritten);
+}
@@ -9,6 +9,50 @@
 #define I2C_SDA 21
 #define I2C_SCL 20
 
+// IMU status byte carried in every outgoing frame
+#define IMU_STATUS_ACCURACY_MASK 0x03   // SH2 accuracy of the last rotation vector (0-3)
+#define IMU_STATUS_PRESENT       0x04   // BNO085 answered at startup
+#define IMU_STATUS_RESET         0x08   // Sensor reset within the last IMU_RESET_FLAG_MS
+#define IMU_STATUS_STALE         0x10   // No rotation vector within IMU_STALE_MS
+#define IMU_STALE_MS 100
+#define IMU_RESET_FLAG_MS 500
+
+// SH2 report intervals. Batched reports wait in the sensor's FIFO for up to
+// their batch interval and ride along with the next rotation vector, so one
+// I2C transfer carries several reports.
+#define BNO085_RV_INTERVAL_US 2500          // 400 Hz, never batched
+#define BNO085_GYRO_INTERVAL_US 2500        // 400 Hz
+#define BNO085_LINEAR_INTERVAL_US 5000      // 200 Hz
+#define BNO085_GRAVITY_INTERVAL_US 10000    // 100 Hz
+#define BNO085_BATCH_INTERVAL_US 5000
+#define BNO085_MAX_SERVICE_PASSES 8         // SHTP transfers drained per updateBNO085()
+
+#define IMU_VECTOR_BUFFER_SIZE 16           // Samples kept per vector type, power of two
+
+// Startup runs in its own task so frames flow while the sensor boots
+#define BNO085_RETRY_MS 1000                // Between attempts while no sensor answers
+#define BNO085_INIT_TASK_PRIORITY 1
+#define BNO085_INIT_TASK_STACK 4096
+
+enum ImuVectorType : uint8_t {
+    IMU_GYRO = 0,           // Calibrated angular velocity, rad/s
+    IMU_LINEAR_ACCEL,       // Acceleration without gravity, m/s^2
+    IMU_GRAVITY,            // Gravity vector, m/s^2
+    IMU_VECTOR_TYPE_COUNT
+};
+
+struct ImuVectorSample {
+    uint32_t timestamp_us;  // SH2 event time on the micros() clock
+    float x, y, z;
+};
+
+struct Bno085Counters {
+    uint32_t rotation;      // Reports received per sensor since setup
+    uint32_t vectors[IMU_VECTOR_TYPE_COUNT];
+    uint32_t transfers;     // sh2_service() passes that produced at least one report
+    uint32_t overwritten;   // Vector samples lost because nobody read them in time
+};
+
 // Declare the struct type
 struct euler_t {
     float yaw;
@@ -19,11 +63,48 @@ struct euler_t {
 // Declare the variable as extern
 extern euler_t ypr;
 
+/**
+ * Starts bringing up the sensor in the background and returns right away.
+ * Until it answers, updateBNO085() does nothing and bno085Status() reports
+ * the IMU missing and stale; a missing sensor is retried every BNO085_RETRY_MS.
+ */
 void setupBNO085();
 void updateBNO085();
+
+/**
+ * True once the sensor answered and its reports are configured.
+ */
+bool bno085Ready();
+
+/**
+ * millis() at which the sensor became ready, 0 while it is not.
+ */
+uint32_t bno085ReadyMs();
 void printBNO085Values();
 void quaternionToEuler();
 
+/**
+ * Returns the IMU_STATUS_* flags describing the current orientation data.
+ */
+uint8_t bno085Status();
+
+/**
+ * The buffered sample of a vector type nearest to a time, e.g. a frame's
+ * capture time. Samples older than that are dropped from the buffer; the
+ * newest is kept, so every frame gets a sample once one has arrived. When a
+ * buffer fills up because nobody asks, the oldest sample is overwritten.
+ * Only IMU_GYRO and IMU_LINEAR_ACCEL are buffered.
+ * @return false if no sample of the type has arrived yet
+ */
+bool bno085SampleAt(ImuVectorType type, uint32_t timestamp_us, ImuVectorSample* out);
+
+extern Bno085Counters bno085Counters;
+
+/**
+ * Prints per-report counters over Serial
+ */
+void printBNO085Stats();
+
 // Declare external variables to store sensor data
 extern float quaternion_x;
 extern float quaternion_y;
@@ -34,4 +115,12 @@ extern float linear_x;
 extern float linear_y;
 extern float linear_z;
 
+extern float gyro_x;
+extern float gyro_y;
+extern float gyro_z;
+
+extern float gravity_x;
+extern float gravity_y;
+extern float gravity_z;
+
 #endif 
\ No newline at end of file
@@ -0,0 +1,147 @@
+#ifndef CALIBRATION_BLOB_H
+#define CALIBRATION_BLOB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Per-glove calibration blob: one reading-to-angle table per Hall sensor.
+// Plain C++ with no Arduino dependencies, so host/tools/calib_fit writes
+// blobs with this header as is.
+//
+// Layout (little endian, packed):
+//   BlobHeader
+//   int16_t knots[sensor_count][knot_count]
+//
+// Knot k of a sensor is its angle, in 1/16 units of proto_angles, at the
+// reading k << knot_shift counts; readings between knots are interpolated
+// linearly. crc covers the knots.
+
+#define CALIBRATION_MAGIC 0x4C434745        // "EGCL"
+#define CALIBRATION_VERSION 1
+#define CALIBRATION_SENSOR_COUNT 16
+#define CALIBRATION_KNOT_SHIFT 6            // Knots every 64 counts
+#define CALIBRATION_KNOT_COUNT ((4096 >> CALIBRATION_KNOT_SHIFT) + 1)
+#define CALIBRATION_ANGLE_SCALE 16.0f       // Knots are proto angles in 1/16
+#define CALIBRATION_READING_OFFSET 2048     // Readings recorded for fitting travel as joints minus this
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Calibration blobs are stored in the target's byte order, little endian"
+#endif
+
+namespace calib {
+
+#pragma pack(push, 1)
+struct BlobHeader {
+    uint32_t magic;             // CALIBRATION_MAGIC
+    uint16_t version;           // CALIBRATION_VERSION
+    uint16_t header_size;
+    uint32_t device_id;         // Glove the tables were fitted for
+    uint16_t sensor_count;      // CALIBRATION_SENSOR_COUNT
+    uint16_t knot_count;        // CALIBRATION_KNOT_COUNT
+    uint8_t knot_shift;         // CALIBRATION_KNOT_SHIFT
+    uint8_t reserved[3];
+    uint32_t crc;               // CRC-32 of the knots
+    int64_t created_unix_ms;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BlobHeader) == 32, "Calibration blob header layout changed");
+
+typedef int16_t Table[CALIBRATION_KNOT_COUNT];
+
+static const size_t BLOB_SIZE = sizeof(BlobHeader) + CALIBRATION_SENSOR_COUNT * sizeof(Table);
+
+// The hand-fitted quadratics the glove shipped with, angle = a*x^2 + b*x + c
+// over the reading x in counts. Gloves without a blob are tabulated from these.
+static const double DEFAULT_POLY[CALIBRATION_SENSOR_COUNT][3] = {
+    {-0.000087481431887,0.549306011516565,-709.440158534950912},  //thumb 0
+    {0.000043188683603,-0.288631646308703,+518.26001946236131},   //thumb 1
+    {0.000081944493116,-0.48715545187493,753.215310445897971},    //thumb 2
+    {0.000029299702805,-0.235958663536102,473.892439373476074},   //thumb 3
+    {-0.000005288207298,0.121258593336859,-147.245901639344262},  //pointer 4
+    {-0.000135942468348,0.817456387325188,-1033.093236601650843}, //pointer 5
+    {0.000101643291297,-0.646716069346575,1031.971761445997989},  //pointer 6
+    {-0.000041474654378,0.275529953917051,-295.161290322580645},  //middle 7
+    {-0.000155663598998,0.846081469596033,-994.321241823930591},  //middle 8
+    {0.000170233984067,-1.128460118194487,1768.951835332448657},  //middle 9
+    // The ring rows reuse the middle finger's curves. The ring fits below were
+    // never validated on a glove, and ring 11 is not monotone over the sensor
+    // range (it peaks near 2491 counts), so they stay disabled until refitted.
+    {-0.000041474654378,0.275529953917051,-295.161290322580645},  //middle 7
+    {-0.000155663598998,0.846081469596033,-994.321241823930591},  //middle 8
+    {0.000170233984067,-1.128460118194487,1768.951835332448657},  //middle 9
+    // {-0.000053897180763,0.344485903814262,-417.201492537313433},  //ring 10
+    // {-0.000406773372404,2.026886777162145,-2364.087785492362531}, //ring 11
+    // {0.000020669692875,-0.186416998438648,403.233727023548938},   //ring 12
+    {-0.000050156739812,0.308087774294671,-325.54858934169279},   //pinkie 13
+    {-0.000204869267408,1.180238586110067,-1522.071698458919325}, //pinkie 14
+    {0.00009027900176,-0.57849114376526,925.953643298021097},     //pinkie 15
+};
+
+inline int16_t toKnot(double angle) {
+    double v = angle * CALIBRATION_ANGLE_SCALE;
+    v = v < -32768 ? -32768 : v > 32767 ? 32767 : v;
+    return (int16_t)(v < 0 ? v - 0.5 : v + 0.5);
+}
+
+/**
+ * Tabulates one of the default quadratics.
+ */
+inline void defaultTable(uint8_t sensor, Table out) {
+    const double* p = DEFAULT_POLY[sensor];
+    for (int k = 0; k < CALIBRATION_KNOT_COUNT; k++) {
+        double x = k << CALIBRATION_KNOT_SHIFT;
+        out[k] = toKnot(p[0] * x * x + p[1] * x + p[2]);
+    }
+}
+
+/**
+ * Angle of a reading, integer interpolation between the two nearest knots.
+ * @param readingQ4 Reading in 1/16 counts, 0 .. 4095 << 4
+ * @return Angle in 1/16 units
+ */
+inline int32_t lookupQ4(const Table table, uint32_t readingQ4) {
+    const uint8_t shift = CALIBRATION_KNOT_SHIFT + 4;
+    uint32_t k = readingQ4 >> shift;
+    if (k >= CALIBRATION_KNOT_COUNT - 1) {
+        return table[CALIBRATION_KNOT_COUNT - 1];
+    }
+    int32_t frac = readingQ4 & ((1u << shift) - 1);
+    int32_t a = table[k];
+    return a + (((table[k + 1] - a) * frac) >> shift);
+}
+
+inline uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * Checks a complete blob.
+ * @return nullptr if it is usable, otherwise what is wrong with it
+ */
+inline const char* validateBlob(const uint8_t* blob, size_t len) {
+    BlobHeader h;
+    if (len < sizeof(h)) return "truncated header";
+    memcpy(&h, blob, sizeof(h));
+    if (h.magic != CALIBRATION_MAGIC) return "not a calibration blob";
+    if (h.version != CALIBRATION_VERSION || h.header_size != sizeof(h)) return "unsupported version";
+    if (h.sensor_count != CALIBRATION_SENSOR_COUNT || h.knot_count != CALIBRATION_KNOT_COUNT ||
+        h.knot_shift != CALIBRATION_KNOT_SHIFT) {
+        return "table shape does not match this firmware";
+    }
+    if (len != BLOB_SIZE) return "wrong size";
+    if (crc32(blob + sizeof(h), len - sizeof(h)) != h.crc) return "checksum mismatch";
+    return nullptr;
+}
+
+}  // namespace calib
+
+#endif
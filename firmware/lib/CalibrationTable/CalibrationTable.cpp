@@ -0,0 +1,140 @@
+#include "CalibrationTable.h"
+#include <Preferences.h>
+
+// Two sets so an install never leaves the sampler with half-written tables
+static calib::Table tables[2][CALIBRATION_SENSOR_COUNT];
+static volatile uint8_t current = 0;
+static uint32_t deviceId = 0;
+static bool fromBlob = false;
+
+static void loadDefaults(uint8_t set) {
+    for (uint8_t i = 0; i < CALIBRATION_SENSOR_COUNT; i++) {
+        calib::defaultTable(i, tables[set][i]);
+    }
+}
+
+// Copies a validated blob into the set the sampler is not using and switches to it
+static void activate(const uint8_t* blob) {
+    uint8_t next = current ^ 1;
+    calib::BlobHeader header;
+    memcpy(&header, blob, sizeof(header));
+    memcpy(tables[next], blob + sizeof(header), sizeof(tables[next]));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    current = next;
+    deviceId = header.device_id;
+    fromBlob = true;
+}
+
+bool calibrationTableSetup() {
+    loadDefaults(current);
+    fromBlob = false;
+
+    Preferences prefs;
+    if (!prefs.begin(CALIBRATION_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    static uint8_t blob[calib::BLOB_SIZE];
+    size_t len = prefs.getBytesLength(CALIBRATION_NVS_KEY);
+    bool loaded = false;
+    if (len == sizeof(blob) && prefs.getBytes(CALIBRATION_NVS_KEY, blob, sizeof(blob)) == len) {
+        const char* problem = calib::validateBlob(blob, len);
+        if (problem == nullptr) {
+            activate(blob);
+            loaded = true;
+        } else {
+            Serial.print("Stored calibration ignored: ");
+            Serial.println(problem);
+        }
+    }
+    prefs.end();
+    return loaded;
+}
+
+bool calibrationTableInstall(const uint8_t* blob, size_t len) {
+    const char* problem = calib::validateBlob(blob, len);
+    if (problem != nullptr) {
+        Serial.print("Calibration rejected: ");
+        Serial.println(problem);
+        return false;
+    }
+    activate(blob);
+
+    Preferences prefs;
+    if (!prefs.begin(CALIBRATION_NVS_NAMESPACE, false) ||
+        prefs.putBytes(CALIBRATION_NVS_KEY, blob, len) != len) {
+        Serial.println("Calibration active but could not be stored");
+        prefs.end();
+        return false;
+    }
+    prefs.end();
+    return true;
+}
+
+bool calibrationTableReceive(Stream& stream) {
+    static uint8_t blob[calib::BLOB_SIZE];
+    stream.setTimeout(CALIBRATION_RECEIVE_TIMEOUT_MS);
+
+    // The header says how much follows; a blob of another shape is drained and rejected
+    size_t got = stream.readBytes(blob, sizeof(calib::BlobHeader));
+    if (got != sizeof(calib::BlobHeader)) {
+        Serial.println("Calibration receive timed out");
+        return false;
+    }
+    calib::BlobHeader header;
+    memcpy(&header, blob, sizeof(header));
+    size_t len = sizeof(header) + (size_t)header.sensor_count * header.knot_count * sizeof(int16_t);
+    if (header.magic != CALIBRATION_MAGIC || len != sizeof(blob)) {
+        while (stream.available() > 0) {
+            stream.read();
+        }
+        Serial.print("Calibration rejected: ");
+        Serial.println(header.magic != CALIBRATION_MAGIC ? "not a calibration blob"
+                                                         : "table shape does not match this firmware");
+        return false;
+    }
+    got += stream.readBytes(blob + got, len - got);
+    if (got != len) {
+        Serial.println("Calibration receive timed out");
+        return false;
+    }
+    return calibrationTableInstall(blob, len);
+}
+
+void calibrationTableClear() {
+    uint8_t next = current ^ 1;
+    loadDefaults(next);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    current = next;
+    deviceId = 0;
+    fromBlob = false;
+
+    Preferences prefs;
+    if (prefs.begin(CALIBRATION_NVS_NAMESPACE, false)) {
+        prefs.remove(CALIBRATION_NVS_KEY);
+        prefs.end();
+    }
+}
+
+float calibrationAngle(uint8_t i, uint32_t readingQ4) {
+    uint8_t set = current;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return calib::lookupQ4(tables[set][i], readingQ4) / CALIBRATION_ANGLE_SCALE;
+}
+
+void printCalibrationTable() {
+    if (fromBlob) {
+        Serial.print("Calibration tables for device ");
+        Serial.println(deviceId);
+    } else {
+        Serial.println("Calibration tables: default quadratics");
+    }
+    uint8_t set = current;
+    for (uint8_t i = 0; i < CALIBRATION_SENSOR_COUNT; i++) {
+        Serial.print("Sensor ");
+        Serial.print(i);
+        Serial.print(": ");
+        Serial.print(tables[set][i][0] / CALIBRATION_ANGLE_SCALE, 1);
+        Serial.print(" .. ");
+        Serial.println(tables[set][i][CALIBRATION_KNOT_COUNT - 1] / CALIBRATION_ANGLE_SCALE, 1);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef CALIBRATION_TABLE_H
+#define CALIBRATION_TABLE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "CalibrationBlob.h"
+
+// Reading-to-angle tables for the Hall sensors. A blob fitted on the host
+// (host/tools/calib_fit) is kept in NVS and survives reboots; without one the
+// tables hold the default quadratics. Either way a conversion is two table
+// reads and an integer interpolation instead of a double-precision poly().
+
+#define CALIBRATION_NVS_NAMESPACE "calib"
+#define CALIBRATION_NVS_KEY "tables"
+#define CALIBRATION_RECEIVE_TIMEOUT_MS 2000
+
+/**
+ * Loads the stored blob, or the default tables if there is none or it does
+ * not validate.
+ * @return true if a stored blob is in use
+ */
+bool calibrationTableSetup();
+
+/**
+ * Validates a blob, makes it current and stores it in NVS. The sampler keeps
+ * converting with the old tables until the new ones are complete.
+ * @return false if the blob was rejected; the current tables stay
+ */
+bool calibrationTableInstall(const uint8_t* blob, size_t len);
+
+/**
+ * Reads one blob from a stream, e.g. Serial right after the 'c' command, and
+ * installs it.
+ */
+bool calibrationTableReceive(Stream& stream);
+
+/**
+ * Erases the stored blob and goes back to the default tables.
+ */
+void calibrationTableClear();
+
+/**
+ * Angle of sensor i for a reading in 1/16 counts, in proto_angles units.
+ */
+float calibrationAngle(uint8_t i, uint32_t readingQ4);
+
+/**
+ * Prints where the tables came from and each sensor's angles at both ends of the
+ * reading range over Serial
+ */
+void printCalibrationTable();
+
+#endif
@@ -0,0 +1,268 @@
+#include "Crosstalk.h"
+#include "DeferredLog.h"
+#include <Preferences.h>
+
+int16_t crosstalkCorrection[SENSOR_COUNT][CROSSTALK_MAX_BLOCK];
+
+static const uint8_t blockFirst[CROSSTALK_BLOCK_COUNT] = {0, 4, 7, 10, 13};
+static const uint8_t blockSize[CROSSTALK_BLOCK_COUNT] = {4, 3, 3, 3, 3};
+
+// Used when NVS holds no capture. Paste the output of printCrosstalkCorrection()
+// here to give every glove built from this firmware the same default. All
+// zero: no correction.
+static const int16_t defaultCorrection[SENSOR_COUNT][CROSSTALK_MAX_BLOCK] = {};
+
+enum CapturePhase {
+    CAPTURE_IDLE = 0,
+    CAPTURE_SETTLE = 1,     // Prompt logged, waiting for the user
+    CAPTURE_MOVE = 2        // Recording the moving joint
+};
+
+static volatile bool captureRequested = false;
+static volatile bool correctionUnsaved = false;
+static volatile bool clearRequested = false;
+static CapturePhase phase = CAPTURE_IDLE;
+static uint8_t moving = 0;                          // Sensor whose joint is being moved
+static uint16_t frames = 0;
+static int32_t originQ4[CROSSTALK_MAX_BLOCK];       // First recorded reading, keeps the sums small
+static int64_t sums[CROSSTALK_MAX_BLOCK];           // Sum of x_k
+static int64_t products[CROSSTALK_MAX_BLOCK];       // Sum of x_k * x_moving
+static float leaks[SENSOR_COUNT][CROSSTALK_MAX_BLOCK];  // M - I of the capture
+
+static uint8_t blockOf(uint8_t channel) {
+    return channel < 4 ? 0 : (channel - 4) / 3 + 1;
+}
+
+static bool loadCorrection() {
+    Preferences prefs;
+    if (!prefs.begin(CROSSTALK_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    bool loaded = prefs.getBytesLength(CROSSTALK_NVS_KEY) == sizeof(crosstalkCorrection) &&
+                  prefs.getBytes(CROSSTALK_NVS_KEY, crosstalkCorrection, sizeof(crosstalkCorrection)) ==
+                      sizeof(crosstalkCorrection);
+    prefs.end();
+    return loaded;
+}
+
+void crosstalkReset() {
+    if (!loadCorrection()) {
+        memcpy(crosstalkCorrection, defaultCorrection, sizeof(crosstalkCorrection));
+    }
+    captureRequested = false;
+    correctionUnsaved = false;
+    clearRequested = false;
+    phase = CAPTURE_IDLE;
+}
+
+void crosstalkDecouple(uint8_t block, const uint32_t inQ4[SENSOR_COUNT], uint32_t outQ4[SENSOR_COUNT]) {
+    uint8_t first = blockFirst[block];
+    uint8_t n = blockSize[block];
+
+    int32_t centered[CROSSTALK_MAX_BLOCK];
+    for (uint8_t j = 0; j < n; j++) {
+        centered[j] = (int32_t)inQ4[first + j] - CROSSTALK_NULL_Q4;
+    }
+    for (uint8_t k = 0; k < n; k++) {
+        // |centered| <= 2^15 and |correction| < 2^15, so each product fits
+        const int16_t* row = crosstalkCorrection[first + k];
+        int32_t value = centered[k] + CROSSTALK_NULL_Q4;
+        for (uint8_t j = 0; j < n; j++) {
+            value += ((int32_t)row[j] * centered[j] + (1 << 14)) >> 15;
+        }
+        outQ4[first + k] = constrain(value, 0, 4095 << 4);
+    }
+}
+
+void crosstalkStartCapture() {
+    captureRequested = true;
+}
+
+bool crosstalkCapturing() {
+    return captureRequested || phase != CAPTURE_IDLE;
+}
+
+// Leak of the moved sensor into each neighbor: cov(x_k, x_moving) / var(x_moving)
+static void finishJoint() {
+    uint8_t first = blockFirst[blockOf(moving)];
+    uint8_t n = blockSize[blockOf(moving)];
+    uint8_t j = moving - first;
+
+    double meanJ = (double)sums[j] / frames;
+    double varJ = (double)products[j] / frames - meanJ * meanJ;
+    bool moved = varJ >= (double)(CROSSTALK_MIN_SWING * 16) * (CROSSTALK_MIN_SWING * 16);
+    if (!moved) {
+        LOG(LOG_CROSSTALK_WEAK, moving);
+    }
+    for (uint8_t k = 0; k < n; k++) {
+        float leak = 0;
+        if (moved && k != j) {
+            double meanK = (double)sums[k] / frames;
+            leak = ((double)products[k] / frames - meanK * meanJ) / varJ;
+        }
+        leaks[first + k][j] = constrain(leak, -CROSSTALK_MAX_LEAK, CROSSTALK_MAX_LEAK);
+    }
+}
+
+// Gauss-Jordan with partial pivoting, in place on a copy
+static bool invertBlock(const float m[CROSSTALK_MAX_BLOCK][CROSSTALK_MAX_BLOCK], uint8_t n,
+                        float inverse[CROSSTALK_MAX_BLOCK][CROSSTALK_MAX_BLOCK]) {
+    float a[CROSSTALK_MAX_BLOCK][CROSSTALK_MAX_BLOCK];
+    for (uint8_t r = 0; r < n; r++) {
+        for (uint8_t c = 0; c < n; c++) {
+            a[r][c] = m[r][c];
+            inverse[r][c] = r == c ? 1.0f : 0.0f;
+        }
+    }
+    for (uint8_t c = 0; c < n; c++) {
+        uint8_t pivot = c;
+        for (uint8_t r = c + 1; r < n; r++) {
+            if (fabsf(a[r][c]) > fabsf(a[pivot][c])) pivot = r;
+        }
+        if (fabsf(a[pivot][c]) < 1e-3f) {
+            return false;
+        }
+        for (uint8_t k = 0; k < n; k++) {
+            float t = a[c][k]; a[c][k] = a[pivot][k]; a[pivot][k] = t;
+            t = inverse[c][k]; inverse[c][k] = inverse[pivot][k]; inverse[pivot][k] = t;
+        }
+        float scale = 1.0f / a[c][c];
+        for (uint8_t k = 0; k < n; k++) {
+            a[c][k] *= scale;
+            inverse[c][k] *= scale;
+        }
+        for (uint8_t r = 0; r < n; r++) {
+            if (r == c) continue;
+            float f = a[r][c];
+            for (uint8_t k = 0; k < n; k++) {
+                a[r][k] -= f * a[c][k];
+                inverse[r][k] -= f * inverse[c][k];
+            }
+        }
+    }
+    return true;
+}
+
+static void applyCapture() {
+    float largest = 0;
+    for (uint8_t b = 0; b < CROSSTALK_BLOCK_COUNT; b++) {
+        uint8_t first = blockFirst[b];
+        uint8_t n = blockSize[b];
+        float m[CROSSTALK_MAX_BLOCK][CROSSTALK_MAX_BLOCK];
+        float inverse[CROSSTALK_MAX_BLOCK][CROSSTALK_MAX_BLOCK];
+        for (uint8_t k = 0; k < n; k++) {
+            for (uint8_t j = 0; j < n; j++) {
+                m[k][j] = (k == j ? 1.0f : 0.0f) + leaks[first + k][j];
+                if (fabsf(leaks[first + k][j]) > largest) largest = fabsf(leaks[first + k][j]);
+            }
+        }
+        if (!invertBlock(m, n, inverse)) {
+            LOG(LOG_CROSSTALK_SINGULAR, b);
+            continue;
+        }
+        for (uint8_t k = 0; k < n; k++) {
+            for (uint8_t j = 0; j < n; j++) {
+                float q = (inverse[k][j] - (k == j ? 1.0f : 0.0f)) * 32768.0f;
+                crosstalkCorrection[first + k][j] = (int16_t)constrain(lroundf(q), -32767L, 32767L);
+            }
+        }
+    }
+    LOG(LOG_CROSSTALK_DONE, largest);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    correctionUnsaved = true;
+}
+
+static void promptJoint() {
+    phase = CAPTURE_SETTLE;
+    frames = 0;
+    LOG(LOG_CROSSTALK_MOVE, moving, CROSSTALK_CAPTURE_FRAMES / 200);
+}
+
+void crosstalkEndFrame(const uint32_t valuesQ4[SENSOR_COUNT]) {
+    if (clearRequested) {
+        // Swapped between frames so no finger is decoupled with a torn table
+        memcpy(crosstalkCorrection, defaultCorrection, sizeof(crosstalkCorrection));
+        clearRequested = false;
+    }
+    if (captureRequested) {
+        captureRequested = false;
+        memset(leaks, 0, sizeof(leaks));
+        moving = 0;
+        promptJoint();
+    }
+    if (phase == CAPTURE_IDLE) {
+        return;
+    }
+
+    uint8_t first = blockFirst[blockOf(moving)];
+    uint8_t n = blockSize[blockOf(moving)];
+    if (phase == CAPTURE_SETTLE) {
+        if (++frames >= CROSSTALK_SETTLE_FRAMES) {
+            phase = CAPTURE_MOVE;
+            frames = 0;
+            for (uint8_t k = 0; k < n; k++) {
+                originQ4[k] = valuesQ4[first + k];
+                sums[k] = 0;
+                products[k] = 0;
+            }
+        }
+        return;
+    }
+
+    int32_t x = (int32_t)valuesQ4[moving] - originQ4[moving - first];
+    for (uint8_t k = 0; k < n; k++) {
+        int32_t xk = (int32_t)valuesQ4[first + k] - originQ4[k];
+        sums[k] += xk;
+        products[k] += (int64_t)xk * x;
+    }
+    if (++frames < CROSSTALK_CAPTURE_FRAMES) {
+        return;
+    }
+
+    finishJoint();
+    if (++moving < SENSOR_COUNT) {
+        promptJoint();
+    } else {
+        applyCapture();
+        phase = CAPTURE_IDLE;
+    }
+}
+
+void crosstalkService() {
+    if (!correctionUnsaved) {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    correctionUnsaved = false;
+
+    int16_t stored[SENSOR_COUNT][CROSSTALK_MAX_BLOCK];
+    memcpy(stored, crosstalkCorrection, sizeof(stored));
+    Preferences prefs;
+    if (!prefs.begin(CROSSTALK_NVS_NAMESPACE, false) ||
+        prefs.putBytes(CROSSTALK_NVS_KEY, stored, sizeof(stored)) != sizeof(stored)) {
+        Serial.println("Crosstalk correction active but could not be stored");
+    }
+    prefs.end();
+}
+
+void crosstalkClear() {
+    Preferences prefs;
+    if (prefs.begin(CROSSTALK_NVS_NAMESPACE, false)) {
+        prefs.remove(CROSSTALK_NVS_KEY);
+        prefs.end();
+    }
+    clearRequested = true;
+}
+
+void printCrosstalkCorrection() {
+    Serial.println("Crosstalk correction (Q15, M^-1 - I per finger):");
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        Serial.print("    {");
+        for (uint8_t j = 0; j < CROSSTALK_MAX_BLOCK; j++) {
+            Serial.print(crosstalkCorrection[i][j]);
+            Serial.print(j + 1 < CROSSTALK_MAX_BLOCK ? ", " : "");
+        }
+        Serial.print("},  // sensor ");
+        Serial.println(i);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef CROSSTALK_H
+#define CROSSTALK_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define SENSOR_COUNT 16
+
+// Magnetic crosstalk between the Hall sensors of one finger. The abduction
+// and flexion sensors sit a few millimeters apart, so each one also sees part
+// of its neighbors' magnets and flexing a finger reads as phantom abduction.
+// Around the zero-field output every reading is a mix of the fields
+//
+//   raw - null = M * (field - null),   M = I + leaks
+//
+// and the decoupled reading is null + M^-1 * (raw - null). The blocks are the
+// fingers (thumb 0-3, then three sensors per finger, as in FingerTracking);
+// sensors of different fingers are too far apart to leak into each other.
+//
+// M^-1 - I is stored per sensor over its block in Q15, so a glove without a
+// capture (all zero) reads exactly as before. The kernel is a few integer
+// multiply-adds per sensor.
+//
+// crosstalkStartCapture() estimates M from guided motions: every joint in
+// turn is moved through its range with the rest of the hand still, and the
+// leak into each neighbor is the regression of its reading on the moved one.
+// The result is kept in NVS and survives reboots.
+
+#define CROSSTALK_BLOCK_COUNT 5         // One block per finger
+#define CROSSTALK_MAX_BLOCK 4           // Sensors of the largest block, the thumb
+#define CROSSTALK_NULL_Q4 (2048 << 4)   // Zero-field output of the ratiometric sensors, 1/16 counts
+#define CROSSTALK_SETTLE_FRAMES 300     // Frames (1.5 s at 200 Hz) to read a prompt before recording
+#define CROSSTALK_CAPTURE_FRAMES 800    // Frames (4 s at 200 Hz) of motion recorded per joint
+#define CROSSTALK_MIN_SWING 40          // Counts standard deviation a moved joint needs to be used
+#define CROSSTALK_MAX_LEAK 0.5f         // Largest leak accepted between two sensors
+#define CROSSTALK_NVS_NAMESPACE "xtalk"
+#define CROSSTALK_NVS_KEY "correction"
+
+// Correction M^-1 - I, Q15. Row i is sensor i, column j the j-th sensor of its block.
+extern int16_t crosstalkCorrection[SENSOR_COUNT][CROSSTALK_MAX_BLOCK];
+
+/**
+ * Loads the correction stored in NVS, or the default one without it, and
+ * stops any capture.
+ */
+void crosstalkReset();
+
+/**
+ * Decouples the sensors of one block.
+ * @param block Finger, 0 thumb .. 4 pinky
+ * @param inQ4 Readings of all sensors in 1/16 counts; only the block's are read
+ * @param outQ4 Decoupled readings; only the block's are written. May be inQ4.
+ */
+void crosstalkDecouple(uint8_t block, const uint32_t inQ4[SENSOR_COUNT], uint32_t outQ4[SENSOR_COUNT]);
+
+/**
+ * Starts a guided capture on the next frame. Prompts for each joint are
+ * logged; the new correction replaces the old one when the last joint is done
+ * and is stored by crosstalkService(). Callable from any task.
+ */
+void crosstalkStartCapture();
+
+bool crosstalkCapturing();
+
+/**
+ * Feeds one frame of readings, before decoupling, to a running capture.
+ * Called once per frame after every sensor has been read.
+ */
+void crosstalkEndFrame(const uint32_t valuesQ4[SENSOR_COUNT]);
+
+/**
+ * Stores a newly captured correction in NVS. Call from loop(), not from the
+ * sampler: a flash write stalls for milliseconds.
+ */
+void crosstalkService();
+
+/**
+ * Drops the stored correction; the sampler goes back to the default one on
+ * its next frame. Callable from any task.
+ */
+void crosstalkClear();
+
+/**
+ * Prints the correction as a C initializer, ready to become the default
+ */
+void printCrosstalkCorrection();
+
+#endif
@@ -0,0 +1,121 @@
+#include "DeferredLog.h"
+
+// Bounded multi-producer multi-consumer queue (Vyukov). Every slot carries a
+// sequence number: a producer owns slot i once it advances enqueuePos from
+// pos, writes the record, then publishes it by setting seq to pos + 1. A
+// consumer that meets a slot still being written simply reports the ring as
+// empty for now, so neither side ever waits on the other.
+//
+// seq is stored relative to the slot index so the zero-initialized ring is
+// already valid and records can be logged before deferredLogSetup().
+struct LogSlot {
+    uint32_t seq;
+    LogRecord record;
+};
+
+static LogSlot slots[LOG_RING_SIZE];
+static uint32_t enqueuePos = 0;
+static uint32_t dequeuePos = 0;
+static uint32_t droppedRecords = 0;
+static uint32_t reportedDrops = 0;
+static TaskHandle_t drainTask = nullptr;
+static StackType_t drainStack[LOG_DRAIN_TASK_STACK];
+static StaticTask_t drainTaskBuffer;
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+
+bool IRAM_ATTR logPush(LogFormatId id, const uint32_t* args, uint8_t count) {
+    uint32_t pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    uint32_t index;
+    while (true) {
+        index = pos & (LOG_RING_SIZE - 1);
+        uint32_t seq = __atomic_load_n(&slots[index].seq, __ATOMIC_ACQUIRE) + index;
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&droppedRecords, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+
+    LogRecord& record = slots[index].record;
+    record.magic = LOG_RECORD_MAGIC;
+    record.format = id;
+    record.timestamp_us = micros();
+    for (uint8_t i = 0; i < LOG_MAX_ARGS; i++) {
+        record.args[i] = i < count ? args[i] : 0;
+    }
+    __atomic_store_n(&slots[index].seq, pos + 1 - index, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool logPop(LogRecord* record) {
+    uint32_t pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+    uint32_t index;
+    while (true) {
+        index = pos & (LOG_RING_SIZE - 1);
+        uint32_t seq = __atomic_load_n(&slots[index].seq, __ATOMIC_ACQUIRE) + index;
+        int32_t diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&dequeuePos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+        }
+    }
+
+    *record = slots[index].record;
+    __atomic_store_n(&slots[index].seq, pos + LOG_RING_SIZE - index, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t logDroppedCount() {
+    return __atomic_load_n(&droppedRecords, __ATOMIC_RELAXED);
+}
+
+static void emitRecord(const LogRecord& record) {
+#ifdef DEFERRED_LOG_BINARY
+    Serial.write((const uint8_t*)&record, sizeof(record));
+#else
+    char line[128];
+    logFormatRecord(record, line, sizeof(line));
+    Serial.println(line);
+#endif
+}
+
+void deferredLogFlush(uint16_t max_records) {
+    // Report drops in-band, from the consumer side so it cannot itself overflow
+    uint32_t dropped = logDroppedCount();
+    if (dropped != reportedDrops) {
+        LogRecord record = {LOG_RECORD_MAGIC, LOG_DROPPED, (uint32_t)micros(), {dropped - reportedDrops, 0, 0, 0}};
+        emitRecord(record);
+        reportedDrops = dropped;
+    }
+
+    LogRecord record;
+    for (uint16_t i = 0; i < max_records && logPop(&record); i++) {
+        emitRecord(record);
+    }
+}
+
+static void drainLoop(void* arg) {
+    while (true) {
+        deferredLogFlush();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+    }
+}
+
+void deferredLogSetup() {
+    if (drainTask == nullptr) {
+        drainTask = xTaskCreateStatic(drainLoop, "log_drain", LOG_DRAIN_TASK_STACK, nullptr, LOG_DRAIN_TASK_PRIORITY,
+                                      drainStack, &drainTaskBuffer);
+    }
+}
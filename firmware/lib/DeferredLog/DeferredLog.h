@@ -0,0 +1,71 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "LogRecord.h"
+
+// Records above this level are removed at compile time, arguments included.
+// Override with -DLOG_LEVEL=LOG_LEVEL_DEBUG in platformio.ini.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SIZE 64                // Records, power of two
+#define LOG_DRAIN_PERIOD_MS 20
+#define LOG_DRAIN_TASK_PRIORITY 1       // Just above idle
+#define LOG_DRAIN_TASK_STACK 3072
+
+// Define DEFERRED_LOG_BINARY to send raw LogRecords over Serial instead of
+// text; decode them on the host with host/tools/logdecode.
+
+/**
+ * Logs a record from the format table in LogFormats.def, e.g.
+ *   LOG(LOG_BUTTON_PRESSED, i + 1, distance, threshold);
+ * Takes a few hundred nanoseconds and never blocks, so it is safe in the
+ * sampling path and in ISRs. When the ring is full the record is dropped
+ * and counted.
+ */
+#define LOG(id, ...)                                                    \
+    do {                                                                \
+        if (logFormatLevels[id] <= LOG_LEVEL) {                         \
+            logWrite(id, ##__VA_ARGS__);                                \
+        }                                                               \
+    } while (0)
+
+/**
+ * Appends one record to the ring. Lock-free; callable from any task or ISR.
+ * @return false if the ring was full
+ */
+bool logPush(LogFormatId id, const uint32_t* args, uint8_t count);
+
+/**
+ * Removes the oldest record from the ring.
+ * @return false if the ring is empty
+ */
+bool logPop(LogRecord* record);
+
+/**
+ * Records dropped because the ring was full, since startup.
+ */
+uint32_t logDroppedCount();
+
+/**
+ * Starts the low-priority task that drains the ring to Serial.
+ */
+void deferredLogSetup();
+
+/**
+ * Drains up to max_records records to Serial from the calling task. For use
+ * when the drain task is not running, e.g. before a deliberate halt.
+ */
+void deferredLogFlush(uint16_t max_records = LOG_RING_SIZE);
+
+template <typename... Args>
+inline bool logWrite(LogFormatId id, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    uint32_t words[sizeof...(Args) + 1] = {logArg(args)...};
+    return logPush(id, words, sizeof...(Args));
+}
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+
+// Binary log record and format table. No Arduino dependencies so the host
+// decoder includes this header as is.
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#define LOG_MAX_ARGS 4
+#define LOG_RECORD_MAGIC 0x4C47     // "GL" in the first two bytes
+
+enum LogFormatId : uint16_t {
+#define LOG_FORMAT(id, level, fmt) id,
+#include "LogFormats.def"
+#undef LOG_FORMAT
+    LOG_FORMAT_COUNT
+};
+
+static constexpr uint8_t logFormatLevels[] = {
+#define LOG_FORMAT(id, level, fmt) level,
+#include "LogFormats.def"
+#undef LOG_FORMAT
+};
+
+static constexpr const char* logFormatStrings[] = {
+#define LOG_FORMAT(id, level, fmt) fmt,
+#include "LogFormats.def"
+#undef LOG_FORMAT
+};
+
+struct LogRecord {
+    uint16_t magic;         // LOG_RECORD_MAGIC
+    uint16_t format;        // LogFormatId
+    uint32_t timestamp_us;  // micros() when the record was written
+    uint32_t args[LOG_MAX_ARGS];
+};
+static_assert(sizeof(LogRecord) == 24, "LogRecord layout is part of the wire format");
+
+/**
+ * Packs one argument into a 32-bit record word. Floats keep their bit pattern.
+ */
+template <typename T>
+inline uint32_t logArg(T v) {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Log arguments must be integers or floats");
+    return (uint32_t)v;
+}
+inline uint32_t logArg(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+inline uint32_t logArg(double v) { return logArg((float)v); }
+
+/**
+ * Renders a record as text using its format string.
+ * @return Characters written, excluding the terminator
+ */
+inline size_t logFormatRecord(const LogRecord& record, char* out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    if (record.format >= LOG_FORMAT_COUNT) {
+        return snprintf(out, size, "<unknown log format %u>", record.format);
+    }
+
+    const char* f = logFormatStrings[record.format];
+    size_t n = 0;
+    uint8_t arg = 0;
+    while (*f && n + 1 < size) {
+        if (*f != '%') {
+            out[n++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[n++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy one conversion spec, e.g. "%-6.2f"
+        char spec[16];
+        size_t len = 0;
+        spec[len++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && len < sizeof(spec) - 2) {
+            spec[len++] = *f++;
+        }
+        char conversion = *f ? *f++ : 'u';
+        spec[len++] = conversion;
+        spec[len] = '\0';
+
+        uint32_t word = arg < LOG_MAX_ARGS ? record.args[arg] : 0;
+        arg++;
+        int written;
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                written = snprintf(out + n, size - n, spec, (int)(int32_t)word);
+                break;
+            case 'f':
+            case 'e':
+            case 'g': {
+                float v;
+                memcpy(&v, &word, sizeof(v));
+                written = snprintf(out + n, size - n, spec, (double)v);
+                break;
+            }
+            default:
+                written = snprintf(out + n, size - n, spec, (unsigned)word);
+                break;
+        }
+        if (written < 0) {
+            break;
+        }
+        n += (size_t)written < size - n ? (size_t)written : size - n - 1;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+#endif
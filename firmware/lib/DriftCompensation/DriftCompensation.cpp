@@ -0,0 +1,274 @@
+#include "DriftCompensation.h"
+
+#include <math.h>
+#include <Preferences.h>
+
+DriftChannel driftChannels[SENSOR_COUNT];
+
+struct ChannelTrack {
+    int32_t averageQ4;      // EWMA of the raw reading
+    uint32_t deviationQ4;   // EWMA of |reading - average|
+    uint32_t sumQ4;         // Readings of the current still run
+    bool primed;
+};
+
+// Exponentially forgotten sums. d is a rest reading minus the reference and
+// x = dT * (reference - null), so d = k * x + offset. Creep moves the offset
+// between rests far less than temperature moves k * x, so k comes from the
+// steps between consecutive rests, where the offset cancels, over a long
+// memory; the offset then follows d - k * x with a short one.
+struct ChannelFit {
+    float lastX, lastD;     // Previous rest
+    float stepXX, stepXD;   // Slow, steps between rests
+    float n, residual;      // Fast, offset
+};
+
+static ChannelTrack track[SENSOR_COUNT];
+static ChannelFit fits[SENSOR_COUNT];
+static float invGain[SENSOR_COUNT];
+static float offsetQ4[SENSOR_COUNT];
+
+// What NVS keeps of a reference
+struct StoredReference {
+    float counts[SENSOR_COUNT];
+    float temp;
+};
+
+static float referenceCounts[SENSOR_COUNT];
+static float referenceTemp = NAN;
+static bool haveReference = false;
+static volatile bool captureRequested = false;
+static volatile bool referenceUnsaved = false;
+static volatile float temperature = NAN;
+
+static uint16_t stillFrames = 0;
+static float restCounts[SENSOR_COUNT];     // Observation waiting to be fitted
+static float restTemp = NAN;
+static uint16_t pendingMask = 0;
+static uint8_t gainChannel = 0;
+
+static void clearEstimates() {
+    memset(fits, 0, sizeof(fits));
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        driftChannels[i].offset = 0;
+        driftChannels[i].tempco = 0;
+        driftChannels[i].observations = 0;
+        invGain[i] = 1.0f;
+        offsetQ4[i] = 0;
+    }
+    pendingMask = 0;
+}
+
+static bool loadReference() {
+    Preferences prefs;
+    if (!prefs.begin(DRIFT_NVS_NAMESPACE, true)) {
+        return false;
+    }
+    StoredReference stored;
+    bool loaded = prefs.getBytesLength(DRIFT_NVS_KEY) == sizeof(stored) &&
+                  prefs.getBytes(DRIFT_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+    for (uint8_t i = 0; loaded && i < SENSOR_COUNT; i++) {
+        loaded = stored.counts[i] >= 0 && stored.counts[i] <= 4095;
+    }
+    if (loaded) {
+        memcpy(referenceCounts, stored.counts, sizeof(referenceCounts));
+        referenceTemp = stored.temp;
+    }
+    return loaded;
+}
+
+void driftCompensationReset() {
+    memset(track, 0, sizeof(track));
+    clearEstimates();
+    captureRequested = false;
+    referenceUnsaved = false;
+    stillFrames = 0;
+    haveReference = loadReference();
+}
+
+void driftCaptureReference() {
+    captureRequested = true;
+}
+
+bool driftHasReference() {
+    return haveReference;
+}
+
+void driftSetTemperature(float celsius) {
+    temperature = celsius;
+}
+
+uint32_t driftCompensate(uint8_t channel, uint32_t rawQ4) {
+    if (channel >= SENSOR_COUNT) {
+        return rawQ4;
+    }
+
+    // Stillness from the raw reading; the correction does not change it
+    ChannelTrack& t = track[channel];
+    if (!t.primed) {
+        t.averageQ4 = rawQ4;
+        t.deviationQ4 = DRIFT_STILL_Q4;
+        t.primed = true;
+    }
+    int32_t error = (int32_t)rawQ4 - t.averageQ4;
+    t.averageQ4 += error >> 3;
+    t.deviationQ4 += ((int32_t)abs(error) - (int32_t)t.deviationQ4) >> 3;
+    t.sumQ4 += rawQ4;
+
+    if (!haveReference) {
+        return rawQ4;
+    }
+    float corrected = DRIFT_NULL_Q4 + ((float)rawQ4 - offsetQ4[channel] - DRIFT_NULL_Q4) * invGain[channel];
+    if (corrected < 0) corrected = 0;
+    if (corrected > (4095 << 4)) corrected = 4095 << 4;
+    return (uint32_t)(corrected + 0.5f);
+}
+
+static bool haveTemperature(float celsius) {
+    return !isnan(celsius) && !isnan(referenceTemp);
+}
+
+// Folds the pending rest observation of one channel into its fit
+static void fitChannel(uint8_t i) {
+    float reference = referenceCounts[i];
+    float dT = haveTemperature(restTemp) ? restTemp - referenceTemp : 0;
+    float x = dT * (reference - DRIFT_NULL_Q4 / 16.0f);
+    float d = restCounts[i] - reference;
+
+    ChannelFit& f = fits[i];
+    DriftChannel& c = driftChannels[i];
+    if (c.observations > 0) {
+        float stepX = x - f.lastX;
+        float stepD = d - f.lastD;
+        f.stepXX = f.stepXX * DRIFT_TEMPCO_FORGET + stepX * stepX;
+        f.stepXD = f.stepXD * DRIFT_TEMPCO_FORGET + stepX * stepD;
+        // Temperature steps only reveal the gain of a channel that rests away
+        // from the null; near it k stays unfitted rather than fitted to noise
+        if (f.stepXX >= DRIFT_MIN_LEVER * DRIFT_MIN_LEVER) {
+            c.tempco = constrain(f.stepXD / f.stepXX, -DRIFT_MAX_TEMPCO, DRIFT_MAX_TEMPCO);
+        }
+    }
+    f.lastX = x;
+    f.lastD = d;
+
+    f.n = f.n * DRIFT_OFFSET_FORGET + 1;
+    f.residual = f.residual * DRIFT_OFFSET_FORGET + (d - c.tempco * x);
+    c.offset = f.residual / f.n;
+    c.observations++;
+    offsetQ4[i] = c.offset * 16;
+}
+
+// Gain for the current temperature; one channel per frame is plenty for a
+// temperature that changes over minutes
+static void refreshGain(uint8_t i) {
+    float celsius = temperature;
+    float gain = haveTemperature(celsius) ? 1.0f + driftChannels[i].tempco * (celsius - referenceTemp) : 1.0f;
+    invGain[i] = 1.0f / gain;
+}
+
+// Prediction of the reference pose's readings under the current correction
+static bool nearReference(const float counts[SENSOR_COUNT]) {
+    float celsius = temperature;
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        float null = DRIFT_NULL_Q4 / 16.0f;
+        float gain = haveTemperature(celsius) ? 1.0f + driftChannels[i].tempco * (celsius - referenceTemp) : 1.0f;
+        float predicted = null + gain * (referenceCounts[i] - null) + driftChannels[i].offset;
+        if (fabsf(counts[i] - predicted) * 16 > DRIFT_REST_WINDOW_Q4) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void driftEndFrame() {
+    bool still = true;
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (track[i].deviationQ4 >= DRIFT_STILL_Q4) {
+            still = false;
+            break;
+        }
+    }
+
+    if (!still) {
+        stillFrames = 0;
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) track[i].sumQ4 = 0;
+    } else if (++stillFrames >= DRIFT_REST_FRAMES) {
+        float counts[SENSOR_COUNT];
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            counts[i] = track[i].sumQ4 / (16.0f * stillFrames);
+            track[i].sumQ4 = 0;
+        }
+        stillFrames = 0;
+
+        if (captureRequested) {
+            memcpy(referenceCounts, counts, sizeof(referenceCounts));
+            referenceTemp = temperature;
+            clearEstimates();
+            haveReference = true;
+            captureRequested = false;
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            referenceUnsaved = true;
+        } else if (haveReference && pendingMask == 0 && nearReference(counts)) {
+            memcpy(restCounts, counts, sizeof(restCounts));
+            restTemp = temperature;
+            pendingMask = (1 << SENSOR_COUNT) - 1;
+        }
+    }
+
+    for (uint8_t n = 0; n < DRIFT_CHANNELS_PER_FRAME && pendingMask != 0; n++) {
+        uint8_t i = __builtin_ctz(pendingMask);
+        fitChannel(i);
+        pendingMask &= ~(1 << i);
+    }
+    if (haveReference) {
+        refreshGain(gainChannel);
+        gainChannel = (gainChannel + 1) % SENSOR_COUNT;
+    }
+}
+
+void driftCompensationService() {
+    if (!referenceUnsaved) {
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    referenceUnsaved = false;
+
+    StoredReference stored;
+    memcpy(stored.counts, referenceCounts, sizeof(stored.counts));
+    stored.temp = referenceTemp;
+    Preferences prefs;
+    if (!prefs.begin(DRIFT_NVS_NAMESPACE, false) ||
+        prefs.putBytes(DRIFT_NVS_KEY, &stored, sizeof(stored)) != sizeof(stored)) {
+        Serial.println("Drift reference active but could not be stored");
+    }
+    prefs.end();
+}
+
+void printDriftCompensation() {
+    if (!haveReference) {
+        Serial.println(captureRequested ? "Drift compensation: waiting for the hand to rest open"
+                                        : "Drift compensation: off, no reference ('r' with the hand open and still)");
+        return;
+    }
+    Serial.print("Drift compensation, reference at ");
+    if (isnan(referenceTemp)) {
+        Serial.println("unknown temperature");
+    } else {
+        Serial.print(referenceTemp, 1);
+        Serial.println(" C");
+    }
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        Serial.print("Sensor ");
+        Serial.print(i);
+        Serial.print(": reference ");
+        Serial.print(referenceCounts[i], 1);
+        Serial.print(" offset ");
+        Serial.print(driftChannels[i].offset, 1);
+        Serial.print(" tempco ");
+        Serial.print(driftChannels[i].tempco * 100, 3);
+        Serial.print(" %/C, ");
+        Serial.print(driftChannels[i].observations);
+        Serial.println(" rests");
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef DRIFT_COMPENSATION_H
+#define DRIFT_COMPENSATION_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define SENSOR_COUNT 16
+
+// Online offset and gain correction for the Hall sensors. The calibration
+// tables are fitted once; afterwards magnets creep and sensor offset and
+// sensitivity change with temperature. The reference rest pose, the hand
+// relaxed and open, is taken on request ('r') and kept in NVS; without one
+// nothing is corrected. Every time the hand rests in that pose again (every
+// channel still and within the expected drift of the reference) the rest
+// readings are compared with the reference and each channel's correction is
+// re-estimated:
+//
+//   raw = null + gain(T) * (true - null) + offset
+//   gain(T) = 1 + k * (T - T_reference)
+//
+// Without a temperature (driftSetTemperature() never called) k stays 0 and
+// only the offset is tracked. With one, k is fitted per channel from rest
+// poses seen at different temperatures and the gain follows the temperature
+// between rests. The BNO085 has no temperature output; built with
+// -DDRIFT_DIE_TEMPERATURE, main.cpp feeds the ESP32-C3 die temperature.
+//
+// The per-channel fit is spread over DRIFT_CHANNELS_PER_FRAME channels per
+// frame, so no frame pays for all sixteen.
+
+#define DRIFT_NULL_Q4 (2048 << 4)       // Zero-field output of the ratiometric sensors, 1/16 counts
+#define DRIFT_STILL_Q4 (6 << 4)         // Mean |reading - average| below this counts as still
+#define DRIFT_REST_FRAMES 100           // Still frames (0.5 s at 200 Hz) that make one rest observation
+#define DRIFT_REST_WINDOW_Q4 (40 << 4)  // Max distance of a rest pose from the predicted reference; any
+                                        // further is a different pose, not drift
+#define DRIFT_CHANNELS_PER_FRAME 2      // Channel fits done per frame after an observation
+#define DRIFT_OFFSET_FORGET 0.9f        // Weight kept by older rests per new one, offset
+#define DRIFT_TEMPCO_FORGET 0.998f      // Same for the temperature coefficient
+#define DRIFT_MIN_LEVER 800.0f          // Root sum of squared x steps (counts * deg C) before k is fitted
+#define DRIFT_MAX_TEMPCO 0.005f         // Largest |k| accepted, per deg C
+#define DRIFT_NVS_NAMESPACE "drift"
+#define DRIFT_NVS_KEY "reference"
+
+struct DriftChannel {
+    float offset;           // Counts
+    float tempco;           // k, per deg C
+    uint32_t observations;
+};
+
+extern DriftChannel driftChannels[SENSOR_COUNT];
+
+/**
+ * Forgets every estimate and loads the reference stored in NVS, if any.
+ */
+void driftCompensationReset();
+
+/**
+ * Takes the next still pose as the reference rest pose, keeping nothing of
+ * the old estimates. Call it with the hand relaxed and open; the reference is
+ * stored by driftCompensationService().
+ */
+void driftCaptureReference();
+
+bool driftHasReference();
+
+/**
+ * Latest sensor temperature in deg C, from any thread. NAN disables the
+ * temperature model.
+ */
+void driftSetTemperature(float celsius);
+
+/**
+ * Corrects one raw reading and feeds it to the rest detector. Called for
+ * every channel of every frame from the scan.
+ * @param rawQ4 Reduced reading in 1/16 counts
+ * @return Corrected reading in 1/16 counts
+ */
+uint32_t driftCompensate(uint8_t channel, uint32_t rawQ4);
+
+/**
+ * Finishes a frame: rest detection and the amortized per-channel fits.
+ */
+void driftEndFrame();
+
+/**
+ * Stores a newly captured reference in NVS. Call from loop(), not from the
+ * sampler: a flash write stalls for milliseconds.
+ */
+void driftCompensationService();
+
+/**
+ * Prints the reference, offset and temperature coefficient of every channel
+ */
+void printDriftCompensation();
+
+#endif
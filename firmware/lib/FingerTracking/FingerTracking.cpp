@@ -4,6 +4,11 @@
 int32_t angles[SENSOR_COUNT];
 bool invertedSensors[SENSOR_COUNT] = {false}; // Default to no sensors inverted
 
+static const uint8_t fingerFirstSensor[FINGER_COUNT] = {0, 4, 7, 10, 13};
+static const uint8_t fingerSensorCount[FINGER_COUNT] = {4, 3, 3, 3, 3};
+static uint8_t pendingSensors[FINGER_COUNT];  // Sensors of each finger not yet processed this frame
+static FingerUpdateCallback fingerUpdateCallback = nullptr;
+
 void fingerTrackingSetup()
 {
 	// Default setup with no inverted sensors
@@ -155,33 +160,40 @@ int32_t adjustThumbPIPFlexionAngle(int32_t i)
 	return adjusted_angle;
 }
 
-void adjustAngles()
+int32_t adjustAngle(uint8_t i)
 {
-	// thumb
-	angles[0] = adjustThumbCMCFlexionAngle(0);
-	angles[1] = adjustThumbCMCAbductionAngle(1);
-	angles[2] = adjustThumbPIPFlexionAngle(2);
-	angles[3] = adjustThumbPIPFlexionAngle(3); // proto_angles[3]; // not using this data currently
+	switch (i)
+	{
+		// thumb
+		case 0: return adjustThumbCMCFlexionAngle(i);
+		case 1: return adjustThumbCMCAbductionAngle(i);
+		case 2: return adjustThumbPIPFlexionAngle(i);
+		case 3: return adjustThumbPIPFlexionAngle(i); // proto_angles[3]; // not using this data currently
 
-	// index
-	angles[4] = adjustMCPAbductionAngle(4);
-	angles[5] = adjustMCPFlexionAngle(5);
-	angles[6] = adjustPIPFlexionAngle(6);
+		// index, middle, ring, pinkie: abduction, MCP flexion, PIP flexion
+		case 4: case 7: case 10: case 13: return adjustMCPAbductionAngle(i);
+		case 5: case 8: case 11: case 14: return adjustMCPFlexionAngle(i);
+		case 6: case 9: case 12: case 15: return adjustPIPFlexionAngle(i);
+	}
+	return 0;
+}
 
-	// middle
-	angles[7] = adjustMCPAbductionAngle(7);
-	angles[8] = adjustMCPFlexionAngle(8);
-	angles[9] = adjustPIPFlexionAngle(9);
+uint8_t fingerOfSensor(uint8_t i)
+{
+	return i < 4 ? 0 : (i - 4) / 3 + 1;
+}
 
-	// ring
-	angles[10] = adjustMCPAbductionAngle(10);
-	angles[11] = adjustMCPFlexionAngle(11);
-	angles[12] = adjustPIPFlexionAngle(12);
+void setFingerUpdateCallback(FingerUpdateCallback callback)
+{
+	fingerUpdateCallback = callback;
+}
 
-	// pinkie
-	angles[13] = adjustMCPAbductionAngle(13);
-	angles[14] = adjustMCPFlexionAngle(14);
-	angles[15] = adjustPIPFlexionAngle(15);
+void adjustAngles()
+{
+	for (uint8_t i = 0; i < SENSOR_COUNT; i++)
+	{
+		angles[i] = adjustAngle(i);
+	}
 
 	// // pinkie
 	// angles[0] = adjustMCPAbductionAngle(0);
@@ -219,9 +231,37 @@ void adjustAngles()
 
 }
 
+// Takes channel i from raw reading to final angle while the next channel settles.
+// Crosstalk is removed per finger, so the angles of a finger wait for its last sensor.
+static void processFingerSensor(uint8_t channel)
+{
+	compensateHallEffectSensor(channel);
+
+	uint8_t finger = fingerOfSensor(channel);
+	pendingSensors[finger] &= ~(1 << (channel - fingerFirstSensor[finger]));
+	if (pendingSensors[finger] != 0)
+	{
+		return;
+	}
+
+	convertHallEffectBlock(finger);
+	for (uint8_t i = fingerFirstSensor[finger]; i < fingerFirstSensor[finger] + fingerSensorCount[finger]; i++)
+	{
+		calibrateHallEffectSensor(i);
+		angles[i] = adjustAngle(i);
+	}
+	if (fingerUpdateCallback != nullptr)
+	{
+		fingerUpdateCallback(finger);
+	}
+}
+
 void calcFingerAngles()
 {
-	measureHallEffectSensors();
-	calibrateHallEffectSensors();
-	adjustAngles();
+	for (uint8_t f = 0; f < FINGER_COUNT; f++)
+	{
+		pendingSensors[f] = (1 << fingerSensorCount[f]) - 1;
+	}
+	scanHallEffectSensors(processFingerSensor);
+	endHallEffectFrame();
 }
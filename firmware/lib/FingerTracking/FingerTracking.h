@@ -6,6 +6,7 @@
 #include <ResponsiveAnalogRead.h>
 
 #define SENSOR_COUNT 16
+#define FINGER_COUNT 5
 
 #define MCP_FLEXION_MIN 0
 #define MCP_FLEXION_MAX 240
@@ -25,6 +26,8 @@
 #define THUMB_PIP_FLEXION_MIN 0
 #define THUMB_PIP_FLEXION_MAX 255
 
+typedef void (*FingerUpdateCallback)(uint8_t finger);
+
 extern int32_t angles[SENSOR_COUNT];
 extern bool invertedSensors[SENSOR_COUNT]; // Array to track which sensors are inverted
 
@@ -48,10 +51,23 @@ void setSensorInverted(uint8_t sensorIndex, bool inverted);
 
 /**
  * Reads the raw angle values, adjusts them, and stores them in the angles array. Calling this function requires
- * initialize() to have already been called.
+ * initialize() to have already been called. Each finger is converted, crosstalk removed, while the channel after its
+ * last sensor settles, so the angles are ready as soon as the last channel has been sampled.
  */
 void calcFingerAngles();
 
+/**
+ * Registers a function called from calcFingerAngles() as soon as every sensor of a finger has a new angle,
+ * for consumers that want partial per-finger updates. Pass nullptr to disable.
+ * @param callback Receives the finger index (0 thumb .. 4 pinky)
+ */
+void setFingerUpdateCallback(FingerUpdateCallback callback);
+
+/**
+ * Returns the finger (0 thumb .. 4 pinky) a sensor belongs to
+ */
+uint8_t fingerOfSensor(uint8_t i);
+
 /**
  * Prints the contents of the angles array over Serial
  */
@@ -60,6 +76,7 @@ void printFingerAngles();
 void printRawAngles();
 
 void adjustAngles();
+int32_t adjustAngle(uint8_t i);
 int32_t adjustMCPAbductionAngle(int32_t i);
 int32_t adjustMCPFlexionAngle(int32_t i);
 int32_t adjustPIPFlexionAngle(int32_t i);
@@ -0,0 +1,361 @@
+#include "FrameCodec.h"
+
+#include <string.h>
+
+namespace codec {
+
+// Channel groups that share a predictor choice and a residual width. Joints
+// are grouped per finger (same split as FingerTracking) since a finger's
+// joints tend to move together.
+struct ChannelGroup {
+    uint8_t first;
+    uint8_t count;
+};
+
+static const ChannelGroup groups[] = {
+    {0, 1},     // Timestamp
+    {1, 4},     // Thumb
+    {5, 3},     // Index
+    {8, 3},     // Middle
+    {11, 3},    // Ring
+    {14, 3},    // Pinky
+    {17, 4},    // Quaternion
+    {21, 3},    // Acceleration
+};
+static const uint8_t GROUP_COUNT = sizeof(groups) / sizeof(groups[0]);
+
+#define CH_TIME 0
+#define CH_JOINT_0 1
+#define CH_QUAT_0 (CH_JOINT_0 + CODEC_JOINT_COUNT)
+#define CH_ACCEL_0 (CH_QUAT_0 + CODEC_QUAT_COUNT)
+
+#define WIDTH_BITS 5
+#define MAX_DELTA_WIDTH 31  // Anything wider is sent as a keyframe
+
+enum Predictor : uint8_t {
+    PREDICT_PREVIOUS = 0,   // x[n-1]
+    PREDICT_LINEAR = 1      // 2 x[n-1] - x[n-2]
+};
+
+static inline uint32_t zigzag(uint32_t residual) {
+    return (residual << 1) ^ (uint32_t)((int32_t)residual >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t z) {
+    return (z >> 1) ^ (0u - (z & 1));
+}
+
+static inline uint8_t bitWidth(uint32_t v) {
+    return v == 0 ? 0 : 32 - __builtin_clz(v);
+}
+
+// All channel arithmetic is modulo 2^32: lossless regardless of wrap, and the
+// timestamp may roll over freely.
+static inline uint32_t predict(uint8_t predictor, uint32_t p1, uint32_t p2) {
+    return predictor == PREDICT_LINEAR ? 2 * p1 - p2 : p1;
+}
+
+static void frameToChannels(const Frame& frame, uint32_t* v) {
+    v[CH_TIME] = frame.timestamp_us;
+    for (uint8_t i = 0; i < CODEC_JOINT_COUNT; i++) {
+        v[CH_JOINT_0 + i] = frame.joints[i] & ((1u << CODEC_JOINT_BITS) - 1);
+    }
+    for (uint8_t i = 0; i < CODEC_QUAT_COUNT; i++) {
+        v[CH_QUAT_0 + i] = (uint32_t)(int32_t)frame.quat[i];
+    }
+    for (uint8_t i = 0; i < CODEC_ACCEL_COUNT; i++) {
+        v[CH_ACCEL_0 + i] = (uint32_t)(int32_t)frame.accel[i];
+    }
+}
+
+static void channelsToFrame(const uint32_t* v, Frame* frame) {
+    frame->timestamp_us = v[CH_TIME];
+    for (uint8_t i = 0; i < CODEC_JOINT_COUNT; i++) {
+        frame->joints[i] = (uint16_t)v[CH_JOINT_0 + i];
+    }
+    for (uint8_t i = 0; i < CODEC_QUAT_COUNT; i++) {
+        frame->quat[i] = (int16_t)v[CH_QUAT_0 + i];
+    }
+    for (uint8_t i = 0; i < CODEC_ACCEL_COUNT; i++) {
+        frame->accel[i] = (int16_t)v[CH_ACCEL_0 + i];
+    }
+}
+
+static inline uint8_t keyframeBits(uint8_t channel) {
+    if (channel == CH_TIME) return 32;
+    if (channel < CH_QUAT_0) return CODEC_JOINT_BITS;
+    return 16;
+}
+
+// BitWriter
+
+void BitWriter::begin(uint8_t* buf, size_t capacity) {
+    buf_ = buf;
+    cap_ = capacity;
+    pos_ = 0;
+    acc_ = 0;
+    count_ = 0;
+}
+
+void BitWriter::write(uint32_t value, uint8_t bits) {
+    if (bits > 24) {
+        write(value & 0xFFFF, 16);
+        write(value >> 16, bits - 16);
+        return;
+    }
+    if (bits == 0) {
+        return;
+    }
+    acc_ |= (value & ((1u << bits) - 1)) << count_;
+    count_ += bits;
+    while (count_ >= 8) {
+        if (pos_ < cap_) {
+            buf_[pos_] = (uint8_t)acc_;
+        }
+        pos_++;
+        acc_ >>= 8;
+        count_ -= 8;
+    }
+}
+
+size_t BitWriter::finish() {
+    if (count_ > 0) {
+        if (pos_ < cap_) {
+            buf_[pos_] = (uint8_t)acc_;
+        }
+        pos_++;
+        acc_ = 0;
+        count_ = 0;
+    }
+    return pos_ < cap_ ? pos_ : cap_;
+}
+
+void BitWriter::rewind(const Mark& m) {
+    pos_ = m.pos;
+    acc_ = m.acc;
+    count_ = m.count;
+}
+
+// BitReader
+
+uint32_t BitReader::read(uint8_t bits) {
+    if (bits > 24) {
+        uint32_t low = read(16);
+        return low | (read(bits - 16) << 16);
+    }
+    if (bits == 0) {
+        return 0;
+    }
+    while (count_ < bits) {
+        uint32_t byte = 0;
+        if (pos_ < len_) {
+            byte = buf_[pos_];
+        } else {
+            overrun_ = true;
+        }
+        pos_++;
+        acc_ |= byte << count_;
+        count_ += 8;
+    }
+    uint32_t value = acc_ & ((1u << bits) - 1);
+    acc_ >>= bits;
+    count_ -= bits;
+    return value;
+}
+
+// Encoder
+
+Encoder::Encoder(uint16_t keyframe_interval)
+    : keyframeInterval_(keyframe_interval ? keyframe_interval : 1) {
+    reset();
+}
+
+void Encoder::reset() {
+    primed_ = false;
+    sinceKeyframe_ = keyframeInterval_;
+    memset(prev1_, 0, sizeof(prev1_));
+    memset(prev2_, 0, sizeof(prev2_));
+}
+
+void Encoder::beginPacket(uint8_t* buf, size_t capacity) {
+    frames_ = 0;
+    if (capacity < sizeof(PacketHeader)) {
+        header_ = nullptr;
+        writer_.begin(buf, 0);
+        return;
+    }
+    header_ = reinterpret_cast<PacketHeader*>(buf);
+    writer_.begin(buf + sizeof(PacketHeader), capacity - sizeof(PacketHeader));
+}
+
+void Encoder::encodeKeyframe(const uint32_t* values) {
+    writer_.write(1, 1);
+    for (uint8_t c = 0; c < CODEC_CHANNEL_COUNT; c++) {
+        writer_.write(values[c], keyframeBits(c));
+    }
+}
+
+bool Encoder::encodeDelta(const uint32_t* values) {
+    uint32_t residuals[CODEC_CHANNEL_COUNT];
+    uint8_t predictors[GROUP_COUNT];
+    uint8_t widths[GROUP_COUNT];
+
+    // Pick the predictor that needs the narrower residuals, per group
+    for (uint8_t g = 0; g < GROUP_COUNT; g++) {
+        uint8_t first = groups[g].first;
+        uint8_t last = first + groups[g].count;
+        uint32_t zzPrevious[4], zzLinear[4];
+        uint32_t orPrevious = 0, orLinear = 0;
+        for (uint8_t c = first; c < last; c++) {
+            uint32_t d = values[c] - prev1_[c];
+            zzPrevious[c - first] = zigzag(d);
+            zzLinear[c - first] = zigzag(d - (prev1_[c] - prev2_[c]));
+            orPrevious |= zzPrevious[c - first];
+            orLinear |= zzLinear[c - first];
+        }
+        bool linear = orLinear < orPrevious && bitWidth(orLinear) < bitWidth(orPrevious);
+        uint8_t width = bitWidth(linear ? orLinear : orPrevious);
+        if (width > MAX_DELTA_WIDTH) {
+            return false;
+        }
+        predictors[g] = linear ? PREDICT_LINEAR : PREDICT_PREVIOUS;
+        widths[g] = width;
+        memcpy(&residuals[first], linear ? zzLinear : zzPrevious, (last - first) * sizeof(uint32_t));
+    }
+
+    writer_.write(0, 1);
+    for (uint8_t g = 0; g < GROUP_COUNT; g++) {
+        writer_.write(predictors[g], 1);
+        writer_.write(widths[g], WIDTH_BITS);
+        for (uint8_t c = groups[g].first; c < groups[g].first + groups[g].count; c++) {
+            writer_.write(residuals[c], widths[g]);
+        }
+    }
+    return true;
+}
+
+bool Encoder::add(const Frame& frame) {
+    if (header_ == nullptr || frames_ == UINT8_MAX) {
+        return false;
+    }
+
+    uint32_t values[CODEC_CHANNEL_COUNT];
+    frameToChannels(frame, values);
+
+    BitWriter::Mark mark = writer_.mark();
+    bool keyframe = !primed_ || sinceKeyframe_ >= keyframeInterval_;
+    if (!keyframe && !encodeDelta(values)) {
+        keyframe = true;  // Residual too wide, e.g. a long gap in timestamps
+    }
+    if (keyframe) {
+        encodeKeyframe(values);
+    }
+    if (writer_.overflow()) {
+        writer_.rewind(mark);
+        return false;
+    }
+
+    if (keyframe) {
+        // With no older frame, linear prediction degenerates to "previous"
+        memcpy(prev2_, values, sizeof(prev2_));
+        sinceKeyframe_ = 0;
+        primed_ = true;
+    } else {
+        memcpy(prev2_, prev1_, sizeof(prev2_));
+    }
+    memcpy(prev1_, values, sizeof(prev1_));
+    sinceKeyframe_++;
+    frames_++;
+    return true;
+}
+
+size_t Encoder::finishPacket() {
+    if (header_ == nullptr || frames_ == 0) {
+        return 0;
+    }
+    header_->magic = CODEC_PACKET_MAGIC;
+    header_->version = CODEC_PACKET_VERSION << 4;
+    header_->sequence = sequence_++;
+    header_->frame_count = frames_;
+    size_t bytes = sizeof(PacketHeader) + writer_.finish();
+    header_ = nullptr;
+    return bytes;
+}
+
+// Decoder
+
+void Decoder::reset() {
+    synced_ = false;
+    seenPacket_ = false;
+    expectedSequence_ = 0;
+    memset(prev1_, 0, sizeof(prev1_));
+    memset(prev2_, 0, sizeof(prev2_));
+    lostPackets_ = 0;
+    droppedFrames_ = 0;
+}
+
+bool Decoder::decodePacket(const uint8_t* buf, size_t len, Frame* out, size_t max_frames, size_t* count) {
+    *count = 0;
+    if (len < sizeof(PacketHeader)) {
+        return false;
+    }
+    PacketHeader header;
+    memcpy(&header, buf, sizeof(header));
+    if (header.magic != CODEC_PACKET_MAGIC || (header.version >> 4) != CODEC_PACKET_VERSION) {
+        return false;
+    }
+
+    if (seenPacket_ && header.sequence != expectedSequence_) {
+        // Deltas in this packet refer to frames we never saw
+        lostPackets_ += (uint8_t)(header.sequence - expectedSequence_);
+        synced_ = false;
+    }
+    seenPacket_ = true;
+    expectedSequence_ = header.sequence + 1;
+
+    BitReader reader(buf + sizeof(PacketHeader), len - sizeof(PacketHeader));
+    uint32_t values[CODEC_CHANNEL_COUNT];
+
+    for (uint8_t f = 0; f < header.frame_count; f++) {
+        bool keyframe = reader.read(1);
+        if (keyframe) {
+            for (uint8_t c = 0; c < CODEC_CHANNEL_COUNT; c++) {
+                uint8_t bits = keyframeBits(c);
+                uint32_t raw = reader.read(bits);
+                // Quaternion and acceleration are signed 16-bit
+                values[c] = (c >= CH_QUAT_0) ? (uint32_t)(int32_t)(int16_t)raw : raw;
+            }
+        } else {
+            for (uint8_t g = 0; g < GROUP_COUNT; g++) {
+                uint8_t predictor = reader.read(1);
+                uint8_t width = reader.read(WIDTH_BITS);
+                for (uint8_t c = groups[g].first; c < groups[g].first + groups[g].count; c++) {
+                    values[c] = predict(predictor, prev1_[c], prev2_[c]) + unzigzag(reader.read(width));
+                }
+            }
+        }
+        if (reader.overrun()) {
+            synced_ = false;
+            return false;
+        }
+
+        if (keyframe) {
+            memcpy(prev2_, values, sizeof(prev2_));
+            synced_ = true;
+        } else if (!synced_) {
+            droppedFrames_++;
+            continue;
+        } else {
+            memcpy(prev2_, prev1_, sizeof(prev2_));
+        }
+        memcpy(prev1_, values, sizeof(prev1_));
+
+        if (*count < max_frames) {
+            channelsToFrame(values, &out[*count]);
+            (*count)++;
+        }
+    }
+    return true;
+}
+
+}  // namespace codec
@@ -0,0 +1,205 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compressed glove frame stream for the radio links. Plain C++ with no
+// Arduino dependencies so the host tools compile the same file.
+//
+// Packet layout:
+//   PacketHeader (4 bytes)
+//   frame_count frames, bit-packed LSB first, no padding between frames
+//
+// Each frame starts with one type bit.
+//   Keyframe (1): timestamp 32 bits, joints 12 bits each, quaternion and
+//                 acceleration 16 bits each. No history needed to decode.
+//   Delta (0):    for each channel group a predictor bit and a 5-bit width,
+//                 then one zigzag residual of that width per channel.
+// Residuals are taken against a prediction from the two previous decoded
+// frames, so the encoder and decoder stay in lock step and joints are lossless.
+
+#define CODEC_JOINT_COUNT 16
+#define CODEC_QUAT_COUNT 4
+#define CODEC_ACCEL_COUNT 3
+#define CODEC_CHANNEL_COUNT (1 + CODEC_JOINT_COUNT + CODEC_QUAT_COUNT + CODEC_ACCEL_COUNT)
+
+#define CODEC_JOINT_BITS 12                 // Joints are unsigned 12-bit values
+#define CODEC_JOINT_OFFSET 2048             // Joint angles are sent offset by this
+#define CODEC_QUAT_SCALE 16384.0f           // Quaternion components in Q14
+#define CODEC_ACCEL_SCALE 256.0f            // Acceleration in 1/256 m/s^2
+#define CODEC_DEFAULT_KEYFRAME_INTERVAL 32  // Frames between keyframes
+
+#define CODEC_PACKET_MAGIC 0xEC
+#define CODEC_PACKET_VERSION 1
+#define CODEC_MAX_FRAME_BYTES 56            // Worst case for one encoded frame
+
+// Byte-stream links (USB CDC) have no packet boundaries and share the port
+// with text output, so each packet is wrapped as:
+//   sync 0xA5 0x5A, length (u16 LE), packet bytes, checksum (u8, sum of packet bytes)
+// Receivers hunt for the sync bytes and drop anything whose checksum fails.
+#define CODEC_STREAM_SYNC_0 0xA5
+#define CODEC_STREAM_SYNC_1 0x5A
+#define CODEC_STREAM_HEADER_BYTES 4
+#define CODEC_STREAM_OVERHEAD (CODEC_STREAM_HEADER_BYTES + 1)
+#define CODEC_STREAM_MAX_PACKET 512
+
+namespace codec {
+
+struct Frame {
+    uint32_t timestamp_us;
+    uint16_t joints[CODEC_JOINT_COUNT];     // 0..4095
+    int16_t quat[CODEC_QUAT_COUNT];         // x, y, z, w in Q14
+    int16_t accel[CODEC_ACCEL_COUNT];       // Linear acceleration x, y, z
+};
+
+#pragma pack(push, 1)
+struct PacketHeader {
+    uint8_t magic;          // CODEC_PACKET_MAGIC
+    uint8_t version;        // High nibble CODEC_PACKET_VERSION, low nibble reserved
+    uint8_t sequence;       // Increments per packet, used to detect loss
+    uint8_t frame_count;
+};
+#pragma pack(pop)
+
+inline uint8_t streamChecksum(const uint8_t* buf, size_t len) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += buf[i];
+    }
+    return sum;
+}
+
+/**
+ * Bounded LSB-first bit writer. Writing past the end sets overflow() instead
+ * of touching memory outside the buffer; rewind() to a mark clears it again.
+ */
+class BitWriter {
+public:
+    void begin(uint8_t* buf, size_t capacity);
+    void write(uint32_t value, uint8_t bits);
+    /**
+     * Flushes the partial byte. Returns the number of bytes used.
+     */
+    size_t finish();
+
+    size_t bitPosition() const { return pos_ * 8 + count_; }
+    bool overflow() const { return bitPosition() > cap_ * 8; }
+
+    struct Mark {
+        size_t pos;
+        uint32_t acc;
+        uint8_t count;
+    };
+    Mark mark() const { return {pos_, acc_, count_}; }
+    void rewind(const Mark& m);
+
+private:
+    uint8_t* buf_ = nullptr;
+    size_t cap_ = 0;
+    size_t pos_ = 0;
+    uint32_t acc_ = 0;
+    uint8_t count_ = 0;
+};
+
+/**
+ * LSB-first bit reader. Reading past the end returns zeros and sets overrun().
+ */
+class BitReader {
+public:
+    BitReader(const uint8_t* buf, size_t len) : buf_(buf), len_(len) {}
+    uint32_t read(uint8_t bits);
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint8_t* buf_;
+    size_t len_;
+    size_t pos_ = 0;
+    uint32_t acc_ = 0;
+    uint8_t count_ = 0;
+    bool overrun_ = false;
+};
+
+/**
+ * Packs consecutive frames into packets. Usage per packet:
+ *   beginPacket(buf, len); while (add(frame)) {...}; n = finishPacket();
+ */
+class Encoder {
+public:
+    explicit Encoder(uint16_t keyframe_interval = CODEC_DEFAULT_KEYFRAME_INTERVAL);
+
+    /**
+     * Drops all history; the next frame is a keyframe.
+     */
+    void reset();
+
+    /**
+     * Makes the next frame a keyframe, e.g. after the receiver reported loss.
+     */
+    void requestKeyframe() { sinceKeyframe_ = keyframeInterval_; }
+
+    void beginPacket(uint8_t* buf, size_t capacity);
+
+    /**
+     * Appends one frame to the open packet.
+     * @return false if the frame does not fit; nothing is written and the
+     *         predictor history is unchanged, so the frame can go in the next packet
+     */
+    bool add(const Frame& frame);
+
+    /**
+     * Closes the packet.
+     * @return Packet size in bytes, 0 if no frame was added
+     */
+    size_t finishPacket();
+
+    uint8_t frameCount() const { return frames_; }
+
+private:
+    void encodeKeyframe(const uint32_t* values);
+    bool encodeDelta(const uint32_t* values);
+
+    BitWriter writer_;
+    PacketHeader* header_ = nullptr;
+    uint8_t frames_ = 0;
+    uint8_t sequence_ = 0;
+    uint16_t keyframeInterval_;
+    uint16_t sinceKeyframe_;
+    bool primed_ = false;                        // False until the first keyframe
+    uint32_t prev1_[CODEC_CHANNEL_COUNT];
+    uint32_t prev2_[CODEC_CHANNEL_COUNT];
+};
+
+/**
+ * Decodes packets produced by Encoder. Frames that depend on a lost packet are
+ * dropped until the next keyframe.
+ */
+class Decoder {
+public:
+    Decoder() { reset(); }
+    void reset();
+
+    /**
+     * @param out Room for max_frames frames
+     * @param count Set to the number of frames written to out
+     * @return false if the packet is malformed (frames decoded before the
+     *         error are still returned)
+     */
+    bool decodePacket(const uint8_t* buf, size_t len, Frame* out, size_t max_frames, size_t* count);
+
+    uint32_t lostPackets() const { return lostPackets_; }
+    uint32_t droppedFrames() const { return droppedFrames_; }
+
+private:
+    bool synced_;
+    bool seenPacket_;
+    uint8_t expectedSequence_;
+    uint32_t prev1_[CODEC_CHANNEL_COUNT];
+    uint32_t prev2_[CODEC_CHANNEL_COUNT];
+    uint32_t lostPackets_;
+    uint32_t droppedFrames_;
+};
+
+}  // namespace codec
+
+#endif
@@ -0,0 +1,230 @@
+// Host round-trip test for FrameCodec.
+//
+// Encodes a long, noisy glove stream whose 32-bit clock wraps and whose
+// packet sequence number wraps several times, in ESP-NOW sized packets, and
+// checks that:
+//   - without loss every frame decodes bit-exactly
+//   - with packets dropped, frames after each gap are withheld until the next
+//     keyframe, everything that is decoded is exact, and the loss is counted
+//   - an encoder that is asked for a keyframe after a loss resyncs at once
+//   - truncated and foreign packets are rejected
+//
+// Lives under test/ so the firmware build does not pick it up. Build and run
+// as shown in host/README.md; exits non-zero if any check fails.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "FrameCodec.h"
+
+using codec::Frame;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+static const size_t FRAME_COUNT = 3000;
+static const size_t PACKET_CAPACITY = 250;    // ESP_NOW_MAX_DATA_LEN
+static const uint8_t FRAMES_PER_PACKET = 4;   // GLOVE_FRAMES_PER_PACKET
+static const uint32_t WRAP_FRAME = 400;       // Frame at which the clock wraps
+
+struct Packet {
+    std::vector<uint8_t> bytes;
+    size_t first;    // Index of its first frame
+    uint8_t count;
+};
+
+static uint32_t rng = 12345;
+static int32_t randomStep(int32_t range) {
+    rng = rng * 1664525u + 1013904223u;
+    return (int32_t)((rng >> 8) % (uint32_t)(2 * range + 1)) - range;
+}
+
+static int32_t clampTo(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// 200 Hz with jitter, joints and IMU channels as noisy random walks
+static std::vector<Frame> makeStream() {
+    std::vector<Frame> frames(FRAME_COUNT);
+    Frame f;
+    memset(&f, 0, sizeof(f));
+    f.timestamp_us = 0u - WRAP_FRAME * 5000u;
+    for (int j = 0; j < CODEC_JOINT_COUNT; j++) f.joints[j] = 2048;
+    f.quat[3] = 16384;
+    for (size_t i = 0; i < FRAME_COUNT; i++) {
+        if (i > 0) f.timestamp_us += 5000 + randomStep(40);
+        for (int j = 0; j < CODEC_JOINT_COUNT; j++) {
+            f.joints[j] = (uint16_t)clampTo(f.joints[j] + randomStep(30), 0, 4095);
+        }
+        for (int q = 0; q < CODEC_QUAT_COUNT; q++) {
+            f.quat[q] = (int16_t)clampTo(f.quat[q] + randomStep(200), -16384, 16384);
+        }
+        for (int a = 0; a < CODEC_ACCEL_COUNT; a++) {
+            f.accel[a] = (int16_t)clampTo(f.accel[a] + randomStep(400), -32768, 32767);
+        }
+        frames[i] = f;
+    }
+    return frames;
+}
+
+static bool sameFrame(const Frame& a, const Frame& b) {
+    return a.timestamp_us == b.timestamp_us && memcmp(a.joints, b.joints, sizeof(a.joints)) == 0 &&
+           memcmp(a.quat, b.quat, sizeof(a.quat)) == 0 && memcmp(a.accel, b.accel, sizeof(a.accel)) == 0;
+}
+
+// Packs frames the way glove_sendFrame() does. Packets in lost get a keyframe
+// requested right after them when resync is set, as a receiver reporting loss would.
+static std::vector<Packet> encodeStream(const std::vector<Frame>& frames, const std::vector<bool>* lost = nullptr,
+                                        bool resync = false) {
+    codec::Encoder encoder;
+    std::vector<Packet> packets;
+    uint8_t buf[PACKET_CAPACITY];
+    size_t i = 0;
+    while (i < frames.size()) {
+        Packet p;
+        p.first = i;
+        encoder.beginPacket(buf, sizeof(buf));
+        while (i < frames.size() && encoder.frameCount() < FRAMES_PER_PACKET && encoder.add(frames[i])) i++;
+        p.count = encoder.frameCount();
+        p.bytes.assign(buf, buf + encoder.finishPacket());
+        CHECK(p.count > 0);
+        if (resync && lost && (*lost)[packets.size()]) encoder.requestKeyframe();
+        packets.push_back(p);
+    }
+    return packets;
+}
+
+static std::vector<bool> everyNth(size_t packets, size_t n, size_t phase) {
+    std::vector<bool> lost(packets, false);
+    for (size_t p = phase; p + 1 < packets; p += n) lost[p] = true;
+    return lost;
+}
+
+static void testLossless(const std::vector<Frame>& frames) {
+    std::vector<Packet> packets = encodeStream(frames);
+    CHECK(packets.size() > 2 * 256);  // The sequence number wraps twice
+
+    codec::Decoder decoder;
+    Frame out[UINT8_MAX];
+    size_t decoded = 0, bytes = 0;
+    bool wrapped = false;
+    for (const Packet& p : packets) {
+        size_t n = 0;
+        CHECK(decoder.decodePacket(p.bytes.data(), p.bytes.size(), out, UINT8_MAX, &n));
+        CHECK(n == p.count);
+        for (size_t k = 0; k < n && decoded < frames.size(); k++, decoded++) {
+            CHECK(sameFrame(out[k], frames[decoded]));
+            if (decoded > 0 && out[k].timestamp_us < frames[decoded - 1].timestamp_us) wrapped = true;
+        }
+        bytes += p.bytes.size();
+    }
+    CHECK(decoded == frames.size());
+    CHECK(wrapped);
+    CHECK(decoder.lostPackets() == 0);
+    CHECK(decoder.droppedFrames() == 0);
+    printf("lossless: %zu frames in %zu packets, %.1f bytes per frame\n", decoded, packets.size(),
+           (double)bytes / decoded);
+}
+
+// Plays packets through a decoder, skipping the lost ones, and compares with
+// what the decoder should hand out: nothing after a gap until a keyframe.
+static void testLoss(const std::vector<Frame>& frames, size_t n, size_t phase, bool resync) {
+    std::vector<Packet> probe = encodeStream(frames);
+    std::vector<bool> lost = everyNth(probe.size(), n, phase);
+    std::vector<Packet> packets = encodeStream(frames, &lost, resync);
+    CHECK(packets.size() == probe.size());
+
+    // The encoder sends a keyframe every CODEC_DEFAULT_KEYFRAME_INTERVAL frames
+    // and, with resync, first thing in the packet after a lost one
+    std::vector<bool> keyframe(frames.size(), false);
+    size_t since = CODEC_DEFAULT_KEYFRAME_INTERVAL;
+    for (size_t p = 0; p < packets.size(); p++) {
+        for (size_t i = packets[p].first; i < packets[p].first + packets[p].count; i++) {
+            bool forced = resync && p > 0 && lost[p - 1] && i == packets[p].first;
+            if (since >= CODEC_DEFAULT_KEYFRAME_INTERVAL || forced) {
+                keyframe[i] = true;
+                since = 0;
+            }
+            since++;
+        }
+    }
+
+    codec::Decoder decoder;
+    Frame out[UINT8_MAX];
+    bool synced = true;
+    size_t lostCount = 0, withheld = 0, decoded = 0;
+    for (size_t p = 0; p < packets.size(); p++) {
+        if (lost[p]) {
+            lostCount++;
+            synced = false;
+            continue;
+        }
+        std::vector<size_t> expected;
+        for (size_t i = packets[p].first; i < packets[p].first + packets[p].count; i++) {
+            if (keyframe[i]) synced = true;
+            if (synced) {
+                expected.push_back(i);
+            } else {
+                withheld++;
+            }
+        }
+        size_t got = 0;
+        CHECK(decoder.decodePacket(packets[p].bytes.data(), packets[p].bytes.size(), out, UINT8_MAX, &got));
+        CHECK(got == expected.size());
+        for (size_t k = 0; k < got && k < expected.size(); k++) CHECK(sameFrame(out[k], frames[expected[k]]));
+        decoded += got;
+    }
+    CHECK(decoder.lostPackets() == lostCount);
+    CHECK(decoder.droppedFrames() == withheld);
+    if (resync) CHECK(withheld == 0);
+    else CHECK(withheld > 0);
+    printf("1 in %zu packets lost%s: %zu lost, %zu frames decoded, %zu withheld until a keyframe\n", n,
+           resync ? ", keyframe on loss" : "", lostCount, decoded, withheld);
+}
+
+static void testMalformed(const std::vector<Frame>& frames) {
+    std::vector<Frame> head(frames.begin(), frames.begin() + FRAMES_PER_PACKET);
+    std::vector<Packet> packets = encodeStream(head);
+    CHECK(packets.size() == 1);
+    const std::vector<uint8_t>& good = packets[0].bytes;
+    Frame out[UINT8_MAX];
+    size_t n = 0;
+
+    codec::Decoder truncated;
+    CHECK(!truncated.decodePacket(good.data(), good.size() / 2, out, UINT8_MAX, &n));
+    CHECK(!truncated.decodePacket(good.data(), sizeof(codec::PacketHeader) - 1, out, UINT8_MAX, &n));
+
+    std::vector<uint8_t> foreign = good;
+    foreign[0] ^= 0xff;
+    codec::Decoder wrongMagic;
+    CHECK(!wrongMagic.decodePacket(foreign.data(), foreign.size(), out, UINT8_MAX, &n));
+    CHECK(n == 0);
+
+    codec::Decoder intact;
+    CHECK(intact.decodePacket(good.data(), good.size(), out, UINT8_MAX, &n));
+    CHECK(n == FRAMES_PER_PACKET);
+}
+
+int main() {
+    std::vector<Frame> frames = makeStream();
+    testLossless(frames);
+    testLoss(frames, 7, 3, false);
+    testLoss(frames, 3, 1, false);
+    testLoss(frames, 7, 3, true);
+    testMalformed(frames);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("FrameCodec round trip OK\n");
+    return 0;
+}
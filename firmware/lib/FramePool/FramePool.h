@@ -0,0 +1,72 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stdint.h>
+
+// Fixed-capacity pool of frame buffers. The slots are part of the pool
+// object, so a pool at file scope is sized at link time and never touches the
+// heap. acquire() and release() are lock-free and may be called from
+// different tasks; a slot belongs to whoever acquired it until it is released.
+
+#define FRAME_POOL_MAX_SLOTS 32
+
+template <typename T, uint8_t N>
+class FramePool {
+    static_assert(N > 0 && N <= FRAME_POOL_MAX_SLOTS, "FramePool holds 1 to 32 slots");
+
+public:
+    /**
+     * Takes a free slot.
+     * @return nullptr if every slot is in use; counted in exhausted()
+     */
+    T* acquire() {
+        uint32_t free = __atomic_load_n(&free_, __ATOMIC_RELAXED);
+        while (free != 0) {
+            uint32_t bit = free & (0u - free);
+            if (__atomic_compare_exchange_n(&free_, &free, free & ~bit, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                noteInUse(N - __builtin_popcount(free & ~bit));
+                return &slots_[__builtin_ctz(bit)];
+            }
+        }
+        __atomic_fetch_add(&exhausted_, 1, __ATOMIC_RELAXED);
+        return nullptr;
+    }
+
+    /**
+     * Returns a slot from acquire(). The caller must not touch it afterwards.
+     */
+    void release(T* slot) {
+        __atomic_fetch_or(&free_, 1u << (slot - slots_), __ATOMIC_RELEASE);
+    }
+
+    uint8_t capacity() const { return N; }
+
+    uint8_t inUse() const {
+        return N - __builtin_popcount(__atomic_load_n(&free_, __ATOMIC_RELAXED));
+    }
+
+    /**
+     * Most slots ever in use at once
+     */
+    uint8_t highWater() const { return __atomic_load_n(&highWater_, __ATOMIC_RELAXED); }
+
+    /**
+     * acquire() calls that found no free slot
+     */
+    uint32_t exhausted() const { return __atomic_load_n(&exhausted_, __ATOMIC_RELAXED); }
+
+private:
+    void noteInUse(uint8_t used) {
+        uint8_t seen = __atomic_load_n(&highWater_, __ATOMIC_RELAXED);
+        while (used > seen &&
+               !__atomic_compare_exchange_n(&highWater_, &seen, used, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    T slots_[N];
+    uint32_t free_ = N == FRAME_POOL_MAX_SLOTS ? 0xFFFFFFFFu : (1u << N) - 1;
+    uint8_t highWater_ = 0;
+    uint32_t exhausted_ = 0;
+};
+
+#endif
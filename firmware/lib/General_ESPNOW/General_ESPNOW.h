@@ -5,16 +5,20 @@
 #include <WiFi.h>
 #include <esp_wifi.h>  // Required for using ESP32-specific WiFi functions
 #include <stdint.h>
+#include <stddef.h>
 
 #define ESPNOW_WIFI_CHANNEL 5            // WiFi channel to be used by ESP-NOW. The available channels will depend on your region.
 #define ESPNOW_WIFI_MODE    WIFI_STA     // WiFi mode to be used by ESP-NOW. Any mode can be used.
 #define ESPNOW_WIFI_IF      WIFI_IF_STA  // WiFi interface to be used by ESP-NOW. Any interface can be used.
 #define DATA_RATE           100          // In Hz
-#define SYNC_DELAY          2           // delay (in sec) between setting up ESPNOW and sending packets
+#define SYNC_DELAY          2           // time (in sec) between setting up ESPNOW and sending packets; setup does not wait for it
 #define PEER_MAC_1          {0x3C, 0x84, 0x27, 0x14, 0x7B, 0xB0} // MAC for board 1
 #define PEER_MAC_2          {0x3C, 0x84, 0x27, 0xE1, 0xB3, 0x8C} // MAC for board 2
 
 // Define the data packets
+// position_packet is the legacy uncompressed layout kept for existing arm
+// receivers, which check the length; do not add fields. New links carry
+// HandFrame (lib/HandFrame) or FrameCodec packets
 typedef struct position_packet {
   // remove when not monitoring success rate:
   int messages_rec;
@@ -24,11 +28,17 @@ typedef struct position_packet {
   uint8_t arm_pos[3];
 } position_packet;
 
+static_assert(sizeof(position_packet) == 36, "position_packet layout is fixed by existing receivers");
+
 typedef struct haptic_packet {
   // remove when not monitoring success rate:
   int messages_rec;
   // end remove
   uint8_t forces[5];
+  uint32_t echo_us;        // timestamp_us of the newest FrameCodec frame the robot decoded, 0 if unknown
 } haptic_packet;
 
+// Size of a haptic_packet from senders that predate echo_us
+#define HAPTIC_PACKET_LEGACY_SIZE offsetof(haptic_packet, echo_us)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#ifndef GESTURE_MODEL_H
+#define GESTURE_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Quantized MLP gesture model and its int8 inference kernel. Plain C++ with no
+// Arduino dependencies: host/tools/gesture_train writes models with this
+// header and scores them with the same kernel the glove runs, so its reported
+// accuracy is the glove's.
+//
+// Input: the last `window` frames, `stride` frames apart, oldest first, each
+// GESTURE_FRAME_FEATURES values (frameFeatures()) quantized to int8 through
+// the model's per-feature InputQuant. Hidden layers are int8 in, int8 out
+// with ReLU; the last layer's int32 accumulators are the class scores.
+// Class 0 is "no gesture".
+//
+// Layout (little endian, every part a multiple of 4 bytes):
+//   ModelHeader
+//   InputQuant inputs[GESTURE_FRAME_FEATURES]
+//   per layer: LayerHeader, int8_t weights[outputs][inputs] padded to 4 bytes,
+//              int32_t bias[outputs]
+// crc covers everything after the header.
+
+#define GESTURE_MAGIC 0x4E4D4745            // "EGMN"
+#define GESTURE_VERSION 1
+#define GESTURE_JOINT_COUNT 16
+#define GESTURE_FRAME_FEATURES 20           // 16 joints, quaternion x, y, z, w
+#define GESTURE_MAX_WINDOW 16
+#define GESTURE_MAX_STRIDE 8
+#define GESTURE_MAX_LAYERS 4
+#define GESTURE_MAX_WIDTH (GESTURE_MAX_WINDOW * GESTURE_FRAME_FEATURES)
+#define GESTURE_MAX_CLASSES 16              // One HID button per class but "no gesture"
+#define GESTURE_MAX_MACS 16384              // Bounds the per-frame cost of a model
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Gesture models are stored in the target's byte order, little endian"
+#endif
+
+namespace gesture {
+
+#pragma pack(push, 1)
+struct ModelHeader {
+    uint32_t magic;             // GESTURE_MAGIC
+    uint16_t version;           // GESTURE_VERSION
+    uint16_t header_size;
+    uint8_t window;             // Frames per input
+    uint8_t stride;             // Captured frames between window frames
+    uint8_t layer_count;
+    uint8_t class_count;        // Outputs of the last layer
+    uint32_t body_size;         // Bytes after the header
+    uint32_t crc;               // CRC-32 of the body
+};
+
+// q = clamp((x - offset) * scale_q16 / 65536, -127, 127)
+struct InputQuant {
+    int32_t offset;
+    int32_t scale_q16;
+};
+
+// Hidden layers requantize y = (acc * multiplier) >> (31 + shift), rounded
+struct LayerHeader {
+    uint16_t inputs;
+    uint16_t outputs;
+    int32_t multiplier;         // Q31, unused by the last layer
+    int8_t shift;
+    uint8_t relu;
+    uint8_t reserved[2];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ModelHeader) == 20, "Gesture model header layout changed");
+static_assert(sizeof(InputQuant) == 8 && sizeof(LayerHeader) == 12, "Gesture model layout changed");
+
+inline size_t paddedWeights(uint32_t inputs, uint32_t outputs) {
+    return (inputs * outputs + 3) & ~(size_t)3;
+}
+
+/**
+ * A model parsed in place; the pointers reference the blob, which has to stay
+ * put (e.g. a const array in flash) and be 4-byte aligned.
+ */
+struct Model {
+    const ModelHeader* header = nullptr;
+    const InputQuant* inputs = nullptr;
+    const LayerHeader* layers[GESTURE_MAX_LAYERS] = {};
+    const int8_t* weights[GESTURE_MAX_LAYERS] = {};
+    const int32_t* bias[GESTURE_MAX_LAYERS] = {};
+    uint32_t macs = 0;          // Multiply-accumulates per inference
+};
+
+inline uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+/**
+ * Checks a blob and points a Model into it.
+ * @return nullptr if it is usable, otherwise what is wrong with it
+ */
+inline const char* parseModel(const uint8_t* blob, size_t len, Model* out) {
+    *out = Model();
+    if (len < sizeof(ModelHeader)) return "truncated header";
+    if (((uintptr_t)blob & 3) != 0) return "not 4-byte aligned";
+    const ModelHeader* h = (const ModelHeader*)blob;
+    if (h->magic != GESTURE_MAGIC) return "not a gesture model";
+    if (h->version != GESTURE_VERSION || h->header_size != sizeof(ModelHeader)) return "unsupported version";
+    if (h->window == 0 || h->window > GESTURE_MAX_WINDOW || h->stride == 0 || h->stride > GESTURE_MAX_STRIDE) {
+        return "window does not fit this firmware";
+    }
+    if (h->layer_count == 0 || h->layer_count > GESTURE_MAX_LAYERS) return "layer count does not fit this firmware";
+    if (h->class_count < 2 || h->class_count > GESTURE_MAX_CLASSES) return "class count does not fit this firmware";
+    if (len != sizeof(ModelHeader) + h->body_size) return "wrong size";
+    if (crc32(blob + sizeof(ModelHeader), h->body_size) != h->crc) return "checksum mismatch";
+
+    size_t pos = sizeof(ModelHeader);
+    out->inputs = (const InputQuant*)(blob + pos);
+    pos += GESTURE_FRAME_FEATURES * sizeof(InputQuant);
+    uint32_t width = (uint32_t)h->window * GESTURE_FRAME_FEATURES;
+    for (uint8_t l = 0; l < h->layer_count; l++) {
+        if (pos + sizeof(LayerHeader) > len) return "truncated layer";
+        const LayerHeader* layer = (const LayerHeader*)(blob + pos);
+        pos += sizeof(LayerHeader);
+        if (layer->inputs != width || layer->outputs == 0 || layer->outputs > GESTURE_MAX_WIDTH) {
+            return "layer shapes do not chain";
+        }
+        bool last = l + 1 == h->layer_count;
+        if (last && layer->outputs != h->class_count) return "last layer does not match the class count";
+        if (!last && (31 + layer->shift < 1 || 31 + layer->shift > 62)) return "requantization shift out of range";
+        size_t weights = paddedWeights(layer->inputs, layer->outputs);
+        size_t bias = layer->outputs * sizeof(int32_t);
+        if (pos + weights + bias > len) return "truncated layer";
+        out->layers[l] = layer;
+        out->weights[l] = (const int8_t*)(blob + pos);
+        out->bias[l] = (const int32_t*)(blob + pos + weights);
+        pos += weights + bias;
+        out->macs += (uint32_t)layer->inputs * layer->outputs;
+        width = layer->outputs;
+    }
+    if (pos != len) return "trailing bytes";
+    if (out->macs > GESTURE_MAX_MACS) return "too many multiply-accumulates per frame";
+    out->header = h;
+    return nullptr;
+}
+
+/**
+ * The per-frame features the model sees. The quaternion is flipped to w >= 0
+ * so both signs of one orientation give the same input.
+ * @param joints Joint angles as in HandFrame
+ * @param quat x, y, z, w in Q14
+ */
+inline void frameFeatures(const int16_t joints[GESTURE_JOINT_COUNT], const int16_t quat[4],
+                          int32_t out[GESTURE_FRAME_FEATURES]) {
+    for (int i = 0; i < GESTURE_JOINT_COUNT; i++) {
+        out[i] = joints[i];
+    }
+    int32_t sign = quat[3] < 0 ? -1 : 1;
+    for (int i = 0; i < 4; i++) {
+        out[GESTURE_JOINT_COUNT + i] = sign * quat[i];
+    }
+}
+
+inline int8_t quantizeInput(const InputQuant& q, int32_t x) {
+    int64_t v = ((int64_t)(x - q.offset) * q.scale_q16 + (1 << 15)) >> 16;
+    return (int8_t)(v < -127 ? -127 : v > 127 ? 127 : v);
+}
+
+// One fully connected layer; int8 rows, int32 accumulators
+inline void dense(const LayerHeader& layer, const int8_t* weights, const int32_t* bias, const int8_t* in,
+                  int32_t* acc) {
+    const uint32_t n = layer.inputs;
+    for (uint32_t o = 0; o < layer.outputs; o++) {
+        const int8_t* row = weights + o * n;
+        int32_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+        uint32_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            a0 += row[i] * in[i];
+            a1 += row[i + 1] * in[i + 1];
+            a2 += row[i + 2] * in[i + 2];
+            a3 += row[i + 3] * in[i + 3];
+        }
+        for (; i < n; i++) {
+            a0 += row[i] * in[i];
+        }
+        acc[o] = bias[o] + a0 + a1 + a2 + a3;
+    }
+}
+
+inline int8_t requantize(int32_t acc, int32_t multiplier, int8_t shift, bool relu) {
+    int total = 31 + shift;
+    int64_t v = ((int64_t)acc * multiplier + ((int64_t)1 << (total - 1))) >> total;
+    int32_t lo = relu ? 0 : -128;
+    return (int8_t)(v < lo ? lo : v > 127 ? 127 : v);
+}
+
+/**
+ * Runs the model on one quantized window.
+ * @param input window * GESTURE_FRAME_FEATURES values, oldest frame first
+ * @param scores Receives class_count class scores
+ * @return The class with the highest score
+ */
+inline uint8_t classify(const Model& model, const int8_t* input, int32_t* scores) {
+    int8_t buffers[2][GESTURE_MAX_WIDTH];
+    int32_t acc[GESTURE_MAX_WIDTH];
+    const int8_t* in = input;
+    uint8_t layers = model.header->layer_count;
+    for (uint8_t l = 0; l < layers; l++) {
+        const LayerHeader& layer = *model.layers[l];
+        bool last = l + 1 == layers;
+        dense(layer, model.weights[l], model.bias[l], in, last ? scores : acc);
+        if (last) break;
+        int8_t* out = buffers[l & 1];
+        for (uint32_t o = 0; o < layer.outputs; o++) {
+            out[o] = requantize(acc[o], layer.multiplier, layer.shift, layer.relu);
+        }
+        in = out;
+    }
+    uint8_t best = 0;
+    for (uint8_t c = 1; c < model.header->class_count; c++) {
+        if (scores[c] > scores[best]) best = c;
+    }
+    return best;
+}
+
+}  // namespace gesture
+
+#endif
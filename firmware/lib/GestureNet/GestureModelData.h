@@ -0,0 +1,14 @@
+#ifndef GESTURE_MODEL_DATA_H
+#define GESTURE_MODEL_DATA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The gesture model built into the firmware, kept in flash and run from there.
+// Replace this file with the output of host/tools/gesture_train. While it is
+// empty GAME_MODE keeps the per-finger thresholds.
+
+alignas(4) static const uint8_t GESTURE_MODEL_DATA[] = {0};
+static const size_t GESTURE_MODEL_SIZE = 0;
+
+#endif
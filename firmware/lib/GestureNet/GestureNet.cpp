@@ -0,0 +1,158 @@
+#include "GestureNet.h"
+#include "GestureModelData.h"
+#include "DeferredLog.h"
+
+// Quantized features of the latest frames; deep enough for the longest window
+#define GESTURE_HISTORY (GESTURE_MAX_WINDOW * GESTURE_MAX_STRIDE)
+
+static_assert((GESTURE_HISTORY & (GESTURE_HISTORY - 1)) == 0, "GESTURE_HISTORY must be a power of two");
+
+static gesture::Model model;
+static bool loaded = false;
+
+static int8_t history[GESTURE_HISTORY][GESTURE_FRAME_FEATURES];
+static uint32_t frameCount = 0;
+static uint8_t current = 0;                 // Reported gesture
+static uint8_t candidate = 0;               // Class trying to replace it
+static uint8_t candidateWins = 0;
+static int32_t scores[GESTURE_MAX_CLASSES];
+static uint32_t lastUs = 0;
+static uint32_t maxUs = 0;
+
+bool gestureNetSetup() {
+    loaded = false;
+    gestureReset();
+    if (GESTURE_MODEL_SIZE == 0) {
+        return false;
+    }
+    const char* problem = gesture::parseModel(GESTURE_MODEL_DATA, GESTURE_MODEL_SIZE, &model);
+    if (problem != nullptr) {
+        Serial.print("Gesture model ignored: ");
+        Serial.println(problem);
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool gestureModelLoaded() {
+    return loaded;
+}
+
+void gestureReset() {
+    frameCount = 0;
+    current = 0;
+    candidate = 0;
+    candidateWins = 0;
+}
+
+// Frames from the oldest to the newest sample of a window
+static uint32_t windowSpan() {
+    return (uint32_t)(model.header->window - 1) * model.header->stride + 1;
+}
+
+static void gatherWindow(int8_t* input) {
+    uint8_t window = model.header->window;
+    uint32_t oldest = frameCount - windowSpan();
+    for (uint8_t k = 0; k < window; k++) {
+        uint32_t frame = oldest + (uint32_t)k * model.header->stride;
+        memcpy(input + k * GESTURE_FRAME_FEATURES, history[frame & (GESTURE_HISTORY - 1)], GESTURE_FRAME_FEATURES);
+    }
+}
+
+static_assert(HAND_FRAME_JOINT_COUNT == GESTURE_JOINT_COUNT, "Gesture models expect every HandFrame joint");
+
+uint8_t gestureUpdate(const hand::Frame& frame) {
+    if (!loaded) {
+        return 0;
+    }
+
+    // Copied out of the packed frame so the fields are aligned
+    int16_t joints[GESTURE_JOINT_COUNT];
+    int16_t quat[4];
+    memcpy(joints, frame.joints, sizeof(joints));
+    memcpy(quat, frame.quat, sizeof(quat));
+    int32_t features[GESTURE_FRAME_FEATURES];
+    gesture::frameFeatures(joints, quat, features);
+    int8_t* slot = history[frameCount & (GESTURE_HISTORY - 1)];
+    for (uint8_t f = 0; f < GESTURE_FRAME_FEATURES; f++) {
+        slot[f] = gesture::quantizeInput(model.inputs[f], features[f]);
+    }
+    frameCount++;
+    if (frameCount < windowSpan()) {
+        return current;
+    }
+
+    int8_t input[GESTURE_MAX_WIDTH];
+    gatherWindow(input);
+    uint32_t start = micros();
+    uint8_t best = gesture::classify(model, input, scores);
+    lastUs = micros() - start;
+    if (lastUs > maxUs) maxUs = lastUs;
+
+    // A new gesture has to win a few frames in a row, so one noisy window cannot press a button
+    if (best == current) {
+        candidateWins = 0;
+        return current;
+    }
+    if (best != candidate) {
+        candidate = best;
+        candidateWins = 0;
+    }
+    if (++candidateWins >= GESTURE_HOLD_FRAMES) {
+        current = best;
+        candidateWins = 0;
+        LOG(LOG_GESTURE, current, scores[current]);
+    }
+    return current;
+}
+
+uint16_t gestureButtons(uint8_t gesture) {
+    return gesture == 0 ? 0 : (uint16_t)(1u << (gesture - 1));
+}
+
+uint32_t gestureBenchmark() {
+    if (!loaded) {
+        return 0;
+    }
+    int8_t input[GESTURE_MAX_WIDTH] = {};
+    if (frameCount >= windowSpan()) {
+        gatherWindow(input);
+    }
+    int32_t benchScores[GESTURE_MAX_CLASSES];
+    volatile uint8_t sink = 0;
+    uint32_t start = micros();
+    for (uint16_t run = 0; run < GESTURE_BENCH_RUNS; run++) {
+        sink = sink + gesture::classify(model, input, benchScores);
+    }
+    return (micros() - start) / GESTURE_BENCH_RUNS;
+}
+
+void printGestureNet() {
+    if (!loaded) {
+        Serial.println("Gesture model: none, using per-finger thresholds");
+        return;
+    }
+    const gesture::ModelHeader& h = *model.header;
+    Serial.print("Gesture model: window ");
+    Serial.print(h.window);
+    Serial.print(" x ");
+    Serial.print(h.stride);
+    Serial.print(" frames, layers ");
+    for (uint8_t l = 0; l < h.layer_count; l++) {
+        Serial.print(model.layers[l]->inputs);
+        Serial.print("-");
+    }
+    Serial.print(h.class_count);
+    Serial.print(", ");
+    Serial.print(model.macs);
+    Serial.println(" MACs");
+    Serial.print("Inference us: last ");
+    Serial.print(lastUs);
+    Serial.print(" max ");
+    Serial.print(maxUs);
+    Serial.print(" benchmark ");
+    Serial.println(gestureBenchmark());
+    Serial.print("Gesture: ");
+    Serial.println(current);
+}
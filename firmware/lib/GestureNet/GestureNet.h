@@ -0,0 +1,54 @@
+#ifndef GESTURE_NET_H
+#define GESTURE_NET_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "GestureModel.h"
+#include "HandFrame.h"
+
+// Gesture recognition from a short window of every joint plus orientation,
+// with the int8 MLP in GestureModel.h. The model is the one compiled in from
+// GestureModelData.h and is read straight from flash. Runs in loop() once per
+// frame; a model's cost is bounded by GESTURE_MAX_MACS.
+
+#define GESTURE_HOLD_FRAMES 3               // Consecutive wins before the reported gesture changes
+#define GESTURE_BENCH_RUNS 200
+
+/**
+ * Parses the built-in model.
+ * @return true if there is a usable one
+ */
+bool gestureNetSetup();
+
+bool gestureModelLoaded();
+
+/**
+ * Adds one frame and classifies the latest window. Until the window has
+ * filled up, and while a new class has not won GESTURE_HOLD_FRAMES times in a
+ * row, the previous gesture is kept.
+ * @return The current gesture, 0 for none
+ */
+uint8_t gestureUpdate(const hand::Frame& frame);
+
+/**
+ * Forgets the window, e.g. after frames were not fed for a while.
+ */
+void gestureReset();
+
+/**
+ * HID button bits for a gesture: class c presses button c - 1.
+ */
+uint16_t gestureButtons(uint8_t gesture);
+
+/**
+ * Times GESTURE_BENCH_RUNS inferences on the current window.
+ * @return Mean microseconds per inference, 0 without a model
+ */
+uint32_t gestureBenchmark();
+
+/**
+ * Prints the model shape and the measured inference times over Serial
+ */
+void printGestureNet();
+
+#endif
@@ -1,34 +1,41 @@
 #include "HallEffectSensors.h"
+#include "AdcBurst.h"
+#include "CalibrationTable.h"
+#include "Crosstalk.h"
+#include "DriftCompensation.h"
+#include "SensorHealth.h"
+#include "DeferredLog.h"
+#include <Preferences.h>
 
-ResponsiveAnalogRead analog(A2, true);
+ResponsiveAnalogRead analog(HALL_SENSOR_PIN, true);
+
+AcquisitionConfig acquisitionConfig = {
+    ACQ_BURST,
+    8,                      // K
+    REDUCE_MEDIAN,
+    ACQ_DEFAULT_SETTLE_US,
+    ACQ_DEFAULT_BUDGET_US
+};
 
 int32_t rawVals[SENSOR_COUNT];
+uint32_t rawValsQ4[SENSOR_COUNT];
+uint32_t acquisitionMisses[SENSOR_COUNT];
+uint16_t settleTimes[SENSOR_COUNT];
+uint32_t compensatedQ4[SENSOR_COUNT];
+uint32_t decoupledQ4[SENSOR_COUNT];
+
+// Reflected binary Gray code over the four select bits
+const uint8_t scanOrder[SENSOR_COUNT] = {
+    0, 1, 3, 2, 6, 7, 5, 4, 12, 13, 15, 14, 10, 11, 9, 8
+};
+
+static uint8_t selectedChannel = 0;
+static int32_t adcCodes[SENSOR_COUNT];      // Reduced reading before the eFuse correction, for the health monitor
+static bool missed[SENSOR_COUNT];           // No conversion this frame; the channel keeps its last value
 float proto_angles[SENSOR_COUNT];
 float min_angles[SENSOR_COUNT];
 float max_angles[SENSOR_COUNT];
 
-float polyVals[16][3] = {
-    {-0.000087481431887,0.549306011516565,-709.440158534950912},  //thumb 0
-    {0.000043188683603,-0.288631646308703,+518.26001946236131},   //thumb 1
-    {0.000081944493116,-0.48715545187493,753.215310445897971},    //thumb 2
-    {0.000029299702805,-0.235958663536102,473.892439373476074},   //thumb 3
-    {-0.000005288207298,0.121258593336859,-147.245901639344262},  //pointer 4
-    {-0.000135942468348,0.817456387325188,-1033.093236601650843}, //pointer 5
-    {0.000101643291297,-0.646716069346575,1031.971761445997989},  //pointer 6
-    {-0.000041474654378,0.275529953917051,-295.161290322580645},  //middle 7
-    {-0.000155663598998,0.846081469596033,-994.321241823930591},  //middle 8
-    {0.000170233984067,-1.128460118194487,1768.951835332448657},  //middle 9
-    {-0.000041474654378,0.275529953917051,-295.161290322580645},  //middle 7
-    {-0.000155663598998,0.846081469596033,-994.321241823930591},  //middle 8
-    {0.000170233984067,-1.128460118194487,1768.951835332448657},  //middle 9
-    // {-0.000053897180763,0.344485903814262,-417.201492537313433},  //ring 10
-    // {-0.000406773372404,2.026886777162145,-2364.087785492362531}, //ring 11
-    // {0.000020669692875,-0.186416998438648,403.233727023548938},   //ring 12
-    {-0.000050156739812,0.308087774294671,-325.54858934169279},   //pinkie 13
-    {-0.000204869267408,1.180238586110067,-1522.071698458919325}, //pinkie 14
-    {0.00009027900176,-0.57849114376526,925.953643298021097},     //pinkie 15
-};
-
 void hallEffectSensorsSetup(){
     analogReadResolution(12);
 
@@ -44,42 +51,326 @@ void hallEffectSensorsSetup(){
     for (uint8_t i = 0; i < SENSOR_COUNT; i++){
         min_angles[i] = 10000;
         max_angles[i] = -10000;
+        settleTimes[i] = acquisitionConfig.settle_us;
     }
+
+    digitalWrite(S0, LOW);
+    digitalWrite(S1, LOW);
+    digitalWrite(S2, LOW);
+    digitalWrite(S3, LOW);
+    selectedChannel = 0;
+
+    sensorHealthReset();
+    driftCompensationReset();
+    crosstalkReset();
+    calibrationTableSetup();
+    setAcquisitionConfig(acquisitionConfig);
 }
 
-float poly(double x, double a,double b,double c){
-    return a*pow(x,2)+b*x+c;
+bool setAcquisitionConfig(const AcquisitionConfig& config){
+    acquisitionConfig = config;
+    acquisitionConfig.samples = constrain(config.samples, 1, ADC_BURST_MAX_SAMPLES);
+
+    if (acquisitionConfig.mode == ACQ_BURST){
+        if (adcBurstSetup(HALL_SENSOR_PIN, acquisitionConfig.samples)){
+            return true;
+        }
+        Serial.println("ADC burst mode unavailable, using single conversions");
+        acquisitionConfig.mode = ACQ_SINGLE;
+        return false;
+    }
+
+    adcBurstEnd();
+    return true;
 }
 
-void calibrateHallEffectSensors(){
+// Samples the currently selected mux channel into the raw value arrays
+static void sampleChannel(uint8_t i){
+    if (acquisitionConfig.mode == ACQ_BURST){
+        uint16_t samples[ADC_BURST_MAX_SAMPLES];
+        uint8_t n = adcBurstRead(samples, acquisitionConfig.budget_us);
+        missed[i] = n == 0;
+        if (n == 0){
+            // Budget ran out or the DMA timed out
+            acquisitionMisses[i]++;
+            return;
+        }
+        uint32_t q4 = acquisitionConfig.reducer == REDUCE_MEDIAN
+            ? adcReduceMedianQ4(samples, n)
+            : adcReduceTrimmedMeanQ4(samples, n);
+        adcCodes[i] = (q4 + 8) >> 4;
+        q4 = adcCalibrateQ4(q4);
+        rawValsQ4[i] = q4;
+        rawVals[i] = (q4 + 8) >> 4;
+        return;
+    }
+
+    analog.update();
+    missed[i] = false;
+    rawVals[i] = analog.getRawValue();
+    rawValsQ4[i] = (uint32_t)rawVals[i] << 4;
+    adcCodes[i] = rawVals[i];
+}
+
+void selectMuxChannel(uint8_t channel){
+    uint8_t changed = channel ^ selectedChannel;
+    if (changed & 0b0001) digitalWrite(S0, channel & 0b1);
+    if (changed & 0b0010) digitalWrite(S1, (channel>>1) & 0b1);
+    if (changed & 0b0100) digitalWrite(S2, (channel>>2) & 0b1);
+    if (changed & 0b1000) digitalWrite(S3, (channel>>3) & 0b1);
+    selectedChannel = channel;
+}
+
+static uint16_t median3(uint16_t a, uint16_t b, uint16_t c){
+    if (a > b){
+        uint16_t t = a; a = b; b = t;
+    }
+    return c < a ? a : c > b ? b : c;
+}
+
+// Time from switching channel in until every later sample stays within tolerance
+// of the settled value. Uses one-shot conversions for the finest time resolution.
+// The tolerance grows with the noise of the settled tail, and samples are compared
+// as a running median of three, so a single noisy conversion late in the window
+// does not read as "still settling".
+static uint16_t measureSettleTime(uint8_t from, uint8_t to){
+    const uint16_t maxSamples = 128;
+    uint16_t values[maxSamples];
+    uint16_t times[maxSamples];
+
+    selectMuxChannel(from);
+    delayMicroseconds(MUX_SETTLE_MAX_US);
+
+    uint16_t n = 0;
+    uint32_t start = micros();
+    selectMuxChannel(to);
+    uint32_t elapsed = 0;
+    while (n < maxSamples && elapsed < MUX_SETTLE_MAX_US){
+        values[n] = analogRead(HALL_SENSOR_PIN);
+        elapsed = micros() - start;
+        times[n] = elapsed;
+        n++;
+    }
+    if (n < 8){
+        return MUX_SETTLE_MAX_US;
+    }
+
+    // Settled value and its noise: mean and standard deviation of the last quarter
+    uint16_t tail = n / 4;
+    uint32_t sum = 0;
+    uint64_t sumSq = 0;
+    for (uint16_t i = n - tail; i < n; i++){
+        sum += values[i];
+        sumSq += (uint32_t)values[i] * values[i];
+    }
+    int32_t settled = sum / tail;
+    float variance = (float)sumSq / tail - (float)settled * settled;
+    float sigma = variance > 0 ? sqrtf(variance) : 0;
+    int32_t tolerance = max((int32_t)MUX_SETTLE_TOLERANCE, (int32_t)(MUX_SETTLE_NOISE_K * sigma + 0.5f));
+
+    // Walk backwards to the last filtered sample outside the tolerance band
+    for (int16_t i = n - 2; i >= 1; i--){
+        int32_t filtered = median3(values[i - 1], values[i], values[i + 1]);
+        if (abs(filtered - settled) > tolerance){
+            return times[i + 1];
+        }
+    }
+    return 0;
+}
+
+// Shrinks the settle times in proportion so a scan, settling plus conversions,
+// fits MUX_SCAN_BUDGET_US. Returns false if they already fit.
+static bool capMuxSettleTimes(){
+    uint32_t total = 0;
     for (uint8_t i = 0; i < SENSOR_COUNT; i++){
-        if(proto_angles[i] < min_angles[i]){
-            min_angles[i] = proto_angles[i];
-        } else if(proto_angles[i] > max_angles[i]){
-            max_angles[i] = proto_angles[i];
+        total += settleTimes[i];
+    }
+    uint32_t conversions = (uint32_t)SENSOR_COUNT * acquisitionConfig.budget_us;
+    uint32_t allowed = conversions < MUX_SCAN_BUDGET_US ? MUX_SCAN_BUDGET_US - conversions : 0;
+    if (total <= allowed){
+        return false;
+    }
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++){
+        settleTimes[i] = (uint32_t)settleTimes[i] * allowed / total;
+    }
+    LOG(LOG_MUX_SETTLE_CAPPED, total, allowed);
+    return true;
+}
+
+static bool muxSettleCapped = false;
+
+uint32_t characterizeMuxSettling(){
+    // One-shot reads give microsecond resolution; the burst driver is restored afterwards
+    AcquisitionMode mode = acquisitionConfig.mode;
+    if (mode == ACQ_BURST){
+        adcBurstEnd();
+    }
+
+    uint32_t total = 0;
+    for (uint8_t k = 0; k < SENSOR_COUNT; k++){
+        uint8_t channel = scanOrder[k];
+        uint8_t previous = scanOrder[(k + SENSOR_COUNT - 1) % SENSOR_COUNT];
+
+        // Median of the trials: one disturbed trial does not set the channel's time
+        uint16_t trials[MUX_SETTLE_TRIALS];
+        for (uint8_t trial = 0; trial < MUX_SETTLE_TRIALS; trial++){
+            uint16_t t = measureSettleTime(previous, channel);
+            uint8_t j = trial;
+            for (; j > 0 && trials[j - 1] > t; j--){
+                trials[j] = trials[j - 1];
+            }
+            trials[j] = t;
         }
+        settleTimes[channel] = min(trials[MUX_SETTLE_TRIALS / 2] + MUX_SETTLE_MARGIN_US, MUX_SETTLE_MAX_US);
+    }
+
+    if (mode == ACQ_BURST){
+        setAcquisitionConfig(acquisitionConfig);
+    }
+
+    // The measured times are stored; the cap is applied on every load
+    Preferences prefs;
+    if (prefs.begin(MUX_SETTLE_NVS_NAMESPACE, false)){
+        prefs.putBytes(MUX_SETTLE_NVS_KEY, settleTimes, sizeof(settleTimes));
+        prefs.end();
+    }
+    muxSettleCapped = capMuxSettleTimes();
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++){
+        total += settleTimes[i];
     }
+    return total;
 }
 
-void measureHallEffectSensors()
-{
+bool restoreMuxSettleTimes(){
+    Preferences prefs;
+    if (!prefs.begin(MUX_SETTLE_NVS_NAMESPACE, true)){
+        return false;
+    }
+    uint16_t stored[SENSOR_COUNT];
+    bool loaded = prefs.getBytesLength(MUX_SETTLE_NVS_KEY) == sizeof(stored) &&
+                  prefs.getBytes(MUX_SETTLE_NVS_KEY, stored, sizeof(stored)) == sizeof(stored);
+    prefs.end();
+    for (uint8_t i = 0; loaded && i < SENSOR_COUNT; i++){
+        loaded = stored[i] <= MUX_SETTLE_MAX_US;
+    }
+    if (loaded){
+        memcpy(settleTimes, stored, sizeof(settleTimes));
+        muxSettleCapped = capMuxSettleTimes();
+    }
+    return loaded;
+}
+
+void printMuxSettleTimes(){
+    uint32_t total = 0;
     for (uint8_t i = 0; i < SENSOR_COUNT; i++){
-        digitalWrite(S0, i & 0b1);
-        digitalWrite(S1, (i>>1) & 0b1);
-        digitalWrite(S2, (i>>2) & 0b1);
-        digitalWrite(S3, (i>>3) & 0b1);
+        Serial.print(">Settle_");
+        Serial.print(i);
+        Serial.print(":");
+        Serial.println(settleTimes[i]);
+        total += settleTimes[i];
+    }
+    Serial.print("Total mux dwell per scan (us): ");
+    Serial.println(total);
+    if (muxSettleCapped){
+        Serial.println("Measured settle times exceed the scan budget and were scaled down");
+    }
+}
 
-        delay(5); //not sure if this is necessary
+void printAcquisitionStats(){
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++){
+        total += acquisitionMisses[i];
+    }
+    Serial.print("ADC missed conversions: ");
+    Serial.print(total);
+    if (total > 0){
+        Serial.print(" (channel:count");
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++){
+            if (acquisitionMisses[i] > 0){
+                Serial.print(" ");
+                Serial.print(i);
+                Serial.print(":");
+                Serial.print(acquisitionMisses[i]);
+            }
+        }
+        Serial.print(")");
+    }
+    Serial.println();
+}
 
-        analog.update();
-        int32_t rawVal = analog.getRawValue();
-        rawVals[i] = rawVal;
-     }
+float poly(double x, double a,double b,double c){
+    return a*pow(x,2)+b*x+c;
+}
 
+void calibrateHallEffectSensors(){
     for (uint8_t i = 0; i < SENSOR_COUNT; i++){
-        float angle = poly(rawVals[i],polyVals[i][0],polyVals[i][1],polyVals[i][2]);
-        proto_angles[i] = angle;
+        calibrateHallEffectSensor(i);
+    }
+}
+
+void calibrateHallEffectSensor(uint8_t i){
+    if(proto_angles[i] < min_angles[i]){
+        min_angles[i] = proto_angles[i];
+    } else if(proto_angles[i] > max_angles[i]){
+        max_angles[i] = proto_angles[i];
     }
+}
+
+void compensateHallEffectSensor(uint8_t i){
+    // A missed conversion repeats the last value; it is counted, not judged as flat-lining
+    if (!missed[i]){
+        sensorHealthUpdate(i, adcCodes[i]);
+    }
+    compensatedQ4[i] = driftCompensate(i, rawValsQ4[i]);
+}
+
+void convertHallEffectBlock(uint8_t finger){
+    crosstalkDecouple(finger, compensatedQ4, decoupledQ4);
+
+    uint8_t first = finger == 0 ? 0 : 1 + 3 * finger;
+    uint8_t last = finger == 0 ? 3 : first + 2;
+    for (uint8_t i = first; i <= last; i++){
+        proto_angles[i] = calibrationAngle(i, decoupledQ4[i]);
+    }
+}
+
+void endHallEffectFrame(){
+    driftEndFrame();
+    crosstalkEndFrame(compensatedQ4);
+}
+
+void scanHallEffectSensors(ChannelProcessor process){
+    uint8_t channel = scanOrder[0];
+    selectMuxChannel(channel);
+    uint32_t settledAt = micros() + settleTimes[channel];
+
+    for (uint8_t k = 0; k < SENSOR_COUNT; k++){
+        while ((int32_t)(micros() - settledAt) < 0){
+        }
+        sampleChannel(channel);
+
+        // Switch the mux straight away so the next channel settles while this one is processed
+        uint8_t current = channel;
+        if (k + 1 < SENSOR_COUNT){
+            channel = scanOrder[k + 1];
+            selectMuxChannel(channel);
+            settledAt = micros() + settleTimes[channel];
+        }
+
+        if (process != nullptr){
+            process(current);
+        }
+    }
+}
+
+void measureHallEffectSensors()
+{
+    scanHallEffectSensors(compensateHallEffectSensor);
+    for (uint8_t finger = 0; finger < CROSSTALK_BLOCK_COUNT; finger++){
+        convertHallEffectBlock(finger);
+    }
+    endHallEffectFrame();
+
     //jank solution to having the angles for the thumb backwards
     //TODO remove with glove v2
     // proto_angles[12] = 150-proto_angles[12];
@@ -87,4 +378,3 @@ void measureHallEffectSensors()
     // proto_angles[14] = 150-proto_angles[14];
     // proto_angles[15] = 150-proto_angles[15];
 }
-
@@ -13,7 +13,53 @@
 
 #define SENSOR_COUNT 16
 
+#define HALL_SENSOR_PIN A2
+
+// Mux settle-time characterization
+#define MUX_SETTLE_MAX_US 2000      // Longest settling window observed per channel
+#define MUX_SETTLE_TOLERANCE 6      // Counts from the settled value still considered settled, at least
+#define MUX_SETTLE_NOISE_K 4        // ... or this many standard deviations of the settled noise
+#define MUX_SETTLE_MARGIN_US 20     // Added on top of the worst measured settle time
+#define MUX_SETTLE_TRIALS 3         // Switch-ins measured per channel, the median is kept
+#define MUX_SCAN_BUDGET_US 4000     // Settling plus conversions per scan; the sampler period is 5000 us at 200 Hz
+
+// Acquisition defaults. K = 8 conversions at 80 kHz take 100 us of the budget
+#define ACQ_DEFAULT_SETTLE_US 80    // Until characterizeMuxSettling() runs
+#define ACQ_DEFAULT_BUDGET_US 150
+static_assert(SENSOR_COUNT * (ACQ_DEFAULT_SETTLE_US + ACQ_DEFAULT_BUDGET_US) <= MUX_SCAN_BUDGET_US,
+              "Default acquisition does not fit the scan budget");
+#define MUX_SETTLE_NVS_NAMESPACE "mux"
+#define MUX_SETTLE_NVS_KEY "settle"
+
+// Single: one ResponsiveAnalogRead conversion per channel (original behaviour)
+// Burst: K DMA conversions per channel reduced to one outlier-free value
+enum AcquisitionMode {
+    ACQ_SINGLE = 0,
+    ACQ_BURST = 1
+};
+
+enum BurstReducer {
+    REDUCE_MEDIAN = 0,
+    REDUCE_TRIMMED_MEAN = 1
+};
+
+struct AcquisitionConfig {
+    AcquisitionMode mode;
+    uint8_t samples;        // K conversions per channel in burst mode
+    BurstReducer reducer;
+    uint16_t settle_us;     // Mux settle time used until characterizeMuxSettling() runs
+    uint16_t budget_us;     // Max time spent converting one channel
+};
+
+extern AcquisitionConfig acquisitionConfig;
+
 extern int32_t rawVals[SENSOR_COUNT];
+extern uint32_t rawValsQ4[SENSOR_COUNT];      // Reduced reading in 1/16 counts, eFuse-corrected in burst mode
+extern uint32_t acquisitionMisses[SENSOR_COUNT]; // Burst reads that returned no conversion, since boot
+extern uint16_t settleTimes[SENSOR_COUNT];   // Per-channel settle time in microseconds
+extern uint32_t compensatedQ4[SENSOR_COUNT];  // Drift-compensated reading in 1/16 counts, before crosstalk removal
+extern uint32_t decoupledQ4[SENSOR_COUNT];    // Crosstalk removed too; what the calibration tables convert
+extern const uint8_t scanOrder[SENSOR_COUNT]; // Gray-code order: one select line toggles per step
 extern float proto_angles[SENSOR_COUNT];
 extern float min_angles[SENSOR_COUNT];
 extern float max_angles[SENSOR_COUNT];
@@ -29,11 +75,83 @@ void hallEffectSensorsSetup();
  */
 void sendData();
 
+typedef void (*ChannelProcessor)(uint8_t channel);
+
 /**
  * Reads the raw angle values, adjusts them, and stores them in the proto_angles array
  */
 void measureHallEffectSensors();
 void calibrateHallEffectSensors();
+void calibrateHallEffectSensor(uint8_t i);
+
+/**
+ * Updates sensor health and compensatedQ4[i] from the latest raw reading of channel i.
+ */
+void compensateHallEffectSensor(uint8_t i);
+
+/**
+ * Removes the crosstalk between the sensors of one finger and updates their proto_angles
+ * through the calibration tables.
+ * Every sensor of the finger must have been compensated this frame.
+ * @param finger 0 thumb (sensors 0-3) .. 4 pinky (sensors 13-15)
+ */
+void convertHallEffectBlock(uint8_t finger);
+
+/**
+ * Per-frame work of drift compensation and crosstalk capture; call once every
+ * sensor of a frame has been compensated.
+ */
+void endHallEffectFrame();
+
+/**
+ * Scans every channel in scanOrder. As soon as channel k is sampled the mux is
+ * switched to channel k+1, and process(k) runs while that channel settles, so
+ * per-channel math costs no extra scan time as long as it fits in the settle window.
+ * @param process Called once per channel after its raw value is stored; may be nullptr
+ */
+void scanHallEffectSensors(ChannelProcessor process);
+
+/**
+ * Prints how many burst reads per channel returned no conversion (budget
+ * exhausted or DMA timeout). Such a channel keeps its previous value that frame.
+ */
+void printAcquisitionStats();
+
+/**
+ * Switches the acquisition mode. Falls back to ACQ_SINGLE if the ADC
+ * continuous driver cannot be started.
+ * @return true if the requested mode is active
+ */
+bool setAcquisitionConfig(const AcquisitionConfig& config);
+
+/**
+ * Drives the mux select lines for a channel, toggling only the lines that differ
+ * from the currently selected channel.
+ */
+void selectMuxChannel(uint8_t channel);
+
+/**
+ * Measures how long each mux channel takes to settle after being switched in from
+ * its predecessor in scanOrder and stores the result (plus margin) in settleTimes
+ * and in NVS. Takes roughly SENSOR_COUNT * MUX_SETTLE_TRIALS * 2 * MUX_SETTLE_MAX_US;
+ * call when no times are stored or whenever the sensors or wiring change. If the
+ * times do not fit MUX_SCAN_BUDGET_US next to the conversions they are scaled
+ * down to fit, and LOG_MUX_SETTLE_CAPPED reports it.
+ * @return Sum of the per-channel settle times in use, i.e. the dwell of one scan
+ */
+uint32_t characterizeMuxSettling();
+
+/**
+ * Loads the settle times the last characterizeMuxSettling() stored, capped like
+ * its result.
+ * @return false if none are stored; settleTimes is left unchanged
+ */
+bool restoreMuxSettleTimes();
+
+/**
+ * Prints the per-channel settle times over Serial
+ */
+void printMuxSettleTimes();
 
 float poly(double x, double a,double b,double c);
 
@@ -0,0 +1,145 @@
+#ifndef HAND_FRAME_H
+#define HAND_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Canonical wire form of one glove frame, shared by the firmware and the host
+// tools. Plain C++ with no Arduino dependencies.
+//
+// All fields are little endian and packed; the static_asserts below pin every
+// offset. The header carries the version and the total size, so:
+//   - new fields are only ever appended, and bump HAND_FRAME_VERSION
+//   - decoders read the fields they know and skip the rest using size
+//   - fields past the end of an older, shorter frame read as absent
+// Decoding is done in place through hand::FrameView; nothing is copied out
+// until a field is read.
+
+#define HAND_FRAME_MAGIC 0x48               // 'H'
+#define HAND_FRAME_VERSION 1
+#define HAND_FRAME_JOINT_COUNT 16
+
+#define HAND_FRAME_QUAT_SCALE 16384.0f      // Quaternion components in Q14
+#define HAND_FRAME_LINEAR_SCALE 256.0f      // Linear acceleration in 1/256 m/s^2
+#define HAND_FRAME_GYRO_SCALE 512.0f        // Angular velocity in 1/512 rad/s
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "HandFrame writers assume a little-endian target"
+#endif
+
+namespace hand {
+
+#pragma pack(push, 1)
+struct FrameHeader {
+    uint8_t magic;          // HAND_FRAME_MAGIC
+    uint8_t version;        // HAND_FRAME_VERSION of the writer
+    uint16_t size;          // Total frame bytes including this header
+};
+
+/**
+ * Version 1. Append new fields at the end only.
+ */
+struct Frame {
+    FrameHeader header;
+    uint32_t timestamp_us;                  // Glove micros() at capture
+    uint32_t sequence;                      // Capture tick number
+    int16_t joints[HAND_FRAME_JOINT_COUNT]; // Adjusted joint angles
+    int16_t quat[4];                        // x, y, z, w
+    int16_t linear[3];                      // x, y, z
+    int16_t gyro[3];                        // x, y, z
+    uint16_t buttons;                       // Bit i = gesture button i
+    uint16_t fault_mask;                    // Bit i = finger sensor i faulted
+    uint8_t imu_status;                     // IMU_STATUS_* flags
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FrameHeader) == 4, "HandFrame header layout changed");
+static_assert(offsetof(Frame, timestamp_us) == 4, "HandFrame layout changed");
+static_assert(offsetof(Frame, sequence) == 8, "HandFrame layout changed");
+static_assert(offsetof(Frame, joints) == 12, "HandFrame layout changed");
+static_assert(offsetof(Frame, quat) == 44, "HandFrame layout changed");
+static_assert(offsetof(Frame, linear) == 52, "HandFrame layout changed");
+static_assert(offsetof(Frame, gyro) == 58, "HandFrame layout changed");
+static_assert(offsetof(Frame, buttons) == 64, "HandFrame layout changed");
+static_assert(offsetof(Frame, fault_mask) == 66, "HandFrame layout changed");
+static_assert(offsetof(Frame, imu_status) == 68, "HandFrame layout changed");
+static_assert(sizeof(Frame) == 70, "HandFrame layout changed");
+
+// Size of the smallest frame a decoder accepts: everything up to imu_status
+#define HAND_FRAME_MIN_SIZE (offsetof(hand::Frame, imu_status) + 1)
+
+inline void initFrame(Frame* frame) {
+    memset(frame, 0, sizeof(*frame));
+    frame->header.magic = HAND_FRAME_MAGIC;
+    frame->header.version = HAND_FRAME_VERSION;
+    frame->header.size = sizeof(Frame);
+}
+
+inline int16_t toFixed(float value, float scale) {
+    float scaled = value * scale;
+    if (scaled >= 32767.0f) return INT16_MAX;
+    if (scaled <= -32768.0f) return INT16_MIN;
+    return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
+
+/**
+ * Read-only view over a received frame. Fields are loaded from the buffer on
+ * access with explicit little-endian reads, so the buffer needs no alignment
+ * and the host's byte order does not matter.
+ */
+class FrameView {
+public:
+    /**
+     * @param len Bytes available at buf; the frame may be followed by others
+     */
+    FrameView(const uint8_t* buf, size_t len) : buf_(buf), size_(0) {
+        if (len < sizeof(FrameHeader) || buf[0] != HAND_FRAME_MAGIC) {
+            return;
+        }
+        size_t size = load16(offsetof(FrameHeader, size));
+        if (size < HAND_FRAME_MIN_SIZE || size > len) {
+            return;
+        }
+        size_ = size;
+    }
+
+    bool valid() const { return size_ != 0; }
+    uint8_t version() const { return buf_[offsetof(FrameHeader, version)]; }
+
+    /**
+     * Bytes this frame occupies, including fields newer than this decoder
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * True if the writer's frame is long enough to contain the field at offset
+     */
+    bool has(size_t offset, size_t bytes) const { return offset + bytes <= size_; }
+
+    uint32_t timestampUs() const { return load32(offsetof(Frame, timestamp_us)); }
+    uint32_t sequence() const { return load32(offsetof(Frame, sequence)); }
+    int16_t joint(size_t i) const { return (int16_t)load16(offsetof(Frame, joints) + 2 * i); }
+    float quat(size_t i) const { return (int16_t)load16(offsetof(Frame, quat) + 2 * i) / HAND_FRAME_QUAT_SCALE; }
+    float linear(size_t i) const { return (int16_t)load16(offsetof(Frame, linear) + 2 * i) / HAND_FRAME_LINEAR_SCALE; }
+    float gyro(size_t i) const { return (int16_t)load16(offsetof(Frame, gyro) + 2 * i) / HAND_FRAME_GYRO_SCALE; }
+    uint16_t buttons() const { return load16(offsetof(Frame, buttons)); }
+    uint16_t faultMask() const { return load16(offsetof(Frame, fault_mask)); }
+    uint8_t imuStatus() const { return buf_[offsetof(Frame, imu_status)]; }
+
+private:
+    uint16_t load16(size_t offset) const {
+        return buf_[offset] | (buf_[offset + 1] << 8);
+    }
+    uint32_t load32(size_t offset) const {
+        return (uint32_t)load16(offset) | ((uint32_t)load16(offset + 2) << 16);
+    }
+
+    const uint8_t* buf_;
+    size_t size_;
+};
+
+}  // namespace hand
+
+#endif
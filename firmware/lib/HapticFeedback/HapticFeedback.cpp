@@ -0,0 +1,197 @@
+#include "HapticFeedback.h"
+
+static const int8_t hapticPins[HAPTIC_CHANNEL_COUNT] = HAPTIC_PINS;
+
+uint16_t hapticDuty[HAPTIC_CHANNEL_COUNT];
+HapticLatencyStats hapticLatency = {0, 0, UINT32_MAX, 0, 0, 0};
+
+// Single-producer mailbox guarded by a sequence counter: odd while the
+// receive callback is writing, even once the command is complete.
+static struct {
+    volatile uint32_t seq;
+    uint8_t forces[HAPTIC_CHANNEL_COUNT];
+    uint32_t echo_us;
+    uint32_t recv_us;
+} mailbox;
+
+static uint32_t consumedSeq = 0;
+static uint16_t targetDuty[HAPTIC_CHANNEL_COUNT];
+static uint32_t lastCommandMs = 0;
+static uint32_t lastStepUs = 0;
+static bool commandActive = false;
+static volatile uint8_t applyBusy = 0;
+
+// Maps a 0-255 force to an actuator duty inside the safety envelope
+static uint16_t shapeForce(uint8_t force) {
+    if (force <= HAPTIC_FORCE_DEADBAND) {
+        return 0;
+    }
+    uint32_t span = HAPTIC_MAX_DUTY - HAPTIC_MIN_DUTY;
+    uint32_t duty = HAPTIC_MIN_DUTY + (uint32_t)(force - HAPTIC_FORCE_DEADBAND) * span / (255 - HAPTIC_FORCE_DEADBAND);
+    return duty > HAPTIC_MAX_DUTY ? HAPTIC_MAX_DUTY : duty;
+}
+
+static void writeDuty(uint8_t i, uint16_t duty) {
+    if (duty > HAPTIC_MAX_DUTY) {
+        duty = HAPTIC_MAX_DUTY;
+    }
+    hapticDuty[i] = duty;
+    if (hapticPins[i] >= 0) {
+        ledcWrite(HAPTIC_LEDC_FIRST_CHANNEL + i, duty);
+    }
+}
+
+static void recordLatency(uint32_t echo_us, uint32_t recv_us, uint32_t now) {
+    hapticLatency.apply_us = now - recv_us;
+    if (echo_us == 0) {
+        return;
+    }
+
+    uint32_t rtt = now - echo_us;
+    hapticLatency.last_us = rtt;
+    if (rtt < hapticLatency.min_us) hapticLatency.min_us = rtt;
+    if (rtt > hapticLatency.max_us) hapticLatency.max_us = rtt;
+    if (hapticLatency.samples == 0) {
+        hapticLatency.avg_us = rtt;
+    } else {
+        hapticLatency.avg_us = hapticLatency.avg_us + ((int32_t)(rtt - hapticLatency.avg_us) >> 4);
+    }
+    hapticLatency.samples++;
+}
+
+void hapticSetup() {
+    for (uint8_t i = 0; i < HAPTIC_CHANNEL_COUNT; i++) {
+        if (hapticPins[i] >= 0) {
+            ledcSetup(HAPTIC_LEDC_FIRST_CHANNEL + i, HAPTIC_PWM_FREQ, HAPTIC_PWM_RESOLUTION);
+            ledcAttachPin(hapticPins[i], HAPTIC_LEDC_FIRST_CHANNEL + i);
+        }
+        targetDuty[i] = 0;
+        writeDuty(i, 0);
+    }
+    mailbox.seq = 0;
+    consumedSeq = 0;
+    commandActive = false;
+    lastStepUs = micros();
+}
+
+void hapticPost(const uint8_t forces[HAPTIC_CHANNEL_COUNT], uint32_t echo_us) {
+    uint32_t seq = mailbox.seq;
+    mailbox.seq = seq + 1;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(mailbox.forces, forces, HAPTIC_CHANNEL_COUNT);
+    mailbox.echo_us = echo_us;
+    mailbox.recv_us = micros();
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    mailbox.seq = seq + 2;
+}
+
+// Copies the newest complete command out of the mailbox, false if none is pending
+static bool takeCommand(uint8_t forces[HAPTIC_CHANNEL_COUNT], uint32_t* echo_us, uint32_t* recv_us) {
+    for (uint8_t attempt = 0; attempt < 4; attempt++) {
+        uint32_t before = mailbox.seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (before == consumedSeq) {
+            return false;
+        }
+        if (before & 1) {
+            continue; // Writer is mid-update
+        }
+
+        memcpy(forces, mailbox.forces, HAPTIC_CHANNEL_COUNT);
+        *echo_us = mailbox.echo_us;
+        *recv_us = mailbox.recv_us;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (mailbox.seq == before) {
+            consumedSeq = before;
+            return true;
+        }
+    }
+    return false;
+}
+
+void hapticApply() {
+    if (__atomic_exchange_n(&applyBusy, 1, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    uint32_t now = micros();
+    uint8_t forces[HAPTIC_CHANNEL_COUNT];
+    uint32_t echo_us, recv_us;
+    bool fresh = takeCommand(forces, &echo_us, &recv_us);
+
+    if (fresh) {
+        for (uint8_t i = 0; i < HAPTIC_CHANNEL_COUNT; i++) {
+            targetDuty[i] = shapeForce(forces[i]);
+        }
+        lastCommandMs = millis();
+        commandActive = true;
+    } else if (commandActive && millis() - lastCommandMs > HAPTIC_TIMEOUT_MS) {
+        // Link lost: ramp everything down rather than holding the last force
+        for (uint8_t i = 0; i < HAPTIC_CHANNEL_COUNT; i++) {
+            targetDuty[i] = 0;
+        }
+        commandActive = false;
+    }
+
+    // Slew limit; always allow at least one step so a fresh command moves immediately
+    uint32_t elapsed = now - lastStepUs;
+    uint32_t maxStep = (uint32_t)HAPTIC_SLEW_PER_MS * elapsed / 1000;
+    if (maxStep < 1) {
+        maxStep = fresh ? HAPTIC_SLEW_PER_MS : 0;
+    }
+    if (maxStep > 0) {
+        lastStepUs = now;
+    }
+
+    for (uint8_t i = 0; i < HAPTIC_CHANNEL_COUNT; i++) {
+        int32_t current = hapticDuty[i];
+        int32_t delta = (int32_t)targetDuty[i] - current;
+        if (delta == 0) {
+            continue;
+        }
+        if (delta > (int32_t)maxStep) delta = maxStep;
+        if (delta < -(int32_t)maxStep) delta = -(int32_t)maxStep;
+        if (delta != 0) {
+            writeDuty(i, current + delta);
+        }
+    }
+
+    if (fresh) {
+        recordLatency(echo_us, recv_us, micros());
+    }
+
+    __atomic_store_n(&applyBusy, 0, __ATOMIC_RELEASE);
+}
+
+void hapticUpdate() {
+    hapticApply();
+}
+
+void hapticRelease() {
+    for (uint8_t i = 0; i < HAPTIC_CHANNEL_COUNT; i++) {
+        targetDuty[i] = 0;
+        writeDuty(i, 0);
+    }
+    commandActive = false;
+}
+
+void printHapticLatency() {
+    Serial.print("Haptic duty:");
+    for (uint8_t i = 0; i < HAPTIC_CHANNEL_COUNT; i++) {
+        Serial.print(" ");
+        Serial.print(hapticDuty[i]);
+    }
+    Serial.println();
+    if (hapticLatency.samples == 0) {
+        Serial.println("Haptic RTT: no echoed packets yet");
+        return;
+    }
+    Serial.print("Haptic RTT (us) last: "); Serial.print(hapticLatency.last_us);
+    Serial.print(" avg: "); Serial.print(hapticLatency.avg_us);
+    Serial.print(" min: "); Serial.print(hapticLatency.min_us);
+    Serial.print(" max: "); Serial.print(hapticLatency.max_us);
+    Serial.print(" recv->actuate: "); Serial.println(hapticLatency.apply_us);
+}
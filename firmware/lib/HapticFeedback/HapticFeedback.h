@@ -0,0 +1,77 @@
+#ifndef HAPTIC_FEEDBACK_H
+#define HAPTIC_FEEDBACK_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define HAPTIC_CHANNEL_COUNT 5      // One actuator per finger, matches haptic_packet.forces
+
+// Actuator GPIOs (thumb, index, middle, ring, pinky). -1 leaves a channel unattached.
+// Override with -DHAPTIC_PINS="{...}" in platformio.ini to match the actuator wiring.
+#ifndef HAPTIC_PINS
+#define HAPTIC_PINS {-1, -1, -1, -1, -1}
+#endif
+
+#define HAPTIC_LEDC_FIRST_CHANNEL 0 // LEDC channels HAPTIC_LEDC_FIRST_CHANNEL..+4 are used
+#define HAPTIC_PWM_FREQ 20000       // Above the audible range
+#define HAPTIC_PWM_RESOLUTION 10    // Bits, duty range 0-1023
+#define HAPTIC_PWM_MAX ((1 << HAPTIC_PWM_RESOLUTION) - 1)
+
+// Shaping and safety limits
+#define HAPTIC_FORCE_DEADBAND 8     // Forces at or below this are treated as zero
+#define HAPTIC_MIN_DUTY 120         // Duty needed to overcome actuator stiction
+#define HAPTIC_MAX_DUTY 800         // Hard ceiling, never exceeded regardless of input
+#define HAPTIC_SLEW_PER_MS 64       // Max duty change per millisecond
+#define HAPTIC_TIMEOUT_MS 150       // Release all actuators if the robot goes quiet
+
+struct HapticLatencyStats {
+    uint32_t samples;    // Packets that carried an echoed glove timestamp
+    uint32_t last_us;    // Frame capture -> robot -> actuator round trip
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t avg_us;     // Exponential moving average (1/16)
+    uint32_t apply_us;   // Receive callback -> actuator write, last packet
+};
+
+extern uint16_t hapticDuty[HAPTIC_CHANNEL_COUNT];
+extern HapticLatencyStats hapticLatency;
+
+/**
+ * Attaches the configured actuator pins to LEDC channels and drives them to zero.
+ */
+void hapticSetup();
+
+/**
+ * Publishes a force command into the mailbox. Lock-free and safe to call from
+ * the ESP-NOW receive callback; a newer command simply replaces an unread one.
+ * @param forces HAPTIC_CHANNEL_COUNT force values (0-255)
+ * @param echo_us Glove timestamp echoed back by the robot, 0 if unknown. The robot
+ *                echoes the timestamp_us of the newest FrameCodec frame it decoded,
+ *                i.e. the sampler's micros() at capture, so the round trip includes
+ *                the wait for a packet to fill (GLOVE_FRAMES_PER_PACKET).
+ */
+void hapticPost(const uint8_t forces[HAPTIC_CHANNEL_COUNT], uint32_t echo_us);
+
+/**
+ * Takes the latest command from the mailbox, shapes it and writes the actuator
+ * duties. Called right after hapticPost() in the receive path and again from
+ * the main loop; if both race, the second caller returns without doing anything.
+ */
+void hapticApply();
+
+/**
+ * Runs the slew limiter and the link-loss watchdog. Call once per loop().
+ */
+void hapticUpdate();
+
+/**
+ * Immediately drives every actuator to zero.
+ */
+void hapticRelease();
+
+/**
+ * Prints the actuator duties and round-trip latency statistics over Serial
+ */
+void printHapticLatency();
+
+#endif
@@ -1,4 +1,6 @@
-#include "HapticGLove_ESPNOW.h"
+#include "HapticGlove_ESPNOW.h"
+#include "HapticFeedback.h"
+#include "DeferredLog.h"
 // Start HapticGlove_ESPNOW.c:
 
 uint8_t peer_mac[6];
@@ -8,6 +10,19 @@ int glove_messages_send_attempt = 0;
 int glove_messages_send_success = 0;
 int glove_messages_rcv = 0;
 
+static codec::Encoder frameEncoder;
+static uint8_t framePacket[ESP_NOW_MAX_DATA_LEN];
+static bool framePacketOpen = false;
+static unsigned long syncStartMs = 0;
+static bool syncPending = false;
+static bool espnowUp = false;
+
+// Compressed stream cost since the last glove_printCodecStats()
+static uint32_t codecFrames = 0;
+static uint32_t codecEncodeUs = 0;
+static uint32_t codecEncodeMaxUs = 0;
+static uint32_t codecBytes = 0;
+
 // Function to handle the result of data send
 void GloveOnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
   // Serial.print("\r\nLast Packet Send Status:\t");
@@ -16,11 +31,14 @@ void GloveOnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
 
 // Callback function that will be executed when data is received
 void GloveOnDataRecv(const uint8_t *mac_addr, const uint8_t *incomingData, int len) {  // Changed signature to match expected esp_now_recv_cb_t type
-  if (len == sizeof(glove_inData)) {
-      memcpy(&glove_inData, incomingData, sizeof(glove_inData));
-      // Proceed with processing
+  if (len == sizeof(glove_inData) || len == HAPTIC_PACKET_LEGACY_SIZE) {
+      memset(&glove_inData, 0, sizeof(glove_inData));
+      memcpy(&glove_inData, incomingData, len);
+      // Hand the forces straight to the actuators from the receive path
+      hapticPost(glove_inData.forces, glove_inData.echo_us);
+      hapticApply();
   } else {
-      Serial.println("Received data length does not match expected size.");
+      LOG(LOG_ESPNOW_BAD_LENGTH, len);
   }
   // Serial.print("Bytes received: ");
   // Serial.println(len);
@@ -38,8 +56,15 @@ void GloveOnDataRecv(const uint8_t *mac_addr, const uint8_t *incomingData, int l
   glove_messages_rcv++;
 }
 
-void glove_ESPNOWsetup(uint8_t mac_in[], int baud_rate){
+bool glove_ESPNOWsetup(uint8_t mac_in[], int baud_rate){
   Serial.begin(baud_rate);
+  return glove_ESPNOWsetup(mac_in);
+}
+
+bool glove_ESPNOWsetup(uint8_t mac_in[]){
+  if (espnowUp) {
+    return true;
+  }
 
   glove_messages_send_attempt = 0;
   glove_messages_send_success = 0;
@@ -67,7 +92,7 @@ void glove_ESPNOWsetup(uint8_t mac_in[], int baud_rate){
   // Initialize ESP-NOW
   if (esp_now_init() != ESP_OK) {
     Serial.println("Error initializing ESP-NOW");
-    return;
+    return false;
   }
 
   // Register the send callback function
@@ -85,66 +110,29 @@ void glove_ESPNOWsetup(uint8_t mac_in[], int baud_rate){
   
   if (esp_now_add_peer(&peerInfo) != ESP_OK) {
     Serial.println("Failed to add peer");
-    return;
+    esp_now_deinit();
+    return false;
   }
 
-  // DELAY: enter delay if trying to sync up MAC addresses
-  delay(SYNC_DELAY*1000);
+  // Give the peer SYNC_DELAY to sync up MAC addresses; sending holds off until then
+  syncStartMs = millis();
+  syncPending = true;
+  espnowUp = true;
+  return true;
 }
 
-void glove_ESPNOWsetup(uint8_t mac_in[]){
-  glove_messages_send_attempt = 0;
-  glove_messages_send_success = 0;
-  glove_messages_rcv = 0;
-
-  for(int i=0; i<6; i++){
-    peer_mac[i] = mac_in[i];
+bool glove_ESPNOWsynced(){
+  if (syncPending && millis() - syncStartMs >= SYNC_DELAY*1000UL) {
+    syncPending = false;
   }
+  return !syncPending;
+}
 
-  // Set the WiFi to the mode and channel to be used by ESP-NOW
-  Serial.println("Setting up WiFi...");
-  WiFi.mode(ESPNOW_WIFI_MODE);
-  // WiFi.setChannel(ESPNOW_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE);  // Replaced this line
-  esp_wifi_set_channel(ESPNOW_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE);  // Correct method to set channel on ESP32
-
-  // Wait for the WiFi to start
-  while (!WiFi.status() == WL_CONNECTED) {  // Replaced STA check with WiFi.status() for general WiFi check
-    delay(100);
-  }
-
-  // Print the MAC address of this device
-  Serial.print("MAC Address: ");
-  Serial.println(WiFi.macAddress());
-
-  // Initialize ESP-NOW
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("Error initializing ESP-NOW");
-    return;
-  }
-
-  // Register the send callback function
-  esp_now_register_send_cb(GloveOnDataSent);
-
-  // Register the receive callback function
-  esp_now_register_recv_cb(GloveOnDataRecv);
-
-  // Add the peer (receiver) device
-  esp_now_peer_info_t peerInfo;
-  memset(&peerInfo, 0, sizeof(peerInfo));  // Clear the peer info
-  memcpy(peerInfo.peer_addr, peer_mac, 6); // Set peer MAC address
-  peerInfo.channel = ESPNOW_WIFI_CHANNEL;  // Same WiFi channel as sender
-  peerInfo.encrypt = false;  // No encryption
-  
-  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-    Serial.println("Failed to add peer");
+void glove_sendData(uint8_t fpos[], float wpos[], uint8_t apos[]){
+  if (!glove_ESPNOWsynced()) {
     return;
   }
 
-  // DELAY: enter delay if trying to sync up MAC addresses
-  delay(SYNC_DELAY*1000);
-}
-
-void glove_sendData(uint8_t fpos[], float wpos[], uint8_t apos[]){
   // Set values to send
   for(int j=0; j<16; j++){
     glove_outData.finger_pos[j] = fpos[j];
@@ -167,6 +155,78 @@ void glove_sendData(uint8_t fpos[], float wpos[], uint8_t apos[]){
   }
 }
 
+void glove_flushFrames(){
+  if (!framePacketOpen) {
+    return;
+  }
+  size_t len = frameEncoder.finishPacket();
+  framePacketOpen = false;
+  codecBytes += len;
+  if (len > 0) {
+    esp_now_send(peer_mac, framePacket, len);
+    glove_messages_send_attempt += 1;
+  }
+}
+
+void glove_sendFrame(const codec::Frame& frame){
+  if (!framePacketOpen) {
+    frameEncoder.beginPacket(framePacket, sizeof(framePacket));
+    framePacketOpen = true;
+  }
+  uint32_t start = micros();
+  bool added = frameEncoder.add(frame);
+  uint32_t elapsed = micros() - start;
+  if (!added) {
+    // Packet full: ship it and start the next one with this frame
+    glove_flushFrames();
+    frameEncoder.beginPacket(framePacket, sizeof(framePacket));
+    framePacketOpen = true;
+    start = micros();
+    frameEncoder.add(frame);
+    elapsed += micros() - start;
+  }
+  codecFrames++;
+  codecEncodeUs += elapsed;
+  if (elapsed > codecEncodeMaxUs) {
+    codecEncodeMaxUs = elapsed;
+  }
+  if (frameEncoder.frameCount() >= GLOVE_FRAMES_PER_PACKET) {
+    glove_flushFrames();
+  }
+}
+
+bool EspNowTransport::begin(){
+  // WiFi and the peer stay up once configured, normally at boot for the haptic
+  // receive path; re-activation only resumes sending
+  initialized_ = glove_ESPNOWsetup(peer_);
+  return initialized_;
+}
+
+void EspNowTransport::send(const GloveFrame& frame){
+  codec::Frame fixed;
+  transportToCodecFrame(frame, &fixed);
+  glove_sendFrame(fixed);
+}
+
+void glove_printCodecStats(){
+  if (codecFrames == 0) {
+    Serial.println("Frame codec: no frames encoded, enable ESP-NOW with 'e'");
+    return;
+  }
+  Serial.print("Frame codec: ");
+  Serial.print(codecFrames);
+  Serial.print(" frames, encode us mean ");
+  Serial.print((float)codecEncodeUs / codecFrames, 1);
+  Serial.print(" max ");
+  Serial.print(codecEncodeMaxUs);
+  Serial.print(", bytes per frame ");
+  Serial.println((float)codecBytes / codecFrames, 1);
+  codecFrames = 0;
+  codecEncodeUs = 0;
+  codecEncodeMaxUs = 0;
+  codecBytes = 0;
+}
+
 void glove_monitorSuccess(){
   Serial.println();
   Serial.print("Messages Sent: ");
@@ -2,6 +2,8 @@
 #define HAPTIC_GLOVE_ESPNOW_H
 
 #include "General_ESPNOW.h"
+#include "FrameCodec.h"
+#include "Transport.h"
 // Start HapticGlove_ESPNOW.h: 
 
 // Create an instance of the struct to be sent/received
@@ -14,13 +16,47 @@ extern int glove_messages_send_attempt;
 extern int glove_messages_send_success;
 extern int glove_messages_rcv;
 
-// general glove code needs to initialize ESPNOW
-void glove_ESPNOWsetup(uint8_t mac_in[], int baud_rate); // Starts UART0
-void glove_ESPNOWsetup(uint8_t mac_in[]); // UART0 already started
+// general glove code needs to initialize ESPNOW. Returns false if ESP-NOW or
+// the peer could not be set up; calls after a successful one do nothing.
+bool glove_ESPNOWsetup(uint8_t mac_in[], int baud_rate); // Starts UART0
+bool glove_ESPNOWsetup(uint8_t mac_in[]); // UART0 already started
+
+// Setup returns right away; packets are held back for SYNC_DELAY after it
+bool glove_ESPNOWsynced();
 
 // general glove code has access to sendData function
 void glove_sendData(uint8_t fpos[], float wpos[], uint8_t apos[]);
 
+// Compressed stream: frames are batched into FrameCodec packets. A packet is
+// sent once it holds GLOVE_FRAMES_PER_PACKET frames or the next frame no
+// longer fits; larger batches save airtime at the cost of latency.
+#define GLOVE_FRAMES_PER_PACKET 4
+void glove_sendFrame(const codec::Frame& frame);
+void glove_flushFrames(); // Sends a partially filled packet right away
+
+// Prints the measured encode time per frame (mean and max, in micros(); the
+// max includes any preemption by the sampler) and packet bytes per frame
+// since the last call, then starts over.
+void glove_printCodecStats();
+
+// Transport backend for the compressed stream. begin() brings up WiFi and
+// ESP-NOW for the given peer unless that already happened at boot, and fails
+// if they cannot be set up. It returns without waiting out SYNC_DELAY;
+// ready() stays false until then.
+class EspNowTransport : public Transport {
+public:
+    explicit EspNowTransport(const uint8_t peer[6]) { memcpy(peer_, peer, 6); }
+    const char* name() const override { return "ESP-NOW"; }
+    bool begin() override;
+    void end() override { glove_flushFrames(); }
+    bool ready() const override { return initialized_ && glove_ESPNOWsynced(); }
+    void send(const GloveFrame& frame) override;
+
+private:
+    uint8_t peer_[6];
+    bool initialized_ = false;
+};
+
 // receive data function will call general arm code
 
 void glove_monitorSuccess();
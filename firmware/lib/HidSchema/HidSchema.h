@@ -0,0 +1,366 @@
+#ifndef HID_SCHEMA_H
+#define HID_SCHEMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <array>
+
+// Compile-time HID report schema.
+//
+// A report is described once as a constexpr array of hid::Field. From it the
+// compiler generates the report descriptor bytes (hid::Descriptor), the packed
+// report buffer and the bit offsets used to fill it (hid::Report), so the
+// descriptor and the bytes on the wire cannot drift apart.
+//
+//   struct MyReport {
+//       static constexpr uint8_t id = 1;
+//       static constexpr hid::Field fields[] = {
+//           hid::buttons(8),
+//           hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_X),
+//       };
+//   };
+//   constexpr auto& desc = hid::Descriptor<hid::PAGE_GENERIC_DESKTOP, hid::USAGE_GAMEPAD, MyReport>::bytes;
+//   hid::Report<MyReport> report;
+//   report.set<1>(200);
+
+namespace hid {
+
+// Usage pages
+static constexpr uint16_t PAGE_GENERIC_DESKTOP = 0x01;
+static constexpr uint16_t PAGE_SIMULATION = 0x02;
+static constexpr uint16_t PAGE_BUTTON = 0x09;
+static constexpr uint16_t PAGE_VENDOR = 0xFF00;
+
+// Generic Desktop usages
+static constexpr uint16_t USAGE_GAMEPAD = 0x05;
+static constexpr uint16_t USAGE_X = 0x30;
+static constexpr uint16_t USAGE_Y = 0x31;
+static constexpr uint16_t USAGE_Z = 0x32;
+static constexpr uint16_t USAGE_RX = 0x33;
+static constexpr uint16_t USAGE_RY = 0x34;
+static constexpr uint16_t USAGE_RZ = 0x35;
+static constexpr uint16_t USAGE_SLIDER = 0x36;
+static constexpr uint16_t USAGE_DIAL = 0x37;
+static constexpr uint16_t USAGE_WHEEL = 0x38;
+static constexpr uint16_t USAGE_VX = 0x40;
+static constexpr uint16_t USAGE_VY = 0x41;
+static constexpr uint16_t USAGE_VZ = 0x42;
+static constexpr uint16_t USAGE_VBRX = 0x43;
+static constexpr uint16_t USAGE_VBRY = 0x44;
+static constexpr uint16_t USAGE_VBRZ = 0x45;
+static constexpr uint16_t USAGE_VNO = 0x46;
+
+// Simulation Controls usages
+static constexpr uint16_t USAGE_AILERON = 0xB0;
+static constexpr uint16_t USAGE_AILERON_TRIM = 0xB1;
+static constexpr uint16_t USAGE_ANTI_TORQUE = 0xB2;
+static constexpr uint16_t USAGE_RUDDER = 0xBA;
+static constexpr uint16_t USAGE_THROTTLE = 0xBB;
+static constexpr uint16_t USAGE_ACCELERATOR = 0xC4;
+static constexpr uint16_t USAGE_BRAKE = 0xC5;
+
+// Input main item flags
+static constexpr uint8_t INPUT_CONSTANT = 0x03;        // Constant, Variable, Absolute
+static constexpr uint8_t INPUT_DATA_VAR_ABS = 0x02;    // Data, Variable, Absolute
+
+struct Field {
+    uint16_t usage_page;
+    uint16_t usage;         // Usage, or Usage Minimum when usage_range is set
+    uint8_t bits;           // Report Size of one element
+    uint8_t count;          // Report Count
+    int32_t logical_min;
+    int32_t logical_max;
+    uint8_t input_flags;
+    bool usage_range;       // Elements use usage .. usage + count - 1
+};
+
+constexpr Field padding(uint8_t bits) {
+    return Field{0, 0, bits, 1, 0, 0, INPUT_CONSTANT, false};
+}
+
+constexpr Field buttons(uint8_t count, uint16_t first = 1) {
+    return Field{PAGE_BUTTON, first, 1, count, 0, 1, INPUT_DATA_VAR_ABS, true};
+}
+
+/**
+ * Unsigned absolute axis spanning the full range of its bit width.
+ */
+constexpr Field axis(uint16_t page, uint16_t usage, uint8_t bits = 8) {
+    return Field{page, usage, bits, 1, 0, bits >= 32 ? INT32_MAX : (int32_t)((1u << bits) - 1), INPUT_DATA_VAR_ABS, false};
+}
+
+/**
+ * Signed absolute axis spanning the full two's complement range of its bit width.
+ */
+constexpr Field signedAxis(uint16_t page, uint16_t usage, uint8_t bits) {
+    return Field{page, usage, bits, 1, bits >= 32 ? INT32_MIN : -(int32_t)(1u << (bits - 1)),
+                 bits >= 32 ? INT32_MAX : (int32_t)((1u << (bits - 1)) - 1), INPUT_DATA_VAR_ABS, false};
+}
+
+namespace detail {
+
+// Short item prefixes with the size bits cleared
+enum : uint8_t {
+    ITEM_INPUT = 0x80,
+    ITEM_COLLECTION = 0xA0,
+    ITEM_END_COLLECTION = 0xC0,
+    ITEM_USAGE_PAGE = 0x04,
+    ITEM_LOGICAL_MIN = 0x14,
+    ITEM_LOGICAL_MAX = 0x24,
+    ITEM_REPORT_SIZE = 0x74,
+    ITEM_REPORT_ID = 0x84,
+    ITEM_REPORT_COUNT = 0x94,
+    ITEM_USAGE = 0x08,
+    ITEM_USAGE_MIN = 0x18,
+    ITEM_USAGE_MAX = 0x28
+};
+
+struct Counter {
+    size_t size = 0;
+    constexpr void push(uint8_t) { size++; }
+};
+
+template <size_t N>
+struct Writer {
+    std::array<uint8_t, N> bytes{};
+    size_t size = 0;
+    constexpr void push(uint8_t b) { bytes[size++] = b; }
+};
+
+template <typename Out>
+constexpr void item(Out& out, uint8_t prefix, uint32_t payload, uint8_t len) {
+    out.push(prefix | (len == 4 ? 3 : len));
+    for (uint8_t i = 0; i < len; i++) {
+        out.push((uint8_t)(payload >> (8 * i)));
+    }
+}
+
+// Unsigned payloads: usages, sizes, counts, report IDs
+template <typename Out>
+constexpr void unsignedItem(Out& out, uint8_t prefix, uint32_t value) {
+    item(out, prefix, value, value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : 4);
+}
+
+// Signed payloads: logical minimum and maximum
+template <typename Out>
+constexpr void signedItem(Out& out, uint8_t prefix, int32_t value) {
+    uint8_t len = (value >= -128 && value <= 127) ? 1 : (value >= -32768 && value <= 32767) ? 2 : 4;
+    item(out, prefix, (uint32_t)value, len);
+}
+
+// Global item state, so each global is only emitted when it changes
+struct State {
+    int32_t usage_page = -1;
+    int64_t logical_min = INT64_MIN;
+    int64_t logical_max = INT64_MIN;
+    int32_t report_size = -1;
+    int32_t report_count = -1;
+};
+
+constexpr bool sameShape(const Field& a, const Field& b) {
+    return a.usage_page == b.usage_page && a.bits == b.bits && a.logical_min == b.logical_min &&
+           a.logical_max == b.logical_max && a.input_flags == b.input_flags;
+}
+
+constexpr bool mergeable(const Field& f) {
+    return f.count == 1 && !f.usage_range && f.input_flags != INPUT_CONSTANT;
+}
+
+template <typename Out>
+constexpr void globals(Out& out, State& st, const Field& f, uint8_t count) {
+    if (f.input_flags != INPUT_CONSTANT) {
+        if (st.usage_page != f.usage_page) {
+            unsignedItem(out, ITEM_USAGE_PAGE, f.usage_page);
+            st.usage_page = f.usage_page;
+        }
+        if (st.logical_min != f.logical_min) {
+            signedItem(out, ITEM_LOGICAL_MIN, f.logical_min);
+            st.logical_min = f.logical_min;
+        }
+        if (st.logical_max != f.logical_max) {
+            signedItem(out, ITEM_LOGICAL_MAX, f.logical_max);
+            st.logical_max = f.logical_max;
+        }
+    }
+    if (st.report_size != f.bits) {
+        unsignedItem(out, ITEM_REPORT_SIZE, f.bits);
+        st.report_size = f.bits;
+    }
+    if (st.report_count != count) {
+        unsignedItem(out, ITEM_REPORT_COUNT, count);
+        st.report_count = count;
+    }
+}
+
+template <typename Out>
+constexpr void report(Out& out, State& st, uint8_t id, const Field* fields, size_t n) {
+    if (id != 0) {
+        unsignedItem(out, ITEM_REPORT_ID, id);
+    }
+    size_t i = 0;
+    while (i < n) {
+        const Field& f = fields[i];
+
+        // Consecutive single-element fields of the same shape share one Input item
+        size_t run = 1;
+        if (mergeable(f)) {
+            while (i + run < n && mergeable(fields[i + run]) && sameShape(f, fields[i + run])) {
+                run++;
+            }
+        }
+
+        uint8_t count = run > 1 ? (uint8_t)run : f.count;
+        globals(out, st, f, count);
+        if (f.input_flags != INPUT_CONSTANT) {
+            if (f.usage_range) {
+                unsignedItem(out, ITEM_USAGE_MIN, f.usage);
+                unsignedItem(out, ITEM_USAGE_MAX, f.usage + f.count - 1);
+            } else {
+                for (size_t k = 0; k < run; k++) {
+                    unsignedItem(out, ITEM_USAGE, fields[i + k].usage);
+                }
+            }
+        }
+        unsignedItem(out, ITEM_INPUT, f.input_flags);
+        i += run;
+    }
+}
+
+template <typename Out, typename... Reports>
+constexpr void descriptor(Out& out, uint16_t page, uint16_t usage) {
+    State st;
+    unsignedItem(out, ITEM_USAGE_PAGE, page);
+    st.usage_page = page;
+    unsignedItem(out, ITEM_USAGE, usage);
+    unsignedItem(out, ITEM_COLLECTION, 0x01); // Application
+    (report(out, st, Reports::id, Reports::fields, sizeof(Reports::fields) / sizeof(Field)), ...);
+    out.push(ITEM_END_COLLECTION);
+}
+
+template <typename Schema>
+constexpr size_t fieldCount() {
+    return sizeof(Schema::fields) / sizeof(Field);
+}
+
+template <typename Schema>
+constexpr std::array<uint16_t, fieldCount<Schema>() + 1> bitOffsets() {
+    std::array<uint16_t, fieldCount<Schema>() + 1> offsets{};
+    uint16_t bit = 0;
+    for (size_t i = 0; i < fieldCount<Schema>(); i++) {
+        offsets[i] = bit;
+        bit += Schema::fields[i].bits * Schema::fields[i].count;
+    }
+    offsets[fieldCount<Schema>()] = bit;
+    return offsets;
+}
+
+}  // namespace detail
+
+/**
+ * Report descriptor for an application collection holding the given reports.
+ */
+template <uint16_t Page, uint16_t Usage, typename... Reports>
+struct Descriptor {
+    static constexpr size_t size = [] {
+        detail::Counter c;
+        detail::descriptor<detail::Counter, Reports...>(c, Page, Usage);
+        return c.size;
+    }();
+
+    static constexpr std::array<uint8_t, size> bytes = [] {
+        detail::Writer<size> w;
+        detail::descriptor<detail::Writer<size>, Reports...>(w, Page, Usage);
+        return w.bytes;
+    }();
+};
+
+/**
+ * Packed input report laid out exactly as the descriptor declares it
+ * (without the report ID byte, which the transport adds).
+ */
+template <typename Schema>
+class Report {
+public:
+    static constexpr uint8_t id = Schema::id;
+    static constexpr size_t fieldCount = detail::fieldCount<Schema>();
+    static constexpr std::array<uint16_t, fieldCount + 1> offsets = detail::bitOffsets<Schema>();
+    static_assert(offsets[fieldCount] % 8 == 0, "HID report must be a whole number of bytes");
+    static constexpr size_t size = offsets[fieldCount] / 8;
+
+    uint8_t data[size];
+
+    Report() { clear(); }
+
+    void clear() { memset(data, 0, size); }
+
+    /**
+     * Stores value (truncated to the field's bit width) in element of field F.
+     */
+    template <size_t F>
+    inline void set(uint32_t value, uint8_t element = 0) {
+        static_assert(F < fieldCount, "field index out of range");
+        put(offsets[F] + element * Schema::fields[F].bits, Schema::fields[F].bits, value);
+    }
+
+    /**
+     * Same as set<F>() for a field index only known at run time.
+     */
+    inline void set(size_t field, uint32_t value, uint8_t element = 0) {
+        put(offsets[field] + element * Schema::fields[field].bits, Schema::fields[field].bits, value);
+    }
+
+    template <size_t F>
+    inline uint32_t get(uint8_t element = 0) const {
+        static_assert(F < fieldCount, "field index out of range");
+        return fetch(offsets[F] + element * Schema::fields[F].bits, Schema::fields[F].bits);
+    }
+
+    inline uint32_t get(size_t field, uint8_t element = 0) const {
+        return fetch(offsets[field] + element * Schema::fields[field].bits, Schema::fields[field].bits);
+    }
+
+    /**
+     * Element of field as the host reads it: sign-extended from the field's
+     * bit width when its logical minimum is negative, zero-extended otherwise.
+     */
+    inline int64_t getLogical(size_t field, uint8_t element = 0) const {
+        const Field& f = Schema::fields[field];
+        uint32_t raw = fetch(offsets[field] + element * f.bits, f.bits);
+        if (f.logical_min < 0 && f.bits > 0 && f.bits < 32 && (raw >> (f.bits - 1)) & 1) {
+            return (int64_t)raw - ((int64_t)1 << f.bits);
+        }
+        return f.logical_min < 0 ? (int64_t)(int32_t)raw : (int64_t)raw;
+    }
+
+private:
+    inline void put(uint16_t bit, uint8_t bits, uint32_t value) {
+        if ((bit & 7) == 0 && (bits & 7) == 0) {
+            // Byte-aligned fields: plain little-endian stores
+            for (uint8_t i = 0; i < bits / 8; i++) {
+                data[bit / 8 + i] = (uint8_t)(value >> (8 * i));
+            }
+            return;
+        }
+        for (uint8_t i = 0; i < bits; i++, bit++) {
+            uint8_t mask = 1 << (bit & 7);
+            if ((value >> i) & 1) {
+                data[bit / 8] |= mask;
+            } else {
+                data[bit / 8] &= ~mask;
+            }
+        }
+    }
+
+    inline uint32_t fetch(uint16_t bit, uint8_t bits) const {
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < bits; i++, bit++) {
+            value |= (uint32_t)((data[bit / 8] >> (bit & 7)) & 1) << i;
+        }
+        return value;
+    }
+};
+
+}  // namespace hid
+
+#endif
@@ -0,0 +1,111 @@
+#include "ImuHistory.h"
+
+static_assert((IMU_HISTORY_SIZE & (IMU_HISTORY_SIZE - 1)) == 0, "IMU_HISTORY_SIZE must be a power of two");
+
+static ImuSample samples[IMU_HISTORY_SIZE];
+static uint32_t head = 0;       // Total samples pushed; newest is at head - 1
+static uint8_t count = 0;
+
+// Wrap-safe "a is before b" on the 32-bit microsecond clock
+static inline bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+// i-th oldest stored sample
+static inline const ImuSample& at(uint8_t i) {
+    return samples[(head - count + i) & (IMU_HISTORY_SIZE - 1)];
+}
+
+static void copySample(const ImuSample& s, float q[4]) {
+    q[0] = s.x;
+    q[1] = s.y;
+    q[2] = s.z;
+    q[3] = s.w;
+}
+
+static void slerp(const ImuSample& a, const ImuSample& b, float t, float q[4]) {
+    float bx = b.x, by = b.y, bz = b.z, bw = b.w;
+    float dot = a.x * bx + a.y * by + a.z * bz + a.w * bw;
+
+    // q and -q are the same rotation; take the short way round
+    if (dot < 0.0f) {
+        dot = -dot;
+        bx = -bx; by = -by; bz = -bz; bw = -bw;
+    }
+
+    float wa, wb;
+    if (dot > 0.9995f) {
+        // Nearly parallel: linear interpolation is accurate and avoids dividing by sin(~0)
+        wa = 1.0f - t;
+        wb = t;
+    } else {
+        float theta = acosf(dot);
+        float s = 1.0f / sinf(theta);
+        wa = sinf((1.0f - t) * theta) * s;
+        wb = sinf(t * theta) * s;
+    }
+
+    q[0] = wa * a.x + wb * bx;
+    q[1] = wa * a.y + wb * by;
+    q[2] = wa * a.z + wb * bz;
+    q[3] = wa * a.w + wb * bw;
+
+    float norm = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    if (norm > 0.0f) {
+        for (uint8_t i = 0; i < 4; i++) {
+            q[i] /= norm;
+        }
+    }
+}
+
+void imuHistoryReset() {
+    head = 0;
+    count = 0;
+}
+
+void imuHistoryPush(uint32_t timestamp_us, float x, float y, float z, float w) {
+    if (count > 0 && !before(at(count - 1).timestamp_us, timestamp_us)) {
+        return;
+    }
+    samples[head & (IMU_HISTORY_SIZE - 1)] = {timestamp_us, x, y, z, w};
+    head++;
+    if (count < IMU_HISTORY_SIZE) {
+        count++;
+    }
+}
+
+bool imuHistoryAt(uint32_t timestamp_us, float q[4]) {
+    if (count == 0) {
+        return false;
+    }
+    if (!before(at(0).timestamp_us, timestamp_us)) {
+        copySample(at(0), q);
+        return true;
+    }
+    if (!before(timestamp_us, at(count - 1).timestamp_us)) {
+        copySample(at(count - 1), q);
+        return true;
+    }
+
+    // Find the last sample at or before timestamp_us; the clamps above
+    // guarantee 0 <= lo < count - 1
+    uint8_t lo = 0, hi = count - 1;
+    while (hi - lo > 1) {
+        uint8_t mid = (lo + hi) / 2;
+        if (before(timestamp_us, at(mid).timestamp_us)) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+
+    const ImuSample& a = at(lo);
+    const ImuSample& b = at(hi);
+    float t = (float)(timestamp_us - a.timestamp_us) / (float)(b.timestamp_us - a.timestamp_us);
+    slerp(a, b, t, q);
+    return true;
+}
+
+uint8_t imuHistoryCount() {
+    return count;
+}
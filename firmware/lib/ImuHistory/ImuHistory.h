@@ -0,0 +1,40 @@
+#ifndef IMU_HISTORY_H
+#define IMU_HISTORY_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define IMU_HISTORY_SIZE 32     // Samples kept, power of two (80 ms at the 400 Hz BNO085_RV_INTERVAL_US)
+
+struct ImuSample {
+    uint32_t timestamp_us;      // micros() clock
+    float x, y, z, w;
+};
+
+/**
+ * Forgets all samples, e.g. after the IMU was reset.
+ */
+void imuHistoryReset();
+
+/**
+ * Appends a rotation vector sample. Samples must arrive in time order; one
+ * that is not newer than the last stored sample is ignored.
+ */
+void imuHistoryPush(uint32_t timestamp_us, float x, float y, float z, float w);
+
+/**
+ * Orientation at an arbitrary time, interpolated with SLERP between the two
+ * samples around it. Times outside the stored range are clamped to the
+ * oldest or newest sample. Bounded cost: a binary search over at most
+ * IMU_HISTORY_SIZE entries.
+ * @param q Receives x, y, z, w
+ * @return false if no sample has been stored yet
+ */
+bool imuHistoryAt(uint32_t timestamp_us, float q[4]);
+
+/**
+ * Number of stored samples
+ */
+uint8_t imuHistoryCount();
+
+#endif
@@ -0,0 +1,50 @@
+#include "MemoryStats.h"
+#include <esp_heap_caps.h>
+
+// Tasks created by this firmware plus the framework and radio tasks it depends on
+static const char* const taskNames[MEMORY_TASK_COUNT] = {
+    "loopTask",
+    "sampler",
+    "log_drain",
+    "bno085_init",
+    "nimble_host",
+    "esp_timer",
+    "IDLE",
+};
+
+void getHeapStats(HeapStats* out) {
+    out->total = heap_caps_get_total_size(MALLOC_CAP_8BIT);
+    out->free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out->minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    out->largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+int32_t taskStackHighWater(const char* name) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task == nullptr) {
+        return -1;
+    }
+    // ESP-IDF counts stacks in bytes
+    return uxTaskGetStackHighWaterMark(task);
+}
+
+void printMemoryStats() {
+    HeapStats heap;
+    getHeapStats(&heap);
+    Serial.print("Heap free: "); Serial.print(heap.free);
+    Serial.print(" min free: "); Serial.print(heap.minFree);
+    Serial.print(" largest block: "); Serial.print(heap.largestBlock);
+    Serial.print(" total: "); Serial.println(heap.total);
+
+    Serial.println("Stack high-water marks (bytes free):");
+    for (uint8_t i = 0; i < MEMORY_TASK_COUNT; i++) {
+        int32_t free = taskStackHighWater(taskNames[i]);
+        if (free < 0) {
+            continue;
+        }
+        Serial.print("  ");
+        Serial.print(taskNames[i]);
+        Serial.print(": ");
+        Serial.println(free);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// Runtime memory use: heap figures from the ESP-IDF allocator and the stack
+// high-water mark of every task the firmware relies on. The build-time
+// counterpart is scripts/memory_budget.py.
+
+#define MEMORY_TASK_COUNT 7
+
+struct HeapStats {
+    uint32_t total;             // Bytes managed by the 8-bit capable heap
+    uint32_t free;
+    uint32_t minFree;           // Lowest free since boot, the heap high-water mark
+    uint32_t largestBlock;      // Largest single allocation that would succeed now
+};
+
+void getHeapStats(HeapStats* out);
+
+/**
+ * Least free stack a task has had since it started, in bytes.
+ * @return -1 if no task of that name is running
+ */
+int32_t taskStackHighWater(const char* name);
+
+/**
+ * Prints the heap figures and the stack high-water mark of each known task over Serial
+ */
+void printMemoryStats();
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef REPORT_SCHEDULER_H
+#define REPORT_SCHEDULER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "HidSchema.h"
+
+struct ReportStreamConfig {
+    uint32_t min_interval_us;   // Never send faster than this (0 = every update)
+    uint32_t heartbeat_ms;      // Resend unchanged contents at least this often
+};
+
+/**
+ * One independently scheduled HID input report. The caller fills report every
+ * loop; due() decides whether it has to go out: only when a field moved beyond
+ * its deadband since the last transmission, at most once per min_interval_us,
+ * and at least once per heartbeat_ms so hosts can tell a still hand from a lost link.
+ */
+template <typename Schema>
+class ReportStream {
+public:
+    typedef hid::Report<Schema> ReportType;
+
+    /**
+     * @param config Rate limits
+     * @param deadbands One entry per schema field: changes of at most this much are
+     *                  ignored. nullptr treats any change as significant.
+     */
+    ReportStream(const ReportStreamConfig& config, const uint16_t* deadbands = nullptr)
+        : config_(config), deadbands_(deadbands) {}
+
+    ReportType report;
+
+    bool due(uint32_t now_us) {
+        if (!primed_) {
+            return true;
+        }
+        if (now_us - lastSentUs_ < config_.min_interval_us) {
+            return false;
+        }
+        if (changed()) {
+            return true;
+        }
+        if ((now_us - lastSentUs_) / 1000 >= config_.heartbeat_ms) {
+            heartbeats_++;
+            return true;
+        }
+        suppressed_++;
+        return false;
+    }
+
+    /**
+     * Records that report was transmitted.
+     */
+    void sent(uint32_t now_us) {
+        memcpy(lastSent_.data, report.data, ReportType::size);
+        lastSentUs_ = now_us;
+        primed_ = true;
+        sentCount_++;
+    }
+
+    /**
+     * Forces the next due() to return true, e.g. after a reconnect.
+     */
+    void invalidate() { primed_ = false; }
+
+    uint32_t sentCount() const { return sentCount_; }
+    uint32_t suppressedCount() const { return suppressed_; }
+    uint32_t heartbeatCount() const { return heartbeats_; }
+
+private:
+    bool changed() const {
+        if (memcmp(lastSent_.data, report.data, ReportType::size) == 0) {
+            return false;
+        }
+        if (deadbands_ == nullptr) {
+            return true;
+        }
+        for (size_t f = 0; f < ReportType::fieldCount; f++) {
+            const hid::Field& field = Schema::fields[f];
+            if (field.input_flags == hid::INPUT_CONSTANT) {
+                continue;
+            }
+            for (uint8_t e = 0; e < field.count; e++) {
+                // Signed fields are compared as signed, so -1 to 0 is a step of one
+                int64_t step = report.getLogical(f, e) - lastSent_.getLogical(f, e);
+                if ((step < 0 ? -step : step) > deadbands_[f]) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    ReportStreamConfig config_;
+    const uint16_t* deadbands_;
+    ReportType lastSent_;
+    uint32_t lastSentUs_ = 0;
+    bool primed_ = false;
+    uint32_t sentCount_ = 0;
+    uint32_t suppressed_ = 0;
+    uint32_t heartbeats_ = 0;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "SampleScheduler.h"
+
+#include <esp_timer.h>
+
+static esp_timer_handle_t tickTimer = nullptr;
+static TaskHandle_t samplerTask = nullptr;
+static SemaphoreHandle_t frameReady = nullptr;
+
+// Task and semaphore live in static storage; nothing here touches the heap
+// except esp_timer_create()
+static StackType_t samplerStack[SAMPLER_TASK_STACK];
+static StaticTask_t samplerTaskBuffer;
+static StaticSemaphore_t frameReadyBuffer;
+static CaptureCallback captureCallback = nullptr;
+
+static volatile uint32_t tickCount = 0;     // Written by the timer callback only
+static uint32_t handledTicks = 0;
+static int64_t startUs = 0;
+static uint32_t periodUs = 0;
+
+static SamplerStats stats;
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Runs in the esp_timer task; keep it to a counter and a notification
+static void onTick(void* arg) {
+    tickCount = tickCount + 1;
+    xTaskNotifyGive(samplerTask);
+}
+
+static void recordTick(uint32_t behind, uint32_t latency, uint32_t duration) {
+    portENTER_CRITICAL(&statsMux);
+    stats.frames++;
+    if (behind > 1) {
+        uint32_t missed = behind - 1;
+        stats.overruns++;
+        stats.missedTicks += missed;
+        stats.overrunHist[missed < SAMPLER_OVERRUN_BINS ? missed - 1 : SAMPLER_OVERRUN_BINS - 1]++;
+    }
+    uint32_t bin = latency / SAMPLER_JITTER_BIN_US;
+    stats.jitterHist[bin < SAMPLER_JITTER_BINS ? bin : SAMPLER_JITTER_BINS - 1]++;
+    if (latency > stats.maxLatency_us) stats.maxLatency_us = latency;
+    stats.lastCapture_us = duration;
+    if (duration > stats.maxCapture_us) stats.maxCapture_us = duration;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+static void samplerLoop(void* arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Always capture for the newest tick; older ones are counted as missed
+        uint32_t tick = tickCount;
+        uint32_t behind = tick - handledTicks;
+        if (behind == 0) {
+            continue;
+        }
+        handledTicks = tick;
+
+        int64_t scheduled = startUs + (int64_t)tick * periodUs;
+        int64_t begin = esp_timer_get_time();
+        if (captureCallback != nullptr) {
+            captureCallback((uint32_t)scheduled, tick);
+        }
+        int64_t end = esp_timer_get_time();
+
+        int64_t latency = begin - scheduled;
+        recordTick(behind, latency > 0 ? (uint32_t)latency : 0, (uint32_t)(end - begin));
+        xSemaphoreGive(frameReady);
+    }
+}
+
+bool samplerStart(uint32_t rate_hz, CaptureCallback capture) {
+    if (rate_hz == 0) {
+        return false;
+    }
+    samplerStop();
+
+    captureCallback = capture;
+    periodUs = 1000000UL / rate_hz;
+
+    if (frameReady == nullptr) {
+        frameReady = xSemaphoreCreateBinaryStatic(&frameReadyBuffer);
+    }
+    if (samplerTask == nullptr) {
+        samplerTask = xTaskCreateStatic(samplerLoop, "sampler", SAMPLER_TASK_STACK, nullptr, SAMPLER_TASK_PRIORITY,
+                                        samplerStack, &samplerTaskBuffer);
+        if (samplerTask == nullptr) {
+            return false;
+        }
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = onTick;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "sample_tick";
+    if (esp_timer_create(&args, &tickTimer) != ESP_OK) {
+        tickTimer = nullptr;
+        return false;
+    }
+
+    samplerResetStats();
+    tickCount = 0;
+    handledTicks = 0;
+    startUs = esp_timer_get_time();
+    if (esp_timer_start_periodic(tickTimer, periodUs) != ESP_OK) {
+        esp_timer_delete(tickTimer);
+        tickTimer = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void samplerStop() {
+    if (tickTimer != nullptr) {
+        esp_timer_stop(tickTimer);
+        esp_timer_delete(tickTimer);
+        tickTimer = nullptr;
+    }
+}
+
+bool samplerWaitFrame(uint32_t timeout_ms) {
+    if (frameReady == nullptr) {
+        return false;
+    }
+    return xSemaphoreTake(frameReady, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void samplerGetStats(SamplerStats* out) {
+    portENTER_CRITICAL(&statsMux);
+    *out = stats;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void samplerResetStats() {
+    portENTER_CRITICAL(&statsMux);
+    memset(&stats, 0, sizeof(stats));
+    stats.period_us = periodUs;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+void printSamplerStats() {
+    SamplerStats s;
+    samplerGetStats(&s);
+
+    Serial.print("Sampler period (us): "); Serial.print(s.period_us);
+    Serial.print(" frames: "); Serial.print(s.frames);
+    Serial.print(" overruns: "); Serial.print(s.overruns);
+    Serial.print(" missed ticks: "); Serial.println(s.missedTicks);
+    Serial.print("Capture (us) last: "); Serial.print(s.lastCapture_us);
+    Serial.print(" max: "); Serial.print(s.maxCapture_us);
+    Serial.print(" max start latency: "); Serial.println(s.maxLatency_us);
+
+    Serial.print("Start latency histogram (");
+    Serial.print(SAMPLER_JITTER_BIN_US);
+    Serial.print(" us bins):");
+    for (uint8_t i = 0; i < SAMPLER_JITTER_BINS; i++) {
+        Serial.print(" ");
+        Serial.print(s.jitterHist[i]);
+    }
+    Serial.println();
+
+    Serial.print("Overrun histogram (ticks missed 1..");
+    Serial.print(SAMPLER_OVERRUN_BINS);
+    Serial.print("+):");
+    for (uint8_t i = 0; i < SAMPLER_OVERRUN_BINS; i++) {
+        Serial.print(" ");
+        Serial.print(s.overrunHist[i]);
+    }
+    Serial.println();
+}
@@ -0,0 +1,67 @@
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define SAMPLER_DEFAULT_RATE_HZ 200
+#define SAMPLER_TASK_PRIORITY 20        // Above loop() and the log drain, below the radio stacks
+#define SAMPLER_TASK_STACK 4096
+
+// Latency from the timer tick to the start of the capture, in SAMPLER_JITTER_BIN_US
+// buckets. The last bucket collects everything beyond the range.
+#define SAMPLER_JITTER_BINS 16
+#define SAMPLER_JITTER_BIN_US 25
+
+// Ticks skipped per overrun: bucket i counts overruns that lost i + 1 ticks,
+// the last bucket everything longer.
+#define SAMPLER_OVERRUN_BINS 8
+
+/**
+ * Called from the sampler task once per tick.
+ * @param tick_us Scheduled time of the tick on the micros() clock. Ticks are
+ *                exactly one period apart no matter when the capture starts.
+ * @param sequence Tick number since samplerStart(); gaps mean ticks were skipped
+ */
+typedef void (*CaptureCallback)(uint32_t tick_us, uint32_t sequence);
+
+struct SamplerStats {
+    uint32_t period_us;
+    uint32_t frames;            // Captures completed
+    uint32_t overruns;          // Times a capture was still running at the next tick
+    uint32_t missedTicks;       // Ticks skipped because of overruns
+    uint32_t maxLatency_us;     // Worst tick -> capture start
+    uint32_t lastCapture_us;    // Duration of the last capture
+    uint32_t maxCapture_us;     // Longest capture
+    uint32_t jitterHist[SAMPLER_JITTER_BINS];
+    uint32_t overrunHist[SAMPLER_OVERRUN_BINS];
+};
+
+/**
+ * Starts a periodic esp_timer and a high-priority task that runs capture on
+ * every tick. Calling it again restarts the sampler at the new rate.
+ * @return false if the timer or task could not be created
+ */
+bool samplerStart(uint32_t rate_hz, CaptureCallback capture);
+
+void samplerStop();
+
+/**
+ * Blocks the caller until the next capture completes.
+ * @return false on timeout
+ */
+bool samplerWaitFrame(uint32_t timeout_ms);
+
+/**
+ * Copies the statistics. Safe to call from any task.
+ */
+void samplerGetStats(SamplerStats* out);
+
+void samplerResetStats();
+
+/**
+ * Prints rate, overruns and both histograms over Serial
+ */
+void printSamplerStats();
+
+#endif
@@ -0,0 +1,87 @@
+#include "SensorHealth.h"
+
+uint8_t sensorFaults[SENSOR_COUNT];
+uint16_t sensorFaultMask = 0;
+
+struct ChannelHealth {
+    int32_t last;           // Previous reading
+    int32_t lastDelta;      // Previous first difference
+    uint16_t sameCount;     // Consecutive identical readings
+    uint32_t noiseQ4;       // EWMA of |second difference|, 1/16 counts
+    uint8_t hold;           // Frames left before a cleared fault is dropped
+    bool primed;
+};
+
+static ChannelHealth health[SENSOR_COUNT];
+
+void sensorHealthReset() {
+    memset(health, 0, sizeof(health));
+    memset(sensorFaults, 0, sizeof(sensorFaults));
+    sensorFaultMask = 0;
+}
+
+void sensorHealthUpdate(uint8_t channel, int32_t raw) {
+    if (channel >= SENSOR_COUNT) {
+        return;
+    }
+    ChannelHealth& h = health[channel];
+    uint8_t faults = 0;
+
+    if (raw <= HEALTH_RAIL_LOW) faults |= FAULT_RAIL_LOW;
+    if (raw >= HEALTH_RAIL_HIGH) faults |= FAULT_RAIL_HIGH;
+
+    if (h.primed) {
+        int32_t delta = raw - h.last;
+
+        h.sameCount = (delta == 0) ? min(h.sameCount + 1, 0xFFFF) : 0;
+        if (h.sameCount >= HEALTH_STUCK_FRAMES) faults |= FAULT_STUCK;
+
+        if (abs(delta) > HEALTH_RATE_LIMIT) faults |= FAULT_RATE;
+
+        // Second difference ignores steady motion and only responds to jitter
+        int32_t jitter = abs(delta - h.lastDelta) << 4;
+        h.noiseQ4 += (jitter - (int32_t)h.noiseQ4) >> 3;
+        if (h.noiseQ4 > (HEALTH_NOISE_LIMIT << 4)) faults |= FAULT_NOISE;
+
+        h.lastDelta = delta;
+    }
+    h.last = raw;
+    h.primed = true;
+
+    // Latch for a few frames so a single-frame glitch is still visible downstream
+    if (faults) {
+        h.hold = HEALTH_HOLD_FRAMES;
+        sensorFaults[channel] |= faults;
+    } else if (h.hold > 0) {
+        h.hold--;
+    } else {
+        sensorFaults[channel] = 0;
+    }
+
+    if (sensorFaults[channel]) {
+        sensorFaultMask |= (1 << channel);
+    } else {
+        sensorFaultMask &= ~(1 << channel);
+    }
+}
+
+void printSensorHealth() {
+    if (sensorFaultMask == 0) {
+        Serial.println("Sensor health: OK");
+        return;
+    }
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (!sensorFaults[i]) {
+            continue;
+        }
+        Serial.print("Sensor ");
+        Serial.print(i);
+        Serial.print(" fault:");
+        if (sensorFaults[i] & FAULT_STUCK) Serial.print(" stuck");
+        if (sensorFaults[i] & FAULT_RAIL_LOW) Serial.print(" rail-low");
+        if (sensorFaults[i] & FAULT_RAIL_HIGH) Serial.print(" rail-high");
+        if (sensorFaults[i] & FAULT_NOISE) Serial.print(" noise");
+        if (sensorFaults[i] & FAULT_RATE) Serial.print(" rate");
+        Serial.println();
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#define SENSOR_COUNT 16
+
+// Thresholds on raw 12-bit ADC readings
+#define HEALTH_RAIL_LOW 8           // At or below: sensor shorted or disconnected
+#define HEALTH_RAIL_HIGH 4087       // At or above: sensor saturated
+#define HEALTH_STUCK_FRAMES 200     // Identical readings in a row before a channel counts as flat-lined
+#define HEALTH_NOISE_LIMIT 40       // Smoothed |second difference| above this is excess noise
+#define HEALTH_RATE_LIMIT 900       // Max plausible change between consecutive frames
+#define HEALTH_HOLD_FRAMES 25       // Faults stay flagged this long after they clear
+
+// Per-channel fault bits
+#define FAULT_STUCK     0x01
+#define FAULT_RAIL_LOW  0x02
+#define FAULT_RAIL_HIGH 0x04
+#define FAULT_NOISE     0x08
+#define FAULT_RATE      0x10
+
+extern uint8_t sensorFaults[SENSOR_COUNT];  // Fault bits per channel
+extern uint16_t sensorFaultMask;            // Bit i set if channel i has any fault
+
+/**
+ * Clears all health history, e.g. after the sensors are re-powered.
+ */
+void sensorHealthReset();
+
+/**
+ * Feeds one raw reading into the monitor. Constant time and memory per call.
+ * @param channel Mux channel of the reading
+ * @param raw Raw 12-bit ADC value
+ */
+void sensorHealthUpdate(uint8_t channel, int32_t raw);
+
+/**
+ * Prints the fault bits of every faulted channel over Serial
+ */
+void printSensorHealth();
+
+#endif
@@ -0,0 +1,75 @@
+#include "Transport.h"
+
+static Transport* transports[TRANSPORT_MAX] = {nullptr};
+static uint8_t activeMask = 0;
+static uint32_t published[TRANSPORT_MAX] = {0};
+
+static_assert(HAND_FRAME_QUAT_SCALE == CODEC_QUAT_SCALE, "Quaternion is copied without rescaling");
+static_assert(HAND_FRAME_LINEAR_SCALE == CODEC_ACCEL_SCALE, "Acceleration is copied without rescaling");
+
+void transportToCodecFrame(const GloveFrame& in, codec::Frame* out) {
+    const int32_t jointMax = (1 << CODEC_JOINT_BITS) - 1;
+    out->timestamp_us = in.timestamp_us;
+    for (int i = 0; i < CODEC_JOINT_COUNT; i++) {
+        out->joints[i] = constrain(in.joints[i] + CODEC_JOINT_OFFSET, 0, jointMax);
+    }
+    memcpy(out->quat, in.quat, sizeof(out->quat));
+    memcpy(out->accel, in.linear, sizeof(out->accel));
+}
+
+bool transportRegister(TransportId id, Transport* transport) {
+    if (id >= TRANSPORT_MAX || transports[id] != nullptr) {
+        return false;
+    }
+    transports[id] = transport;
+    return true;
+}
+
+uint8_t transportSetActive(uint8_t mask) {
+    for (uint8_t id = 0; id < TRANSPORT_MAX; id++) {
+        uint8_t bit = TRANSPORT_MASK(id);
+        if (transports[id] == nullptr) {
+            continue;
+        }
+        bool want = mask & bit;
+        bool have = activeMask & bit;
+        if (want && !have) {
+            if (transports[id]->begin()) {
+                activeMask |= bit;
+            }
+        } else if (!want && have) {
+            transports[id]->end();
+            activeMask &= ~bit;
+        }
+    }
+    return activeMask;
+}
+
+uint8_t transportActiveMask() {
+    return activeMask;
+}
+
+void transportPublish(const GloveFrame& frame) {
+    for (uint8_t id = 0; id < TRANSPORT_MAX; id++) {
+        if ((activeMask & TRANSPORT_MASK(id)) && transports[id]->ready()) {
+            transports[id]->send(frame);
+            published[id]++;
+        }
+    }
+}
+
+void printTransports() {
+    Serial.println("Transports:");
+    for (uint8_t id = 0; id < TRANSPORT_MAX; id++) {
+        if (transports[id] == nullptr) {
+            continue;
+        }
+        Serial.print("  ");
+        Serial.print(id);
+        Serial.print(" ");
+        Serial.print(transports[id]->name());
+        Serial.print((activeMask & TRANSPORT_MASK(id)) ? " active" : " off");
+        Serial.print(", frames: ");
+        Serial.println(published[id]);
+    }
+}
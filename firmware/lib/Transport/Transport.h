@@ -0,0 +1,81 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "FrameCodec.h"
+#include "HandFrame.h"
+
+#define TRANSPORT_MAX 4
+
+enum TransportId : uint8_t {
+    TRANSPORT_BLE_HID = 0,
+    TRANSPORT_ESPNOW = 1,
+    TRANSPORT_USB_CDC = 2,
+};
+
+#define TRANSPORT_MASK(id) (1u << (id))
+
+/**
+ * Everything a transport may send for one capture: the canonical HandFrame
+ * wire struct. Built once per frame by loop() and handed to every active
+ * transport by const reference; links that carry it uncompressed send these
+ * bytes as they are.
+ */
+typedef hand::Frame GloveFrame;
+
+/**
+ * Codec form used by the compressed links. Joint angles are offset by
+ * CODEC_JOINT_OFFSET so small negative angles survive.
+ */
+void transportToCodecFrame(const GloveFrame& in, codec::Frame* out);
+
+/**
+ * A link frames can be streamed over. send() runs synchronously in loop()
+ * and must not keep the frame reference after it returns; anything queued
+ * for later has to be encoded into the transport's own packet buffer.
+ */
+class Transport {
+public:
+    virtual ~Transport() {}
+    virtual const char* name() const = 0;
+
+    /**
+     * Called when the transport is activated. Returning false leaves it inactive.
+     */
+    virtual bool begin() { return true; }
+    virtual void end() {}
+
+    /**
+     * False while the link cannot take data, e.g. no BLE central is connected.
+     */
+    virtual bool ready() const { return true; }
+
+    virtual void send(const GloveFrame& frame) = 0;
+};
+
+/**
+ * Makes a transport available under an id. Registered transports start inactive.
+ */
+bool transportRegister(TransportId id, Transport* transport);
+
+/**
+ * Selects the active transports; newly enabled ones are begun, disabled ones ended.
+ * @param mask TRANSPORT_MASK() bits
+ * @return The mask that is actually active (transports that fail begin() stay off)
+ */
+uint8_t transportSetActive(uint8_t mask);
+
+uint8_t transportActiveMask();
+
+/**
+ * Hands one frame to every active, ready transport.
+ */
+void transportPublish(const GloveFrame& frame);
+
+/**
+ * Prints registered transports and which are active over Serial
+ */
+void printTransports();
+
+#endif
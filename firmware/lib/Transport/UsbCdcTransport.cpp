@@ -0,0 +1,69 @@
+#include "UsbCdcTransport.h"
+
+bool UsbCdcTransport::begin() {
+    encoder_.reset();
+    open_ = false;
+    return true;
+}
+
+void UsbCdcTransport::end() {
+    flush();
+}
+
+void UsbCdcTransport::flush() {
+    if (!open_) {
+        return;
+    }
+    open_ = false;
+    size_t len = encoder_.finishPacket();
+    if (len > 0) {
+        write(len);
+    }
+}
+
+// Frames the payload already at packet_ + CODEC_STREAM_HEADER_BYTES and sends it
+void UsbCdcTransport::write(size_t len) {
+    packet_[0] = CODEC_STREAM_SYNC_0;
+    packet_[1] = CODEC_STREAM_SYNC_1;
+    packet_[2] = len & 0xFF;
+    packet_[3] = len >> 8;
+    packet_[CODEC_STREAM_HEADER_BYTES + len] = codec::streamChecksum(packet_ + CODEC_STREAM_HEADER_BYTES, len);
+    size_t total = len + CODEC_STREAM_OVERHEAD;
+
+    // Never block loop() on a host that stopped reading. A compressed stream
+    // resyncs at once because the next packet starts with a keyframe.
+    if ((size_t)Serial.availableForWrite() < total) {
+        dropped_++;
+        encoder_.requestKeyframe();
+        return;
+    }
+    Serial.write(packet_, total);
+}
+
+void UsbCdcTransport::send(const GloveFrame& frame) {
+    if (!compressed_) {
+        static_assert(sizeof(GloveFrame) + CODEC_STREAM_OVERHEAD <= sizeof(packet_), "HandFrame does not fit the packet buffer");
+        memcpy(packet_ + CODEC_STREAM_HEADER_BYTES, &frame, sizeof(frame));
+        write(sizeof(frame));
+        return;
+    }
+
+    codec::Frame fixed;
+    transportToCodecFrame(frame, &fixed);
+
+    uint8_t* payload = packet_ + CODEC_STREAM_HEADER_BYTES;
+    size_t capacity = sizeof(packet_) - CODEC_STREAM_OVERHEAD;
+    if (!open_) {
+        encoder_.beginPacket(payload, capacity);
+        open_ = true;
+    }
+    if (!encoder_.add(fixed)) {
+        flush();
+        encoder_.beginPacket(payload, capacity);
+        open_ = true;
+        encoder_.add(fixed);
+    }
+    if (encoder_.frameCount() >= USB_CDC_FRAMES_PER_PACKET) {
+        flush();
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef USB_CDC_TRANSPORT_H
+#define USB_CDC_TRANSPORT_H
+
+#include "Transport.h"
+
+// Frame stream over the USB serial port for the recorder. Payloads are either
+// FrameCodec packets (compressed) or single HandFrames sent as they are, told
+// apart by their first byte. Both are wrapped in the byte-stream framing from
+// FrameCodec.h so they can share the port with text output.
+#define USB_CDC_FRAMES_PER_PACKET 4
+
+class UsbCdcTransport : public Transport {
+public:
+    explicit UsbCdcTransport(bool compressed = true) : compressed_(compressed) {}
+
+    const char* name() const override { return "USB CDC"; }
+    bool begin() override;
+    void end() override;
+    void send(const GloveFrame& frame) override;
+
+    /**
+     * Packets dropped because the USB TX buffer had no room
+     */
+    uint32_t droppedPackets() const { return dropped_; }
+
+private:
+    void flush();
+    void write(size_t len);
+
+    codec::Encoder encoder_;
+    uint8_t packet_[CODEC_STREAM_OVERHEAD + 250];
+    bool compressed_;
+    bool open_ = false;
+    uint32_t dropped_ = 0;
+};
+
+#endif
@@ -0,0 +1,151 @@
+# Per-module RAM/flash budget, run by PlatformIO after every link.
+#
+# The linker map is grouped by module: each library archive the build makes
+# (lib/ and lib_deps), src/, and the prebuilt SDK libraries as "framework". RAM is what a module puts in
+# DRAM and IRAM; flash is everything stored in the image (code, constants and
+# the initial values of .data). The sizes are compared with memory_budget.json,
+# and the build fails when a module grows by more than its slack.
+#
+#   pio run                              check against the budget
+#   MEMORY_BUDGET_UPDATE=1 pio run       accept the current sizes as the budget
+#
+# Without memory_budget.json nothing is checked: the sizes are printed with a
+# warning and the build passes, so a clean checkout still builds. Create it
+# with MEMORY_BUDGET_UPDATE=1 and commit it; CI can set MEMORY_BUDGET_REQUIRED=1
+# to fail instead while the budget is missing.
+
+import json
+import os
+import re
+import sys
+
+SLACK_BYTES = 256           # Growth always tolerated per module and kind
+SLACK_FRACTION = 0.02       # ... or this fraction of the budget, whichever is larger
+
+RAM_SECTIONS = (".dram0.data", ".dram0.bss", ".iram0.text", ".iram0.data", ".iram0.bss", ".noinit")
+FLASH_SECTIONS = (".flash.text", ".flash.rodata", ".flash.appdesc", ".flash.rodata_noload",
+                  ".dram0.data", ".iram0.text", ".iram0.data", ".rtc.text", ".rtc.data")
+
+SECTION_LINE = re.compile(r"^(\.\S+)(?:\s+0x[0-9a-f]+\s+0x[0-9a-f]+)?\s*$")
+INPUT_LINE = re.compile(r"^ (\S+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+
+
+def module_of(path):
+    path = path.replace("\\", "/")
+    if ".pio/build/" not in path:
+        return "framework"
+    archive = re.search(r"/lib([^/()]+)\.a\(", path)
+    if archive:
+        return archive.group(1)
+    if "/src/" in path:
+        return "src"
+    return "framework"
+
+
+def parse_map(map_path):
+    """Returns {module: {"ram": bytes, "flash": bytes}}."""
+    sizes = {}
+    output = None
+    pending = False
+    with open(map_path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("."):
+                match = SECTION_LINE.match(line)
+                output = match.group(1) if match else None
+                continue
+            if output is None:
+                continue
+            if re.match(r"^ \.\S+$", line):
+                # Long input section name; its address, size and object follow on the next line
+                pending = True
+                continue
+            match = INPUT_LINE.match(line)
+            if not match or (match.group(1) is None and not pending):
+                pending = False
+                continue
+            pending = False
+            size = int(match.group(3), 16)
+            source = match.group(4).strip()
+            if size == 0 or not re.search(r"\.(o|obj|a\(.*\))$", source):
+                continue
+            entry = sizes.setdefault(module_of(source), {"ram": 0, "flash": 0})
+            if output in RAM_SECTIONS:
+                entry["ram"] += size
+            if output in FLASH_SECTIONS:
+                entry["flash"] += size
+    return sizes
+
+
+def print_table(sizes, budget):
+    print("Memory budget (bytes):")
+    print("  %-24s %8s %8s %8s %8s" % ("module", "ram", "budget", "flash", "budget"))
+    for module in sorted(sizes, key=lambda m: -sizes[m]["ram"]):
+        limit = budget.get(module, {})
+        print("  %-24s %8d %8s %8d %8s" % (module, sizes[module]["ram"], limit.get("ram", "-"),
+                                             sizes[module]["flash"], limit.get("flash", "-")))
+
+
+def over_budget(sizes, budget):
+    problems = []
+    for module, used in sorted(sizes.items()):
+        if module not in budget:
+            print("Memory budget: %s is new, not checked until the budget is updated" % module)
+            continue
+        for kind in ("ram", "flash"):
+            limit = budget[module].get(kind, 0)
+            allowed = limit + max(SLACK_BYTES, int(limit * SLACK_FRACTION))
+            if used[kind] > allowed:
+                problems.append("%s %s: %d bytes, budget %d" % (module, kind, used[kind], limit))
+    return problems
+
+
+def check(map_path, budget_path, update, required=False):
+    sizes = parse_map(map_path)
+    budget = {}
+    if os.path.exists(budget_path) and not update:
+        with open(budget_path) as f:
+            budget = json.load(f)
+    print_table(sizes, budget)
+
+    if not update and not budget:
+        print("Memory budget: WARNING, %s is missing or empty, nothing checked; "
+              "create it with MEMORY_BUDGET_UPDATE=1 and commit it" % budget_path)
+        return 1 if required else 0
+
+    if update:
+        with open(budget_path, "w") as f:
+            json.dump(sizes, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Memory budget written to %s" % budget_path)
+        return 0
+
+    problems = over_budget(sizes, budget)
+    for problem in problems:
+        print("Memory budget exceeded: " + problem)
+    if problems:
+        print("Shrink the module, or accept the new sizes with MEMORY_BUDGET_UPDATE=1")
+        return 1
+    return 0
+
+
+try:
+    Import("env")
+except NameError:
+    env = None
+
+if env is not None:
+    map_path = env.subst("$BUILD_DIR/firmware.map")
+    budget_path = os.path.join(env.subst("$PROJECT_DIR"), "memory_budget.json")
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+    def after_link(source, target, env):
+        if check(map_path, budget_path, os.environ.get("MEMORY_BUDGET_UPDATE") == "1",
+                 os.environ.get("MEMORY_BUDGET_REQUIRED") == "1") != 0:
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)
+elif __name__ == "__main__":
+    # Standalone: python scripts/memory_budget.py firmware.map memory_budget.json
+    sys.exit(check(sys.argv[1], sys.argv[2], os.environ.get("MEMORY_BUDGET_UPDATE") == "1",
+                   os.environ.get("MEMORY_BUDGET_REQUIRED") == "1"))
@@ -3,9 +3,26 @@
 #include <NimBLEUtils.h>
 #include <NimBLEHIDDevice.h>
 #include <NimBLECharacteristic.h>
+#include <new>
+#include "HidSchema.h"
+#include "ReportScheduler.h"
 #include "FingerTracking.h"
 #include "BNO085.h"
 #include "HallEffectSensors.h"
+#include "HapticFeedback.h"
+#include "SensorHealth.h"
+#include "DriftCompensation.h"
+#include "Crosstalk.h"
+#include "CalibrationTable.h"
+#include "DeferredLog.h"
+#include "SampleScheduler.h"
+#include "ImuHistory.h"
+#include "Transport.h"
+#include "UsbCdcTransport.h"
+#include "HapticGlove_ESPNOW.h"
+#include "FramePool.h"
+#include "GestureNet.h"
+#include "MemoryStats.h"
 
 // Define the number of axes we'll use
 #define NUM_JOINTS 16  // We want all 16 joints
@@ -15,6 +32,7 @@
 
 // Add these at the top of your file with other global variables
 #define BUTTON_COUNT 5                  // Number of finger buttons we're tracking
+#define HID_BUTTON_COUNT 16             // Buttons in the HID report; a gesture model can use all of them
 #define PRESS_THRESHOLD 150             // Absolute threshold for press detection
 #define RELEASE_THRESHOLD 130           // Threshold for release detection
 #define NOISE_TOLERANCE 5               // Tolerance for signal noise
@@ -26,92 +44,119 @@
 #define DEADZONE 32                   // Size of the deadzone (in output units, 0-255)
 #define ANALOG_CENTER 127             // Center value for analog stick
 
-// Updated HID Report Descriptor to use more standard axis definitions
-const uint8_t reportDescriptor[] = {
-    0x05, 0x01,        // Usage Page (Generic Desktop)
-    0x09, 0x05,        // Usage (Gamepad)
-    0xA1, 0x01,        // Collection (Application)
+// HID input report schemas. Finger joints, orientation and buttons travel in
+// separate reports so each can be sent at its own rate. The report descriptor,
+// the packed report buffers and the field offsets are all generated from these
+// tables at compile time.
+#define FINGER_REPORT_ID 1
+#define ORIENTATION_REPORT_ID 2
+#define BUTTON_REPORT_ID 3
+
+struct FingerReportSchema {
+    static constexpr uint8_t id = FINGER_REPORT_ID;
+    static constexpr hid::Field fields[] = {
+        // Joint axes 0-15
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_X),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_Y),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_Z),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_RX),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_RY),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_RZ),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_SLIDER),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_DIAL),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_WHEEL),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VX),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VY),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VZ),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VBRX),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VBRY),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VBRZ),
+        hid::axis(hid::PAGE_GENERIC_DESKTOP, hid::USAGE_VNO),
+
+        hid::axis(hid::PAGE_VENDOR, 0x01, 16),                      // Sensor fault mask
+    };
+};
 
-    // Constant value (1 byte)
-    0x75, 0x08,        // Report Size (8)
-    0x95, 0x01,        // Report Count (1)
-    0x81, 0x03,        // Input (Constant, Variable, Absolute)
-    
-    // Buttons (16 buttons)
-    0x05, 0x09,        // Usage Page (Button)
-    0x19, 0x01,        // Usage Minimum (Button 1)
-    0x29, 0x10,        // Usage Maximum (Button 16)
-    0x15, 0x00,        // Logical Minimum (0)
-    0x25, 0x01,        // Logical Maximum (1)
-    0x75, 0x01,        // Report Size (1)
-    0x95, 0x10,        // Report Count (16)
-    0x81, 0x02,        // Input (Data, Variable, Absolute)
-    
-    // First 8 axes - using standard axis definitions
-    0x05, 0x01,        // Usage Page (Generic Desktop)
-    0x09, 0x30,        // Usage (X)
-    0x09, 0x31,        // Usage (Y)
-    0x09, 0x32,        // Usage (Z)
-    0x09, 0x33,        // Usage (Rx)
-    0x09, 0x34,        // Usage (Ry)
-    0x09, 0x35,        // Usage (Rz)
-    0x09, 0x36,        // Usage (Slider)
-    0x09, 0x37,        // Usage (Dial)
-    0x15, 0x00,        // Logical Minimum (0)
-    0x26, 0xFF, 0x00,  // Logical Maximum (255)
-    0x75, 0x08,        // Report Size (8)
-    0x95, 0x08,        // Report Count (8)
-    0x81, 0x02,        // Input (Data, Variable, Absolute)
-    
-    // Second set of 8 axes - using additional standard controls
-    0x05, 0x01,        // Usage Page (Generic Desktop)
-    0x09, 0x38,        // Usage (Wheel)
-    0x09, 0x39,        // Usage (Hat switch)
-    0x09, 0x3A,        // Usage (Counted Buffer)
-    0x09, 0x3B,        // Usage (Byte Count)
-    0x09, 0x3C,        // Usage (Motion Wakeup)
-    0x09, 0x3D,        // Usage (Start)
-    0x09, 0x3E,        // Usage (Select)
-    0x09, 0x3F,        // Usage (Vector)
-    0x15, 0x00,        // Logical Minimum (0)
-    0x26, 0xFF, 0x00,  // Logical Maximum (255)
-    0x75, 0x08,        // Report Size (8)
-    0x95, 0x08,        // Report Count (8)
-    0x81, 0x02,        // Input (Data, Variable, Absolute)
-
-    // Add quaternion values (4 more axes)
-    0x05, 0x02,        // Usage Page (Simulation Controls)
-    0x09, 0xBA,        // Usage (Rudder)
-    0x09, 0xBB,        // Usage (Throttle)
-    0x09, 0xC4,        // Usage (Accelerator)
-    0x09, 0xC5,        // Usage (Brake)
-    0x15, 0x00,        // Logical Minimum (0)
-    0x26, 0xFF, 0x00,  // Logical Maximum (255)
-    0x75, 0x08,        // Report Size (8)
-    0x95, 0x04,        // Report Count (4)
-    0x81, 0x02,        // Input (Data, Variable, Absolute)
-
-    // Add linear acceleration axes (3 more axes)
-    0x05, 0x02,        // Usage Page (Simulation Controls)
-    0x09, 0xB0,        // Usage (X-axis acceleration)
-    0x09, 0xB1,        // Usage (Y-axis acceleration)
-    0x09, 0xB2,        // Usage (Z-axis acceleration)
-    0x15, 0x00,        // Logical Minimum (0)
-    0x26, 0xFF, 0x00,  // Logical Maximum (255)
-    0x75, 0x08,        // Report Size (8)
-    0x95, 0x03,        // Report Count (3)
-    0x81, 0x02,        // Input (Data, Variable, Absolute)
-
-    0xC0               // End Collection
+struct OrientationReportSchema {
+    static constexpr uint8_t id = ORIENTATION_REPORT_ID;
+    static constexpr hid::Field fields[] = {
+        // Quaternion x, y, z, w
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_RUDDER),
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_THROTTLE),
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_ACCELERATOR),
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_BRAKE),
+
+        // Linear acceleration x, y, z
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_AILERON),
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_AILERON_TRIM),
+        hid::axis(hid::PAGE_SIMULATION, hid::USAGE_ANTI_TORQUE),
+
+        hid::axis(hid::PAGE_VENDOR, 0x02, 8),                       // IMU status
+    };
+};
+
+struct ButtonReportSchema {
+    static constexpr uint8_t id = BUTTON_REPORT_ID;
+    static constexpr hid::Field fields[] = {
+        hid::buttons(HID_BUTTON_COUNT),
+    };
+};
+
+// Field indices into the schemas above
+enum FingerReportField {
+    FIELD_JOINT_0 = 0,
+    FIELD_FAULT_MASK = FIELD_JOINT_0 + NUM_JOINTS,
+    FINGER_FIELD_COUNT
+};
+
+enum OrientationReportField {
+    FIELD_QUAT_X = 0,
+    FIELD_QUAT_Y,
+    FIELD_QUAT_Z,
+    FIELD_QUAT_W,
+    FIELD_LINEAR_X,
+    FIELD_LINEAR_Y,
+    FIELD_LINEAR_Z,
+    FIELD_IMU_STATUS,
+    ORIENTATION_FIELD_COUNT
 };
 
+enum ButtonReportField {
+    FIELD_BUTTONS = 0
+};
+
+typedef hid::Descriptor<hid::PAGE_GENERIC_DESKTOP, hid::USAGE_GAMEPAD,
+                        FingerReportSchema, OrientationReportSchema, ButtonReportSchema> GloveDescriptor;
+
+static_assert(hid::Report<FingerReportSchema>::fieldCount == FINGER_FIELD_COUNT, "FingerReportField out of sync");
+static_assert(hid::Report<OrientationReportSchema>::fieldCount == ORIENTATION_FIELD_COUNT, "OrientationReportField out of sync");
+
+// Per-field deadbands: a report is only resent when a field moves by more than this
+const uint16_t fingerDeadbands[FINGER_FIELD_COUNT] = {
+    1, 1, 1, 1,  1, 1, 1,  1, 1, 1,  1, 1, 1,  1, 1, 1,  // Joints
+    0                                                  // Fault mask
+};
+const uint16_t orientationDeadbands[ORIENTATION_FIELD_COUNT] = {
+    1, 1, 1, 1,  // Quaternion
+    2, 2, 2,     // Linear acceleration
+    0            // IMU status
+};
+
+// Finger joints follow the mux scan, orientation is capped near the BNO085 rate,
+// buttons go out the moment they change
+ReportStream<FingerReportSchema> fingerStream({0, 100}, fingerDeadbands);
+ReportStream<OrientationReportSchema> orientationStream({5000, 100}, orientationDeadbands);
+ReportStream<ButtonReportSchema> buttonStream({0, 500});
+
 // Variables to store joint values and button state
 // uint8_t reportData[NUM_JOINTS + 2] = {0}; // +1 for button state
 
 // BLE objects
 NimBLEServer* pServer = nullptr;
 NimBLEHIDDevice* hid = nullptr;
-NimBLECharacteristic* inputGamepad = nullptr;
+NimBLECharacteristic* inputFingers = nullptr;
+NimBLECharacteristic* inputOrientation = nullptr;
+NimBLECharacteristic* inputButtons = nullptr;
 bool deviceConnected = false;
 bool oldDeviceConnected = false;
 
@@ -119,6 +164,7 @@ bool oldDeviceConnected = false;
 enum ControlMode {
     GAME_MODE = 0,       // Mapped controls for gameplay
     RAW_ANGLES_MODE = 1, // Show all raw angle values
+    DIAGNOSTICS_MODE = 2, // Raw angles, plus sampler, IMU, haptic latency and memory statistics on Serial
     // Add more modes as needed in the future
     MODE_COUNT           // Always keep this as the last item to track the number of modes
 };
@@ -127,6 +173,60 @@ enum ControlMode {
 ControlMode currentMode = RAW_ANGLES_MODE;
 bool modeJustChanged = true;         // Flag to indicate when mode has just changed
 
+// One finger frame from the sampler task. Frames come from a fixed pool: the
+// sampler fills a slot and swaps it into latestCapture, handing back the frame
+// it replaces if loop() never took it; loop() takes the newest one out.
+struct CapturedFrame {
+    uint32_t timestamp_us;          // Scheduled tick time of the capture
+    uint32_t sequence;              // Tick number, gaps mean skipped ticks
+    int32_t angles[SENSOR_COUNT];
+};
+
+// One being filled, one waiting in latestCapture, one being copied by loop()
+#define CAPTURE_POOL_SLOTS 3
+
+static FramePool<CapturedFrame, CAPTURE_POOL_SLOTS> capturePool;
+static CapturedFrame* latestCapture = nullptr;
+CapturedFrame currentFrame;         // loop()'s copy of the latest frame
+
+// Set with 'w': frames carry the sensor readings the calibration tables convert,
+// minus CALIBRATION_READING_OFFSET, for recording sessions for host/tools/calib_fit
+static volatile bool streamReadings = false;
+
+// Runs in the sampler task on every timer tick
+void captureFrame(uint32_t tick_us, uint32_t sequence) {
+    calcFingerAngles();
+
+    CapturedFrame* frame = capturePool.acquire();
+    if (frame == nullptr) {
+        return;
+    }
+    frame->timestamp_us = tick_us;
+    frame->sequence = sequence;
+    if (streamReadings) {
+        for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+            frame->angles[i] = (int32_t)((decoupledQ4[i] + 8) >> 4) - CALIBRATION_READING_OFFSET;
+        }
+    } else {
+        memcpy(frame->angles, angles, sizeof(frame->angles));
+    }
+    CapturedFrame* replaced = __atomic_exchange_n(&latestCapture, frame, __ATOMIC_ACQ_REL);
+    if (replaced != nullptr) {
+        capturePool.release(replaced);
+    }
+}
+
+// Copies the latest captured frame, false if there is none since the last call
+bool readCapturedFrame(CapturedFrame* out) {
+    CapturedFrame* frame = __atomic_exchange_n(&latestCapture, (CapturedFrame*)nullptr, __ATOMIC_ACQ_REL);
+    if (frame == nullptr) {
+        return false;
+    }
+    memcpy(out, frame, sizeof(*out));
+    capturePool.release(frame);
+    return true;
+}
+
 // Structure to track finger motion for button detection
 struct FingerButtonState {
     int32_t baselineAngle;    // Baseline angle (calibrated at start)
@@ -184,6 +284,11 @@ class ServerCallbacks : public NimBLEServerCallbacks {
     void onConnect(NimBLEServer* pServer) {
         Serial.println("Client connected!");
         deviceConnected = true;
+
+        // A new host has none of our state: send every report on the next pass
+        fingerStream.invalidate();
+        orientationStream.invalidate();
+        buttonStream.invalidate();
     };
 
     void onDisconnect(NimBLEServer* pServer) {
@@ -222,6 +327,13 @@ class SecurityCallbacks : public NimBLESecurityCallbacks {
     }
 };
 
+// Long-lived BLE objects live in static storage instead of the heap. The HID
+// device can only be built once the server exists, so setup() constructs it
+// in place.
+ServerCallbacks serverCallbacks;
+SecurityCallbacks securityCallbacks;
+alignas(NimBLEHIDDevice) static uint8_t hidStorage[sizeof(NimBLEHIDDevice)];
+
 // Function to map angle values to the 0-255 range needed for HID
 uint8_t mapAngleToHID(int32_t angle, int32_t minAngle, int32_t maxAngle) {
     // Constrain the angle to the min-max range
@@ -231,34 +343,6 @@ uint8_t mapAngleToHID(int32_t angle, int32_t minAngle, int32_t maxAngle) {
     return map(constrainedAngle, minAngle, maxAngle, 0, 255);
 }
 
-// Gamepad descriptor layout for buttons and axes
-typedef struct {
-  // Action buttons
-  bool button1 : 1;
-  bool button2 : 1;
-  bool button3 : 1;
-  bool button4 : 1;
-  bool button5 : 1;
-  bool button6 : 1;
-  bool button7 : 1;
-  bool button8 : 1;
-  bool button9 : 1;
-  bool button10 : 1;
-  bool button11 : 1;
-  bool button12 : 1;
-
-  // D-pad buttons
-  bool up : 1;
-  bool right : 1;
-  bool down : 1;
-  bool left : 1;
-
-  // All 23 axes
-  uint8_t axes[23]; // Updated to 23 total axes
-} GamepadReport;
-
-// Create an instance of the gamepad report
-GamepadReport gamepadReport = {0};
 
 // Add function to convert quaternion to gamepad axis value
 uint8_t quaternionToAxis(float quat_val) {
@@ -269,17 +353,21 @@ uint8_t quaternionToAxis(float quat_val) {
 // Add this function before setup()
 void printHIDDescriptor() {
     Serial.println("HID Report Descriptor:");
-    for (size_t i = 0; i < sizeof(reportDescriptor); i++) {
-        if (reportDescriptor[i] < 16) Serial.print("0");
-        Serial.print(reportDescriptor[i], HEX);
+    for (size_t i = 0; i < GloveDescriptor::size; i++) {
+        if (GloveDescriptor::bytes[i] < 16) Serial.print("0");
+        Serial.print(GloveDescriptor::bytes[i], HEX);
         Serial.print(" ");
         if ((i + 1) % 8 == 0) Serial.println();
     }
     Serial.println();
     Serial.print("Total descriptor size: ");
-    Serial.println(sizeof(reportDescriptor));
-    Serial.print("GamepadReport struct size: ");
-    Serial.println(sizeof(GamepadReport));
+    Serial.println(GloveDescriptor::size);
+    Serial.print("Report sizes (fingers, orientation, buttons): ");
+    Serial.print(fingerStream.report.size);
+    Serial.print(", ");
+    Serial.print(orientationStream.report.size);
+    Serial.print(", ");
+    Serial.println(buttonStream.report.size);
 }
 
 // Function to cycle to the next mode
@@ -292,10 +380,16 @@ void cycleToNextMode() {
     switch (currentMode) {
         case GAME_MODE:
             Serial.println("Game Mode");
+            // The gesture window has a gap; start it over
+            gestureReset();
             break;
         case RAW_ANGLES_MODE:
             Serial.println("Raw Angles Mode");
             break;
+        case DIAGNOSTICS_MODE:
+            Serial.println("Diagnostics Mode");
+            samplerResetStats();
+            break;
         default:
             Serial.println("Unknown Mode");
             break;
@@ -333,13 +427,246 @@ uint8_t applyDeadzone(int32_t rawValue, uint8_t deadzone) {
     }
 }
 
+// BLE HID backend. Maps the shared frame onto the three input reports; each
+// report is only notified when its stream says it is due.
+class BleHidTransport : public Transport {
+public:
+    const char* name() const override { return "BLE HID"; }
+
+    bool ready() const override {
+        return deviceConnected;
+    }
+
+    void send(const GloveFrame& frame) override {
+        if (inputFingers == nullptr || inputOrientation == nullptr || inputButtons == nullptr) {
+            Serial.println("Error: HID input reports are null");
+            return;
+        }
+
+        hid::Report<FingerReportSchema>& fingerReport = fingerStream.report;
+        hid::Report<OrientationReportSchema>& orientationReport = orientationStream.report;
+        hid::Report<ButtonReportSchema>& buttonReport = buttonStream.report;
+        buttonReport.clear();
+
+        // Set button6 based on the physical button
+        // buttonReport.set<FIELD_BUTTONS>(buttonState, 5);
+
+        // Set buttons to indicate current mode (optional)
+        // buttonReport.set<FIELD_BUTTONS>(currentMode == GAME_MODE, 0);
+        // buttonReport.set<FIELD_BUTTONS>(currentMode == RAW_ANGLES_MODE, 1);
+
+        // Process data based on the current mode
+        switch (currentMode) {
+            case GAME_MODE:
+                // GAME MODE: Use mapped controls for gameplay
+
+                // Set button states based on detected gestures
+                for (int i = 0; i < HID_BUTTON_COUNT; i++) {
+                    buttonReport.set<FIELD_BUTTONS>((frame.buttons >> i) & 1, i);
+                }
+
+                // Map roll angle to X-axis (left/right movement)
+                fingerReport.set<FIELD_JOINT_0>(constrain(map(ypr.roll, -45, 45, 0, 255), 0, 255));
+
+                // Map pitch angle to Y-axis (up/down movement)
+                // fingerReport.set<FIELD_JOINT_0 + 1>(constrain(map(ypr.pitch, -45, 45, 0, 255), 0, 255));
+
+                // Apply deadzone to both axes
+                // fingerReport.set<FIELD_JOINT_0>(applyDeadzone(fingerReport.get<FIELD_JOINT_0>(), DEADZONE));
+                // fingerReport.set<FIELD_JOINT_0 + 1>(applyDeadzone(fingerReport.get<FIELD_JOINT_0 + 1>(), DEADZONE));
+
+                // Fill remaining axes with zeros or other mapped values
+                fingerReport.set<FIELD_JOINT_0 + 1>(0);
+                for (int i = 2; i < 16; i++) {
+                    fingerReport.set(FIELD_JOINT_0 + i, 127);
+                }
+                break;
+
+            case RAW_ANGLES_MODE:
+                // RAW ANGLES MODE: Show all raw angle values
+
+                // Map all raw angle values directly to axes
+                for (int i = 0; i < NUM_JOINTS && i < 16; i++) {
+                    fingerReport.set(FIELD_JOINT_0 + i, mapAngleToHID(frame.joints[i], 0, 255));
+                }
+                break;
+
+            default:
+                // Fallback mode - just use raw angles
+                for (int i = 0; i < NUM_JOINTS && i < 16; i++) {
+                    fingerReport.set(FIELD_JOINT_0 + i, mapAngleToHID(frame.joints[i], 0, 255));
+                }
+                break;
+        }
+
+        // Orientation goes out in every mode on its own report
+        orientationReport.set<FIELD_QUAT_X>(quaternionToAxis(frame.quat[0] / HAND_FRAME_QUAT_SCALE));
+        orientationReport.set<FIELD_QUAT_Y>(quaternionToAxis(frame.quat[1] / HAND_FRAME_QUAT_SCALE));
+        orientationReport.set<FIELD_QUAT_Z>(quaternionToAxis(frame.quat[2] / HAND_FRAME_QUAT_SCALE));
+        orientationReport.set<FIELD_QUAT_W>(quaternionToAxis(frame.quat[3] / HAND_FRAME_QUAT_SCALE));
+
+        // Map from typical acceleration range (-8 to +8 m/s²) to 0-255; the
+        // frame carries 1/256 m/s², so /16 gives the same 1/16 m/s² steps
+        orientationReport.set<FIELD_LINEAR_X>(constrain(map(frame.linear[0] / 16, -128, 127, 0, 255), 0, 255));
+        orientationReport.set<FIELD_LINEAR_Y>(constrain(map(frame.linear[1] / 16, -128, 127, 0, 255), 0, 255));
+        orientationReport.set<FIELD_LINEAR_Z>(constrain(map(frame.linear[2] / 16, -128, 127, 0, 255), 0, 255));
+
+        // Flag frames built from faulted sensors so consumers can drop them
+        fingerReport.set<FIELD_FAULT_MASK>(frame.fault_mask);
+        orientationReport.set<FIELD_IMU_STATUS>(frame.imu_status);
+
+        uint32_t now = micros();
+
+        // Buttons first so a press is never queued behind a bulk axis update
+        if (buttonStream.due(now)) {
+            inputButtons->setValue(buttonReport.data, buttonReport.size);
+            inputButtons->notify();
+            buttonStream.sent(now);
+        }
+        if (fingerStream.due(now)) {
+            inputFingers->setValue(fingerReport.data, fingerReport.size);
+            inputFingers->notify();
+            fingerStream.sent(now);
+        }
+        if (orientationStream.due(now)) {
+            inputOrientation->setValue(orientationReport.data, orientationReport.size);
+            inputOrientation->notify();
+            orientationStream.sent(now);
+        }
+    }
+};
+
+// Startup milestones on the millis() clock, which starts with the app (after
+// the bootloader)
+struct BootTiming {
+    uint32_t setupMs;           // setup() returned
+    uint32_t firstFrameMs;      // First frame handed to the transports
+    uint32_t imuFrameMs;        // First frame with a live orientation
+};
+BootTiming bootTiming;
+bool muxSettleCached = false;
+
+void recordBootTiming(const GloveFrame& frame) {
+    if (bootTiming.firstFrameMs == 0) {
+        bootTiming.firstFrameMs = millis();
+        LOG(LOG_BOOT_FIRST_FRAME, bootTiming.firstFrameMs, frame.imu_status);
+    }
+    if (bootTiming.imuFrameMs == 0 && !(frame.imu_status & IMU_STATUS_STALE)) {
+        bootTiming.imuFrameMs = millis();
+        LOG(LOG_BOOT_IMU_FRAME, bootTiming.imuFrameMs);
+    }
+}
+
+void printBootTiming() {
+    Serial.print("Boot (ms): setup ");
+    Serial.print(bootTiming.setupMs);
+    Serial.print(" first frame ");
+    Serial.print(bootTiming.firstFrameMs);
+    Serial.print(" IMU ready ");
+    Serial.print(bno085ReadyMs());
+    Serial.print(" first orientation ");
+    Serial.println(bootTiming.imuFrameMs);
+    Serial.println(muxSettleCached ? "Mux settle times restored from NVS" : "Mux settle times measured at boot");
+}
+
+// Heap, task stacks and the frame pool
+void printMemory() {
+    printMemoryStats();
+    Serial.print("Capture pool: ");
+    Serial.print(capturePool.highWater());
+    Serial.print("/");
+    Serial.print(capturePool.capacity());
+    Serial.print(" slots at most, exhausted ");
+    Serial.println(capturePool.exhausted());
+}
+
+// Frame links. Which ones are active can be changed at runtime from Serial.
+uint8_t espnowPeer[6] = PEER_MAC_1;
+BleHidTransport bleHidTransport;
+EspNowTransport espnowTransport(espnowPeer);
+UsbCdcTransport usbCdcTransport;
+#define DEFAULT_TRANSPORTS TRANSPORT_MASK(TRANSPORT_BLE_HID)
+
+// Serial commands: 'b', 'e', 'u' toggle BLE HID, ESP-NOW and USB CDC, 't' lists them.
+// 'r' and 'd' retake and print the drift reference, 'x' and 'm' capture and print the
+// crosstalk correction and 'k' drops it. 'c' takes a calibration blob straight after it, 'p' prints the
+// calibration tables and 'n' goes back to the default ones; 'w' toggles streaming
+// readings instead of angles. 's' measures and stores the mux settle times again,
+// 'i' prints the boot timing and 'h' heap, stack and frame pool use; 'g' prints the
+// gesture model and benchmarks it, 'l' the haptic duties and round-trip latency,
+// 'f' the frame codec's encode time and size on the ESP-NOW stream.
+void handleSerialCommands() {
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        uint8_t toggle = 0;
+        switch (c) {
+            case 'b': toggle = TRANSPORT_MASK(TRANSPORT_BLE_HID); break;
+            case 'e': toggle = TRANSPORT_MASK(TRANSPORT_ESPNOW); break;
+            case 'u': toggle = TRANSPORT_MASK(TRANSPORT_USB_CDC); break;
+            case 't': printTransports(); break;
+            case 'r':
+                // Hold the hand relaxed and open; the next still pose is the new
+                // reference, kept in NVS across reboots
+                driftCaptureReference();
+                Serial.println("Drift compensation: hold the hand open and still");
+                break;
+            case 'd': printDriftCompensation(); break;
+            case 'x':
+                // Prompts for each joint in turn come through the deferred log
+                crosstalkStartCapture();
+                Serial.println("Crosstalk capture: move one joint at a time as prompted");
+                break;
+            case 'm': printCrosstalkCorrection(); break;
+            case 'k':
+                crosstalkClear();
+                Serial.println("Crosstalk correction back to the default");
+                break;
+            case 'c':
+                if (calibrationTableReceive(Serial)) {
+                    Serial.println("Calibration installed");
+                }
+                break;
+            case 'p': printCalibrationTable(); break;
+            case 'n':
+                calibrationTableClear();
+                Serial.println("Calibration back to the default tables");
+                break;
+            case 'w':
+                // Joints, gestures and HID reports are meaningless while this is on
+                streamReadings = !streamReadings;
+                Serial.println(streamReadings ? "Streaming sensor readings" : "Streaming joint angles");
+                break;
+            case 's':
+                // The sampler owns the mux; pause it and let a capture in flight finish
+                samplerStop();
+                delay(10);
+                characterizeMuxSettling();
+                printMuxSettleTimes();
+                samplerStart(SAMPLER_DEFAULT_RATE_HZ, captureFrame);
+                break;
+            case 'i': printBootTiming(); break;
+            case 'h': printMemory(); break;
+            case 'g': printGestureNet(); break;
+            case 'f': glove_printCodecStats(); break;
+            case 'l': printHapticLatency(); break;
+            default: break;
+        }
+        if (toggle != 0) {
+            transportSetActive(transportActiveMask() ^ toggle);
+            printTransports();
+        }
+    }
+}
+
 void setup() {
+    // No wait for a serial monitor: early messages go through the deferred log
     Serial.begin(115200);
-    delay(1000); // Give serial time to connect
-    
-    Serial.println("\n\n----- Eidon Glove Starting -----");
-    Serial.println("Initializing finger tracking...");
-    
+    deferredLogSetup();
+
+    // The BNO085 boots in the background while everything else comes up;
+    // frames go out without orientation until it is ready
+    setupBNO085();
+
     // Define which sensors have inverted magnets
     bool invertedSensors[SENSOR_COUNT] = {
         false, false, false, false,  // Thumb (0-3)
@@ -351,9 +678,14 @@ void setup() {
     
     // Initialize the finger tracking system with inverted sensor configuration
     fingerTrackingSetup(invertedSensors);
-    
-    Serial.println("Initializing BLE Gamepad...");
-    
+
+    // Settle times measured on an earlier boot; measuring takes ~200 ms, so it
+    // only happens when none are stored (or on the 's' command)
+    muxSettleCached = restoreMuxSettleTimes();
+    if (!muxSettleCached) {
+        characterizeMuxSettling();
+    }
+
     // Set a fixed device name and address for consistent pairing
     NimBLEDevice::init("Eidon Glove (Right)");
     
@@ -361,23 +693,26 @@ void setup() {
     // uint8_t customAddress[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
     // esp_base_mac_addr_set(customAddress);
     
-    // Configure security for reliable pairing
+    // Configure security for reliable pairing. Bonds are kept in NVS by NimBLE,
+    // so a paired host reconnects after a reboot without pairing again
     NimBLEDevice::setSecurityAuth(true, true, true);
     NimBLEDevice::setSecurityIOCap(BLE_HS_IO_NO_INPUT_OUTPUT);
     NimBLEDevice::setSecurityInitKey(BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID);
     NimBLEDevice::setSecurityRespKey(BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID);
-    NimBLEDevice::setSecurityCallbacks(new SecurityCallbacks());
+    NimBLEDevice::setSecurityCallbacks(&securityCallbacks);
     
     // Set consistent power level
     NimBLEDevice::setPower(ESP_PWR_LVL_P9);
     
     // Create server
     pServer = NimBLEDevice::createServer();
-    pServer->setCallbacks(new ServerCallbacks());
+    pServer->setCallbacks(&serverCallbacks, false);   // Static, NimBLE must not delete it
     
     // Create HID device with consistent settings
-    hid = new NimBLEHIDDevice(pServer);
-    inputGamepad = hid->inputReport(1); // Report ID 1
+    hid = new (hidStorage) NimBLEHIDDevice(pServer);
+    inputFingers = hid->inputReport(FINGER_REPORT_ID);
+    inputOrientation = hid->inputReport(ORIENTATION_REPORT_ID);
+    inputButtons = hid->inputReport(BUTTON_REPORT_ID);
     
     // Set consistent manufacturer name
     hid->manufacturer()->setValue("ESP32-C3");
@@ -387,7 +722,7 @@ void setup() {
     hid->hidInfo(0x00, 0x01);
     
     // Set report descriptor
-    hid->reportMap((uint8_t*)reportDescriptor, sizeof(reportDescriptor));
+    hid->reportMap((uint8_t*)GloveDescriptor::bytes.data(), GloveDescriptor::size);
     
     // Print the HID descriptor for debugging
     // printHIDDescriptor();
@@ -405,54 +740,36 @@ void setup() {
     // Start advertising
     pAdvertising->start();
     
-    Serial.println("BT Gamepad initialized!");
-    Serial.println("Device name: Hand Tracker (Right)");
-    Serial.println("The device should now be visible in your Bluetooth settings.");
-    Serial.println("Please pair with it from your computer or mobile device.");
-    Serial.println("----- Initialization Complete -----");
-    
-    // Initialize finger button tracking
+    // Initialize finger button tracking; a built-in gesture model takes over from the thresholds
     initFingerButtons();
-    
-    setupBNO085();            // New BNO085 setup
+    gestureNetSetup();
+
+    // Actuators start released; forces arrive through the ESP-NOW receive path,
+    // which is up whether or not frames are sent over ESP-NOW
+    hapticSetup();
+    if (!glove_ESPNOWsetup(espnowPeer)) {
+        Serial.println("ESP-NOW unavailable, no haptic feedback");
+    }
+
+    transportRegister(TRANSPORT_BLE_HID, &bleHidTransport);
+    transportRegister(TRANSPORT_ESPNOW, &espnowTransport);
+    transportRegister(TRANSPORT_USB_CDC, &usbCdcTransport);
+    transportSetActive(DEFAULT_TRANSPORTS);
+
+    // From here on the mux and ADC belong to the sampler task
+    if (!samplerStart(SAMPLER_DEFAULT_RATE_HZ, captureFrame)) {
+        Serial.println("Failed to start the sampling timer");
+    }
+    bootTiming.setupMs = millis();
 }
 
 // Function to update finger button states based on position changes
 void updateFingerButtons() {
     unsigned long currentTime = millis();
-    static bool isCalibrated = false;
-    
-    // One-time calibration of baseline angles
-    if (!isCalibrated) {
-        Serial.println("Calibrating finger baseline positions...");
-        // Wait a moment for sensors to stabilize
-        delay(500);
-        
-        // Take multiple readings and average them for baseline
-        const int calibrationSamples = 10;
-        for (int i = 0; i < BUTTON_COUNT; i++) {
-            int32_t sum = 0;
-            for (int j = 0; j < calibrationSamples; j++) {
-                calcFingerAngles();
-                sum += angles[fingerIndices[i]];
-                delay(20);
-            }
-            fingerButtons[i].baselineAngle = 0; // sum / calibrationSamples;
-            fingerButtons[i].prevAngle = fingerButtons[i].baselineAngle;
-            
-            // Serial.print("Finger ");
-            // Serial.print(i);
-            // Serial.print(" baseline: ");
-            // Serial.print(fingerButtons[i].baselineAngle);
-            // Serial.print(" (Press threshold: ");
-            // Serial.print(PRESS_THRESHOLDS[i]);
-            // Serial.print(", Release threshold: ");
-            // Serial.print(RELEASE_THRESHOLDS[i]);
-            // Serial.println(")");
-        }
-        isCalibrated = true;
-        Serial.println("Calibration complete!");
-    }
+
+    // Baselines stay at the zero set by initFingerButtons(). The rest pose used
+    // to be averaged here on the first call, holding up frames for ~1.5 s, and
+    // the average was never applied.
     
     // Debug output - print values periodically
     static unsigned long lastDebugTime = 0;
@@ -465,7 +782,7 @@ void updateFingerButtons() {
     
     for (int i = 0; i < BUTTON_COUNT; i++) {
         // Get current angle for this finger
-        int32_t currentAngle = angles[fingerIndices[i]];
+        int32_t currentAngle = currentFrame.angles[fingerIndices[i]];
         
         // Calculate distance from baseline (rest position)
         int32_t distanceFromBaseline = currentAngle - fingerButtons[i].baselineAngle;
@@ -493,13 +810,7 @@ void updateFingerButtons() {
                 fingerButtons[i].isPressed = true;
                 fingerButtons[i].lastChange = currentTime;
                 
-                Serial.print("BUTTON ");
-                Serial.print(i + 1);
-                Serial.print(" PRESSED! (Distance: ");
-                Serial.print(distanceFromBaseline);
-                Serial.print(", Threshold: ");
-                Serial.print(PRESS_THRESHOLDS[i]);
-                Serial.println(")");
+                LOG(LOG_BUTTON_PRESSED, i + 1, distanceFromBaseline, PRESS_THRESHOLDS[i]);
             }
         } else {
             // Check for release - need to return close to baseline
@@ -509,13 +820,7 @@ void updateFingerButtons() {
                 fingerButtons[i].isPressed = false;
                 fingerButtons[i].lastChange = currentTime;
                 
-                Serial.print("BUTTON ");
-                Serial.print(i + 1);
-                Serial.print(" RELEASED! (Distance: ");
-                Serial.print(distanceFromBaseline);
-                Serial.print(", Threshold: ");
-                Serial.print(RELEASE_THRESHOLDS[i]);
-                Serial.println(")");
+                LOG(LOG_BUTTON_RELEASED, i + 1, distanceFromBaseline, RELEASE_THRESHOLDS[i]);
             }
         }
         
@@ -524,6 +829,45 @@ void updateFingerButtons() {
     }
 }
 
+// Gathers everything the transports send about the current capture
+void buildGloveFrame(GloveFrame* frame) {
+    if (frame->header.magic != HAND_FRAME_MAGIC) {
+        hand::initFrame(frame);
+    }
+    frame->timestamp_us = currentFrame.timestamp_us;
+    frame->sequence = currentFrame.sequence;
+    for (int i = 0; i < NUM_JOINTS; i++) {
+        frame->joints[i] = constrain(currentFrame.angles[i], INT16_MIN, INT16_MAX);
+    }
+
+    // Orientation is evaluated at the finger frame's capture time so both
+    // describe the same instant
+    float orientation[4] = {quaternion_x, quaternion_y, quaternion_z, quaternion_w};
+    imuHistoryAt(currentFrame.timestamp_us, orientation);
+    for (int i = 0; i < 4; i++) {
+        frame->quat[i] = hand::toFixed(orientation[i], HAND_FRAME_QUAT_SCALE);
+    }
+    // Gyro and acceleration come from the batched reports nearest that instant
+    ImuVectorSample linear = {0, linear_x, linear_y, linear_z};
+    ImuVectorSample gyro = {0, gyro_x, gyro_y, gyro_z};
+    bno085SampleAt(IMU_LINEAR_ACCEL, currentFrame.timestamp_us, &linear);
+    bno085SampleAt(IMU_GYRO, currentFrame.timestamp_us, &gyro);
+    frame->linear[0] = hand::toFixed(linear.x, HAND_FRAME_LINEAR_SCALE);
+    frame->linear[1] = hand::toFixed(linear.y, HAND_FRAME_LINEAR_SCALE);
+    frame->linear[2] = hand::toFixed(linear.z, HAND_FRAME_LINEAR_SCALE);
+    frame->gyro[0] = hand::toFixed(gyro.x, HAND_FRAME_GYRO_SCALE);
+    frame->gyro[1] = hand::toFixed(gyro.y, HAND_FRAME_GYRO_SCALE);
+    frame->gyro[2] = hand::toFixed(gyro.z, HAND_FRAME_GYRO_SCALE);
+
+    uint16_t buttons = 0;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        buttons |= (uint16_t)fingerButtons[i].isPressed << i;
+    }
+    frame->buttons = buttons;
+    frame->fault_mask = sensorFaultMask;
+    frame->imu_status = bno085Status();
+}
+
 void loop() {
     // Print connection status every 3 seconds
     // static unsigned long lastStatusTime = 0;
@@ -555,157 +899,111 @@ void loop() {
         oldDeviceConnected = deviceConnected;
     }
     
-    // Update finger tracking data
-    calcFingerAngles();
+    // Finger angles are captured by the sampler task on its timer; wait for
+    // the next frame so loop() runs once per capture
+    bool newFrame = samplerWaitFrame(100) && readCapturedFrame(&currentFrame);
 
     // Update BNO085 data
     updateBNO085();
 
-    // Send data if connected
-    if (deviceConnected) {
-        // Read the button state from the Xiao ESP32-C3
-        int buttonState = !digitalRead(BUTTON_PIN);
-        
-        // Toggle between modes on button release
-        static bool lastButtonState = false;
-        if (!buttonState && lastButtonState) {  // Button was released
-            cycleToNextMode();
-        }
-        lastButtonState = buttonState;
-        
-        // Update the gamepad report structure
-        // Clear all buttons first
-        memset(&gamepadReport, 0, sizeof(GamepadReport));
-        
-        // Set button6 based on the physical button
-        // gamepadReport.button6 = buttonState;
-        
-        // Set buttons to indicate current mode (optional)
-        // gamepadReport.button1 = (currentMode == GAME_MODE);
-        // gamepadReport.button2 = (currentMode == RAW_ANGLES_MODE);
-        
-        // Process data based on the current mode
-        switch (currentMode) {
-            case GAME_MODE:
-                // GAME MODE: Use mapped controls for gameplay
+#ifdef DRIFT_DIE_TEMPERATURE
+    // The BNO085 does not report a temperature; the C3's die sensor sits on
+    // the same board and tracks it well enough for the slow gain drift
+    static unsigned long lastTemperatureTime = 0;
+    if (millis() - lastTemperatureTime > 1000) {
+        lastTemperatureTime = millis();
+        driftSetTemperature(temperatureRead());
+    }
+#endif
 
-                // Update finger button states based on position changes
-                updateFingerButtons();
+    // References and corrections captured by the sampler are written to flash here
+    driftCompensationService();
+    crosstalkService();
 
-                // Set button states based on detected gestures
-                gamepadReport.button1 = fingerButtons[0].isPressed; // Thumb
-                gamepadReport.button2 = fingerButtons[1].isPressed; // Pinky finger
-                gamepadReport.button3 = fingerButtons[2].isPressed; // Ring finger
-                gamepadReport.button4 = fingerButtons[3].isPressed; // Middle finger
-                gamepadReport.button5 = fingerButtons[4].isPressed; // Index finger
+    // Keep actuator slew and link-loss watchdog running between packets
+    hapticUpdate();
 
-                // Map roll angle to X-axis (left/right movement)
-                gamepadReport.axes[0] = constrain(map(ypr.roll, -45, 45, 0, 255), 0, 255);
+    handleSerialCommands();
 
-                // Map pitch angle to Y-axis (up/down movement)
-                // gamepadReport.axes[1] = constrain(map(ypr.pitch, -45, 45, 0, 255), 0, 255);
+    // Read the button state from the Xiao ESP32-C3
+    int buttonState = !digitalRead(BUTTON_PIN);
 
-                // Apply deadzone to both axes
-                // gamepadReport.axes[0] = applyDeadzone(gamepadReport.axes[0], DEADZONE);
-                // gamepadReport.axes[1] = applyDeadzone(gamepadReport.axes[1], DEADZONE);
+    // Toggle between modes on button release
+    static bool lastButtonState = false;
+    if (!buttonState && lastButtonState) {  // Button was released
+        cycleToNextMode();
+    }
+    lastButtonState = buttonState;
 
-                // Fill remaining axes with zeros or other mapped values
-                for (int i = 2; i < 16; i++) {
-                    gamepadReport.axes[i] = 127;
-                }
-                break;
-                
-            case RAW_ANGLES_MODE:
-                // RAW ANGLES MODE: Show all raw angle values
+    // Update finger button states based on position changes
+    if (newFrame && currentMode == GAME_MODE && !gestureModelLoaded()) {
+        updateFingerButtons();
+    }
 
-                // Map all raw angle values directly to axes
-                for (int i = 0; i < NUM_JOINTS && i < 16; i++) {
-                    gamepadReport.axes[i] = mapAngleToHID(angles[i], 0, 255);
-                }
+    // One frame per capture, built once and handed to every active transport
+    static GloveFrame frame;
+    if (newFrame) {
+        buildGloveFrame(&frame);
+        if (currentMode == GAME_MODE && gestureModelLoaded()) {
+            // The classifier sees the same joints and orientation the transports send
+            frame.buttons = gestureButtons(gestureUpdate(frame));
+        }
+        transportPublish(frame);
+        recordBootTiming(frame);
+    }
 
-                // Add quaternion values to the next 4 axes
-                gamepadReport.axes[16] = quaternionToAxis(quaternion_x);
-                gamepadReport.axes[17] = quaternionToAxis(quaternion_y);
-                gamepadReport.axes[18] = quaternionToAxis(quaternion_z);
-                gamepadReport.axes[19] = quaternionToAxis(quaternion_w);
-
-                // Add linear acceleration values to the next 3 axes
-                // Map from typical acceleration range (-8 to +8 m/s²) to 0-255
-                gamepadReport.axes[20] = constrain(map(linear_x * 16, -128, 127, 0, 255), 0, 255);
-                gamepadReport.axes[21] = constrain(map(linear_y * 16, -128, 127, 0, 255), 0, 255);
-                gamepadReport.axes[22] = constrain(map(linear_z * 16, -128, 127, 0, 255), 0, 255);
-                break;
+    // Debug output - only show when mode changes or periodically
+    static unsigned long lastDebugTime = 0;
+
+    if (deviceConnected && (modeJustChanged || millis() - lastDebugTime > 100)) {
+        lastDebugTime = millis();
 
+        // Serial.print("Current mode: ");
+        switch (currentMode) {
+            // case GAME_MODE:
+            //     Serial.println("Game Mode");
+            //     Serial.println("Game controls active - mapped for gameplay");
+            //     break;
+            case RAW_ANGLES_MODE:
+                // Serial.println("Raw Angles Mode");
+                // Serial.println("Showing raw angle values on all axes");
+                // printRawAngles();
+                // printFingerAngles();
+                break;
             default:
-                // Fallback mode - just use raw angles
-                for (int i = 0; i < NUM_JOINTS && i < 16; i++) {
-                    gamepadReport.axes[i] = mapAngleToHID(angles[i], 0, 255);
-                }
+                // Serial.println("Unknown Mode");
                 break;
         }
-        
-        if (inputGamepad != nullptr) {
-            // Convert the struct to a byte array for sending
-            uint8_t reportBuffer[sizeof(GamepadReport)];
-            memcpy(reportBuffer, &gamepadReport, sizeof(GamepadReport));
-            
-            // Send the report
-            inputGamepad->setValue(reportBuffer, sizeof(reportBuffer));
-            inputGamepad->notify();
-            
-            // Debug output - only show when mode changes or periodically
-            static unsigned long lastDebugTime = 0;
-            
-            if (modeJustChanged || millis() - lastDebugTime > 100) {
-                lastDebugTime = millis();
-                
-                // Serial.print("Current mode: ");
-                switch (currentMode) {
-                    // case GAME_MODE:
-                    //     Serial.println("Game Mode");
-                    //     Serial.println("Game controls active - mapped for gameplay");
-                    //     break;
-                    case RAW_ANGLES_MODE:
-                        // Serial.println("Raw Angles Mode");
-                        // Serial.println("Showing raw angle values on all axes");
-                        // printRawAngles();
-                        // printFingerAngles();
-                        break;
-                    default:
-                        // Serial.println("Unknown Mode");
-                        break;
-                }
-                
-                // // Print a few values for verification
-                // for (int i = 0; i < NUM_JOINTS; i++) {
-                //     Serial.print("Angle ");
-                //     Serial.print(i);
-                //     Serial.print(": ");
-                //     Serial.print(angles[i]);
-                //     Serial.print(" -> Axis value: ");
-                //     Serial.println(gamepadReport.axes[i]);
-                // }
-                // Serial.println("...");
-                
-                modeJustChanged = false;
-            }
-        } else {
-            Serial.println("Error: inputGamepad is null");
-        }
-        
-        // Small delay to prevent flooding
-        delay(1); // High update rate
-    } else {
-        // Even when not connected, calculate and display angles for debugging
-        // static unsigned long lastDebugTime = 0;
-        // if (millis() - lastDebugTime > 1000) { // Only print once per second
-        //     lastDebugTime = millis();
-        //     Serial.println("Current finger angles (not connected):");
-        //     printFingerAngles();
+
+        // // Print a few values for verification
+        // for (int i = 0; i < NUM_JOINTS; i++) {
+        //     Serial.print("Angle ");
+        //     Serial.print(i);
+        //     Serial.print(": ");
+        //     Serial.print(angles[i]);
+        //     Serial.print(" -> Axis value: ");
+        //     Serial.println(fingerReport.data[i]);
         // }
-        
-        // Slower update rate when not connected to save power
-        // delay(100);
+        // Serial.println("...");
+
+        modeJustChanged = false;
+    }
+
+    // No delay needed: samplerWaitFrame() paces the loop at the sample rate
+
+    // Timing statistics are printed from loop(), never from the sampler task
+    static unsigned long lastStatsPrint = 0;
+    if (currentMode == DIAGNOSTICS_MODE && millis() - lastStatsPrint >= 1000) {
+        lastStatsPrint = millis();
+        printSamplerStats();
+        printAcquisitionStats();
+        printBNO085Stats();
+        printHapticLatency();
+    }
+    static unsigned long lastMemoryPrint = 0;
+    if (currentMode == DIAGNOSTICS_MODE && millis() - lastMemoryPrint >= 10000) {
+        lastMemoryPrint = millis();
+        printMemory();
     }
 
     // In your loop function
@@ -713,12 +1011,4 @@ void loop() {
         Serial.println("Restarting advertising to reconnect...");
         NimBLEDevice::startAdvertising();
     }
-
-    // Add this to your loop to monitor memory
-    // static unsigned long lastMemCheck = 0;
-    // if (millis() - lastMemCheck > 10000) {
-    //     lastMemCheck = millis();
-    //     Serial.print("Free heap: ");
-    //     Serial.println(ESP.getFreeHeap());
-    // }
 }
@@ -0,0 +1,412 @@
+#include "GloveDataset.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dataset {
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+template <typename Delta, typename Out>
+static void prefixSum(const uint8_t* data, int64_t base, uint32_t count, Out* out) {
+    const Delta* deltas = reinterpret_cast<const Delta*>(data);
+    int64_t value = base;
+    out[0] = (Out)value;
+    for (uint32_t i = 1; i < count; i++) {
+        value += deltas[i - 1];
+        out[i] = (Out)value;
+    }
+}
+
+template <typename Out>
+static void decodeColumn(const ColumnDesc* desc, const uint8_t* data, uint32_t count, Out* out) {
+    if (count == 0) return;
+    switch (desc->encoding) {
+        case ENC_DELTA8:
+            prefixSum<int8_t>(data, desc->base, count, out);
+            break;
+        case ENC_DELTA16:
+            prefixSum<int16_t>(data, desc->base, count, out);
+            break;
+        case ENC_DELTA32:
+            prefixSum<int32_t>(data, desc->base, count, out);
+            break;
+        case ENC_RAW64: {
+            const int64_t* values = reinterpret_cast<const int64_t*>(data);
+            for (uint32_t i = 0; i < count; i++) out[i] = (Out)values[i];
+            break;
+        }
+    }
+}
+
+void ColumnView::decode(int64_t* out) const {
+    decodeColumn(desc_, data_, count_, out);
+}
+
+void ColumnView::decode(int32_t* out) const {
+    decodeColumn(desc_, data_, count_, out);
+}
+
+void ColumnView::decodeQuat(float* out) const {
+    decodeColumn(desc_, data_, count_, out);
+    for (uint32_t i = 0; i < count_; i++) out[i] /= DATASET_QUAT_SCALE;
+}
+
+ColumnView ChunkView::column(uint16_t id) const {
+    const ChunkHeader& head = header();
+    const ColumnDesc* descs = reinterpret_cast<const ColumnDesc*>(base_ + sizeof(ChunkHeader));
+    for (uint16_t i = 0; i < head.column_count; i++) {
+        if (descs[i].column_id == id) {
+            return ColumnView(&descs[i], base_ + descs[i].data_offset, head.frame_count);
+        }
+    }
+    return ColumnView();
+}
+
+uint32_t ChunkView::lowerBound(int64_t t_us) const {
+    ColumnView ts = column(COL_TIMESTAMP_US);
+    uint32_t count = frameCount();
+    if (!ts.valid() || count == 0 || t_us <= firstTimestamp()) return 0;
+    if (t_us > lastTimestamp()) return count;
+
+    // Timestamps are monotonic, so a running sum over the stored deltas
+    // finds the frame without materializing the column.
+    int64_t value = ts.base();
+    switch (ts.encoding()) {
+        case ENC_DELTA8: {
+            Span<int8_t> d = ts.deltas8();
+            for (uint32_t i = 1; i < count; i++) if ((value += d[i - 1]) >= t_us) return i;
+            break;
+        }
+        case ENC_DELTA16: {
+            Span<int16_t> d = ts.deltas16();
+            for (uint32_t i = 1; i < count; i++) if ((value += d[i - 1]) >= t_us) return i;
+            break;
+        }
+        case ENC_DELTA32: {
+            Span<int32_t> d = ts.deltas32();
+            for (uint32_t i = 1; i < count; i++) if ((value += d[i - 1]) >= t_us) return i;
+            break;
+        }
+        case ENC_RAW64: {
+            Span<int64_t> v = ts.values64();
+            for (uint32_t i = 0; i < count; i++) if (v[i] >= t_us) return i;
+            break;
+        }
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+
+DatasetWriter::~DatasetWriter() {
+    if (file_) close();
+}
+
+bool DatasetWriter::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool DatasetWriter::writeBytes(const void* data, size_t len) {
+    if (fwrite(data, 1, len, file_) != len) return fail("write failed");
+    offset_ += len;
+    return true;
+}
+
+bool DatasetWriter::open(const std::string& path, uint32_t device_id, int64_t created_unix_ms,
+                         uint32_t chunk_frames) {
+    if (file_) return fail("writer already open");
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) return fail("cannot open " + path);
+
+    chunk_frames_ = chunk_frames > 0 ? chunk_frames : DATASET_DEFAULT_CHUNK_FRAMES;
+    offset_ = 0;
+    frame_count_ = 0;
+    last_timestamp_ = 0;
+    index_.clear();
+    for (int c = 0; c < COL_COUNT; c++) {
+        columns_[c].clear();
+        columns_[c].reserve(chunk_frames_);
+    }
+
+    FileHeader head;
+    memset(&head, 0, sizeof(head));
+    head.magic = DATASET_FILE_MAGIC;
+    head.version = DATASET_VERSION;
+    head.header_size = sizeof(FileHeader);
+    head.device_id = device_id;
+    head.joint_count = DATASET_JOINT_COUNT;
+    head.created_unix_ms = created_unix_ms;
+    return writeBytes(&head, sizeof(head));
+}
+
+bool DatasetWriter::append(const Frame& frame) {
+    if (!file_) return fail("writer not open");
+    if (frame_count_ + columns_[COL_TIMESTAMP_US].size() > 0 && frame.timestamp_us < last_timestamp_) {
+        return fail("timestamps must be monotonic");
+    }
+    last_timestamp_ = frame.timestamp_us;
+
+    columns_[COL_TIMESTAMP_US].push_back(frame.timestamp_us);
+    for (int j = 0; j < DATASET_JOINT_COUNT; j++) {
+        columns_[COL_JOINT_0 + j].push_back(frame.joints[j]);
+    }
+    for (int q = 0; q < DATASET_QUAT_COUNT; q++) {
+        columns_[COL_QUAT_X + q].push_back((int64_t)lrintf(frame.quat[q] * DATASET_QUAT_SCALE));
+    }
+
+    if (columns_[COL_TIMESTAMP_US].size() >= chunk_frames_) return flushChunk();
+    return true;
+}
+
+// Picks the narrowest delta width for the column and appends its bytes to out
+static Encoding encodeColumn(const std::vector<int64_t>& values, std::vector<uint8_t>& out) {
+    int64_t lo = 0, hi = 0;
+    for (size_t i = 1; i < values.size(); i++) {
+        int64_t d = values[i] - values[i - 1];
+        if (d < lo) lo = d;
+        if (d > hi) hi = d;
+    }
+
+    Encoding enc;
+    size_t width;
+    if (lo >= INT8_MIN && hi <= INT8_MAX) {
+        enc = ENC_DELTA8;
+        width = 1;
+    } else if (lo >= INT16_MIN && hi <= INT16_MAX) {
+        enc = ENC_DELTA16;
+        width = 2;
+    } else if (lo >= INT32_MIN && hi <= INT32_MAX) {
+        enc = ENC_DELTA32;
+        width = 4;
+    } else {
+        enc = ENC_RAW64;
+        width = 8;
+    }
+
+    size_t start = out.size();
+    if (enc == ENC_RAW64) {
+        out.resize(start + values.size() * width);
+        memcpy(&out[start], values.data(), values.size() * width);
+        return enc;
+    }
+
+    size_t n = values.empty() ? 0 : values.size() - 1;
+    out.resize(start + n * width);
+    uint8_t* dst = out.data() + start;
+    for (size_t i = 0; i < n; i++) {
+        int64_t d = values[i + 1] - values[i];
+        switch (enc) {
+            case ENC_DELTA8:  { int8_t v = (int8_t)d;   memcpy(dst + i, &v, 1); break; }
+            case ENC_DELTA16: { int16_t v = (int16_t)d; memcpy(dst + i * 2, &v, 2); break; }
+            default:          { int32_t v = (int32_t)d; memcpy(dst + i * 4, &v, 4); break; }
+        }
+    }
+    return enc;
+}
+
+bool DatasetWriter::flushChunk() {
+    const std::vector<int64_t>& ts = columns_[COL_TIMESTAMP_US];
+    if (ts.empty()) return true;
+
+    ChunkHeader head;
+    memset(&head, 0, sizeof(head));
+    head.magic = DATASET_CHUNK_MAGIC;
+    head.frame_count = (uint32_t)ts.size();
+    head.column_count = COL_COUNT;
+    head.t_first_us = ts.front();
+    head.t_last_us = ts.back();
+
+    ColumnDesc descs[COL_COUNT];
+    memset(descs, 0, sizeof(descs));
+
+    scratch_.clear();
+    size_t data_start = align8(sizeof(ChunkHeader) + sizeof(descs));
+    for (int c = 0; c < COL_COUNT; c++) {
+        scratch_.resize(align8(scratch_.size()), 0);
+        size_t before = scratch_.size();
+        descs[c].column_id = (uint16_t)c;
+        descs[c].encoding = encodeColumn(columns_[c], scratch_);
+        descs[c].data_offset = (uint32_t)(data_start + before);
+        descs[c].data_bytes = (uint32_t)(scratch_.size() - before);
+        descs[c].base = columns_[c].front();
+    }
+    scratch_.resize(align8(scratch_.size()), 0);
+    head.chunk_bytes = (uint32_t)(data_start + scratch_.size());
+
+    IndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.t_first_us = head.t_first_us;
+    entry.t_last_us = head.t_last_us;
+    entry.offset = offset_;
+    entry.frame_count = head.frame_count;
+
+    static const uint8_t pad[8] = {0};
+    if (!writeBytes(&head, sizeof(head))) return false;
+    if (!writeBytes(descs, sizeof(descs))) return false;
+    if (!writeBytes(pad, data_start - sizeof(head) - sizeof(descs))) return false;
+    if (!writeBytes(scratch_.data(), scratch_.size())) return false;
+
+    index_.push_back(entry);
+    frame_count_ += head.frame_count;
+    for (int c = 0; c < COL_COUNT; c++) columns_[c].clear();
+    return true;
+}
+
+bool DatasetWriter::close() {
+    if (!file_) return fail("writer not open");
+    bool ok = flushChunk();
+
+    FileTrailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.index_offset = offset_;
+    trailer.frame_count = frame_count_;
+    trailer.chunk_count = (uint32_t)index_.size();
+    trailer.magic = DATASET_INDEX_MAGIC;
+
+    ok = ok && writeBytes(index_.data(), index_.size() * sizeof(IndexEntry));
+    ok = ok && writeBytes(&trailer, sizeof(trailer));
+    if (fclose(file_) != 0 && ok) ok = fail("close failed");
+    file_ = nullptr;
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+
+DatasetReader::~DatasetReader() {
+    close();
+}
+
+bool DatasetReader::fail(const std::string& message) {
+    error_ = message;
+    close();
+    return false;
+}
+
+// Bytes a column of count frames takes with the given encoding, 0 if unknown
+static uint64_t columnBytes(uint8_t encoding, uint32_t count) {
+    uint64_t deltas = count > 0 ? count - 1 : 0;
+    switch (encoding) {
+        case ENC_DELTA8: return deltas;
+        case ENC_DELTA16: return deltas * 2;
+        case ENC_DELTA32: return deltas * 4;
+        case ENC_RAW64: return (uint64_t)count * 8;
+    }
+    return 0;
+}
+
+bool DatasetReader::checkChunk(const ChunkView& view, const IndexEntry& entry, uint64_t max_bytes) {
+    const ChunkHeader& ch = view.header();
+    if (ch.magic != DATASET_CHUNK_MAGIC || ch.chunk_bytes > max_bytes) return fail("corrupt chunk");
+    if (ch.frame_count != entry.frame_count || ch.t_first_us != entry.t_first_us ||
+        ch.t_last_us != entry.t_last_us) {
+        return fail("chunk does not match its index entry");
+    }
+
+    uint64_t descs_end = sizeof(ChunkHeader) + (uint64_t)ch.column_count * sizeof(ColumnDesc);
+    if (descs_end > ch.chunk_bytes) return fail("corrupt chunk column count");
+
+    const ColumnDesc* descs = reinterpret_cast<const ColumnDesc*>(map_ + entry.offset + sizeof(ChunkHeader));
+    for (uint16_t c = 0; c < ch.column_count; c++) {
+        const ColumnDesc& desc = descs[c];
+        if (desc.encoding < ENC_DELTA8 || desc.encoding > ENC_RAW64) return fail("unknown column encoding");
+        if (desc.data_bytes != columnBytes(desc.encoding, ch.frame_count)) {
+            return fail("column size does not match the frame count");
+        }
+        if (desc.data_offset < descs_end || desc.data_offset % 8 != 0 ||
+            (uint64_t)desc.data_offset + desc.data_bytes > ch.chunk_bytes) {
+            return fail("column outside its chunk");
+        }
+    }
+    return true;
+}
+
+bool DatasetReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail("cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return fail("cannot stat " + path);
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ < sizeof(FileHeader) + sizeof(FileTrailer)) {
+        ::close(fd);
+        return fail("file too small");
+    }
+
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        size_ = 0;
+        return fail("mmap failed");
+    }
+    map_ = static_cast<const uint8_t*>(map);
+
+    const FileHeader& head = header();
+    if (head.magic != DATASET_FILE_MAGIC) return fail("not a glove dataset");
+    if (head.version > DATASET_VERSION) return fail("unsupported dataset version");
+
+    const FileTrailer* trailer = reinterpret_cast<const FileTrailer*>(map_ + size_ - sizeof(FileTrailer));
+    if (trailer->magic != DATASET_INDEX_MAGIC) return fail("missing footer index (truncated file?)");
+    uint64_t index_bytes = (uint64_t)trailer->chunk_count * sizeof(IndexEntry);
+
+    if (trailer->index_offset < sizeof(FileHeader) || trailer->index_offset > size_) return fail("corrupt footer index");
+    if (trailer->index_offset + index_bytes + sizeof(FileTrailer) != size_) return fail("corrupt footer index");
+
+    index_ = reinterpret_cast<const IndexEntry*>(map_ + trailer->index_offset);
+    chunk_count_ = trailer->chunk_count;
+    frame_count_ = trailer->frame_count;
+
+    // Views trust the chunk layout, so check all of it here once
+    uint64_t frames = 0;
+    for (uint32_t i = 0; i < chunk_count_; i++) {
+        const IndexEntry& entry = index_[i];
+        if (entry.offset < sizeof(FileHeader) || entry.offset % 8 != 0 || entry.offset > trailer->index_offset ||
+            trailer->index_offset - entry.offset < sizeof(ChunkHeader)) {
+            return fail("corrupt chunk offset");
+        }
+        if (i > 0 && entry.t_last_us < index_[i - 1].t_last_us) return fail("index not sorted by time");
+        if (!checkChunk(chunk(i), entry, trailer->index_offset - entry.offset)) return false;
+        frames += entry.frame_count;
+    }
+    if (frames != frame_count_) return fail("frame count does not match the chunks");
+
+    madvise(const_cast<uint8_t*>(map_), size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+void DatasetReader::close() {
+    if (map_) munmap(const_cast<uint8_t*>(map_), size_);
+    map_ = nullptr;
+    size_ = 0;
+    index_ = nullptr;
+    chunk_count_ = 0;
+    frame_count_ = 0;
+}
+
+uint32_t DatasetReader::findChunk(int64_t t_us) const {
+    uint32_t lo = 0, hi = chunk_count_;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (index_[mid].t_last_us < t_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+}  // namespace dataset
@@ -0,0 +1,268 @@
+#ifndef GLOVE_DATASET_H
+#define GLOVE_DATASET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Columnar, chunked session file for recorded glove frames.
+//
+// Layout (all integers little endian):
+//   FileHeader
+//   Chunk 0 .. Chunk N-1     each: ChunkHeader, ColumnDesc[], column data
+//   IndexEntry[N]            one per chunk, sorted by time
+//   FileTrailer              points back at the index
+//
+// Every column of a chunk is stored contiguously. Integer columns are delta
+// encoded against the first value of the chunk using the narrowest width
+// that fits, so the reader can hand out the stored bytes without copying.
+
+#define DATASET_JOINT_COUNT 16
+#define DATASET_QUAT_COUNT 4
+#define DATASET_DEFAULT_CHUNK_FRAMES 4096
+
+// Quaternion components are stored as Q14 fixed point (1.0 == 16384)
+#define DATASET_QUAT_SCALE 16384.0f
+
+namespace dataset {
+
+enum ColumnId : uint16_t {
+    COL_TIMESTAMP_US = 0,
+    COL_JOINT_0 = 1,  // COL_JOINT_0 + i for joint i
+    COL_QUAT_X = COL_JOINT_0 + DATASET_JOINT_COUNT,
+    COL_QUAT_Y,
+    COL_QUAT_Z,
+    COL_QUAT_W,
+    COL_COUNT
+};
+
+enum Encoding : uint8_t {
+    ENC_DELTA8 = 1,   // base + int8 deltas
+    ENC_DELTA16 = 2,  // base + int16 deltas
+    ENC_DELTA32 = 3,  // base + int32 deltas
+    ENC_RAW64 = 4     // int64 values, no base
+};
+
+#pragma pack(push, 1)
+struct FileHeader {
+    uint32_t magic;          // DATASET_FILE_MAGIC
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t device_id;      // Glove that produced the session
+    uint16_t joint_count;
+    uint16_t flags;
+    int64_t created_unix_ms;
+    uint8_t reserved[8];
+};
+
+struct ChunkHeader {
+    uint32_t magic;          // DATASET_CHUNK_MAGIC
+    uint32_t frame_count;
+    uint16_t column_count;
+    uint16_t reserved;
+    uint32_t chunk_bytes;    // Header, descriptors and data
+    int64_t t_first_us;
+    int64_t t_last_us;
+};
+
+struct ColumnDesc {
+    uint16_t column_id;
+    uint8_t encoding;
+    uint8_t reserved;
+    uint32_t data_offset;    // Relative to the start of the chunk
+    uint32_t data_bytes;
+    uint32_t reserved2;
+    int64_t base;
+};
+
+struct IndexEntry {
+    int64_t t_first_us;
+    int64_t t_last_us;
+    uint64_t offset;
+    uint32_t frame_count;
+    uint32_t reserved;
+};
+
+struct FileTrailer {
+    uint64_t index_offset;
+    uint64_t frame_count;
+    uint32_t chunk_count;
+    uint32_t magic;          // DATASET_INDEX_MAGIC
+};
+#pragma pack(pop)
+
+static const uint32_t DATASET_FILE_MAGIC = 0x53444745;   // "EGDS"
+static const uint32_t DATASET_CHUNK_MAGIC = 0x4B434745;  // "EGCK"
+static const uint32_t DATASET_INDEX_MAGIC = 0x58494745;  // "EGIX"
+static const uint16_t DATASET_VERSION = 1;
+
+/**
+ * One recorded glove frame as the writer receives it.
+ */
+struct Frame {
+    int64_t timestamp_us;
+    int32_t joints[DATASET_JOINT_COUNT];
+    float quat[DATASET_QUAT_COUNT];  // x, y, z, w
+};
+
+/**
+ * Read-only view over a run of T values that lives inside the mapped file.
+ */
+template <typename T>
+struct Span {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+    const T& operator[](size_t i) const { return data[i]; }
+    bool empty() const { return size == 0; }
+};
+
+/**
+ * Zero-copy handle on one stored column of one chunk. deltas8/16/32() and
+ * values64() return the stored bytes directly; decode() reconstructs the
+ * absolute values into a caller buffer of count() entries.
+ */
+class ColumnView {
+public:
+    ColumnView() {}
+    ColumnView(const ColumnDesc* desc, const uint8_t* data, uint32_t count)
+        : desc_(desc), data_(data), count_(count) {}
+
+    bool valid() const { return desc_ != nullptr; }
+    uint16_t id() const { return desc_->column_id; }
+    Encoding encoding() const { return (Encoding)desc_->encoding; }
+    int64_t base() const { return desc_->base; }
+    uint32_t count() const { return count_; }
+    Span<uint8_t> bytes() const { return {data_, desc_->data_bytes}; }
+
+    Span<int8_t> deltas8() const { return typed<int8_t>(ENC_DELTA8); }
+    Span<int16_t> deltas16() const { return typed<int16_t>(ENC_DELTA16); }
+    Span<int32_t> deltas32() const { return typed<int32_t>(ENC_DELTA32); }
+    Span<int64_t> values64() const { return typed<int64_t>(ENC_RAW64); }
+
+    void decode(int64_t* out) const;
+    void decode(int32_t* out) const;
+    void decodeQuat(float* out) const;
+
+private:
+    template <typename T>
+    Span<T> typed(Encoding enc) const {
+        if (!desc_ || desc_->encoding != enc) return {};
+        return {reinterpret_cast<const T*>(data_), desc_->data_bytes / sizeof(T)};
+    }
+
+    const ColumnDesc* desc_ = nullptr;
+    const uint8_t* data_ = nullptr;
+    uint32_t count_ = 0;
+};
+
+/**
+ * One chunk inside the mapped file.
+ */
+class ChunkView {
+public:
+    ChunkView() {}
+    explicit ChunkView(const uint8_t* base) : base_(base) {}
+
+    const ChunkHeader& header() const { return *reinterpret_cast<const ChunkHeader*>(base_); }
+    uint32_t frameCount() const { return header().frame_count; }
+    int64_t firstTimestamp() const { return header().t_first_us; }
+    int64_t lastTimestamp() const { return header().t_last_us; }
+
+    /**
+     * Returns the column with the given id, or an invalid view if the chunk
+     * does not carry it.
+     */
+    ColumnView column(uint16_t id) const;
+
+    /**
+     * Index of the first frame at or after t_us within this chunk.
+     */
+    uint32_t lowerBound(int64_t t_us) const;
+
+private:
+    const uint8_t* base_ = nullptr;
+};
+
+/**
+ * Writes a session file. Frames are buffered column-wise and flushed as one
+ * chunk every chunk_frames frames; close() writes the footer index.
+ */
+class DatasetWriter {
+public:
+    DatasetWriter() {}
+    ~DatasetWriter();
+
+    bool open(const std::string& path, uint32_t device_id, int64_t created_unix_ms = 0,
+              uint32_t chunk_frames = DATASET_DEFAULT_CHUNK_FRAMES);
+    bool append(const Frame& frame);
+    bool close();
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool flushChunk();
+    bool writeBytes(const void* data, size_t len);
+    bool fail(const std::string& message);
+
+    FILE* file_ = nullptr;
+    std::string error_;
+    uint32_t chunk_frames_ = DATASET_DEFAULT_CHUNK_FRAMES;
+    uint64_t offset_ = 0;
+    uint64_t frame_count_ = 0;
+    int64_t last_timestamp_ = 0;             // Of the last frame appended, across chunks
+    std::vector<int64_t> columns_[COL_COUNT];
+    std::vector<IndexEntry> index_;
+    std::vector<uint8_t> scratch_;
+};
+
+/**
+ * Memory-maps a session file and exposes its chunks without copying.
+ * open() checks the layout of every chunk and column against the file, so
+ * views never read outside the mapping. Views stay valid until close() or
+ * destruction.
+ */
+class DatasetReader {
+public:
+    DatasetReader() {}
+    ~DatasetReader();
+
+    DatasetReader(const DatasetReader&) = delete;
+    DatasetReader& operator=(const DatasetReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(map_); }
+    uint32_t chunkCount() const { return chunk_count_; }
+    uint64_t frameCount() const { return frame_count_; }
+    const IndexEntry* index() const { return index_; }
+    ChunkView chunk(uint32_t i) const { return ChunkView(map_ + index_[i].offset); }
+
+    /**
+     * Index of the first chunk whose last timestamp is at or after t_us, or
+     * chunkCount() if the whole file lies before t_us.
+     */
+    uint32_t findChunk(int64_t t_us) const;
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+    bool checkChunk(const ChunkView& view, const IndexEntry& entry, uint64_t max_bytes);
+
+    const uint8_t* map_ = nullptr;
+    size_t size_ = 0;
+    const IndexEntry* index_ = nullptr;
+    uint32_t chunk_count_ = 0;
+    uint64_t frame_count_ = 0;
+    std::string error_;
+};
+
+}  // namespace dataset
+
+#endif
@@ -0,0 +1,231 @@
+// Round-trip test for GloveDataset.
+//
+// Writes a session spanning several chunks whose columns need every
+// encoding, reads it back and compares frame by frame, checks that the writer
+// refuses timestamps going back across a chunk boundary, then damages copies
+// of the file (truncated, chunk and column fields out of range) and checks
+// that DatasetReader::open() rejects each one.
+//
+// Build and run as shown in host/README.md; exits non-zero if any check fails.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "GloveDataset.h"
+
+using namespace dataset;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                      \
+    do {                                                                 \
+        if (!(cond)) {                                                   \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                  \
+        }                                                                \
+    } while (0)
+
+static const uint32_t CHUNK_FRAMES = 100;
+static const uint32_t FRAME_COUNT = 350;  // Three full chunks and a partial one
+
+static Frame makeFrame(uint32_t i) {
+    Frame f;
+    // 5 ms steps (delta16), with a jump past int32 in the third chunk (raw64)
+    f.timestamp_us = 1000000 + (int64_t)i * 5000 + (i >= 250 ? ((int64_t)1 << 33) : 0);
+    for (int j = 0; j < DATASET_JOINT_COUNT; j++) {
+        if (j == 0) {
+            f.joints[j] = 7;                                   // Constant, delta8
+        } else if (j == 1) {
+            f.joints[j] = (i % 2) ? 100000 : -100000;          // delta32
+        } else {
+            f.joints[j] = (int32_t)(1000 * sinf(0.05f * i + j));
+        }
+    }
+    float a = 0.01f * i;
+    f.quat[0] = sinf(a) * 0.5f;
+    f.quat[1] = 0.0f;
+    f.quat[2] = 0.0f;
+    f.quat[3] = cosf(a) * 0.5f;
+    return f;
+}
+
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> bytes;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return bytes;
+    fseek(f, 0, SEEK_END);
+    bytes.resize((size_t)ftell(f));
+    fseek(f, 0, SEEK_SET);
+    if (fread(bytes.data(), 1, bytes.size(), f) != bytes.size()) bytes.clear();
+    fclose(f);
+    return bytes;
+}
+
+static void writeFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(bytes.data(), 1, bytes.size(), f);
+    fclose(f);
+}
+
+static void testRoundTrip(const std::string& path) {
+    DatasetWriter writer;
+    CHECK(writer.open(path, 42, 1234, CHUNK_FRAMES));
+    for (uint32_t i = 0; i < FRAME_COUNT; i++) CHECK(writer.append(makeFrame(i)));
+    CHECK(writer.close());
+
+    DatasetReader reader;
+    if (!reader.open(path)) {
+        fprintf(stderr, "open failed: %s\n", reader.error().c_str());
+        failures++;
+        return;
+    }
+    CHECK(reader.header().device_id == 42);
+    CHECK(reader.header().created_unix_ms == 1234);
+    CHECK(reader.frameCount() == FRAME_COUNT);
+    CHECK(reader.chunkCount() == (FRAME_COUNT + CHUNK_FRAMES - 1) / CHUNK_FRAMES);
+
+    bool seen[ENC_RAW64 + 1] = {};
+    uint32_t frame = 0;
+    std::vector<int64_t> ts(CHUNK_FRAMES);
+    std::vector<int32_t> joint(CHUNK_FRAMES);
+    std::vector<float> quat(CHUNK_FRAMES);
+    for (uint32_t c = 0; c < reader.chunkCount(); c++) {
+        ChunkView chunk = reader.chunk(c);
+        uint32_t n = chunk.frameCount();
+        ColumnView tsCol = chunk.column(COL_TIMESTAMP_US);
+        CHECK(tsCol.valid());
+        tsCol.decode(ts.data());
+        seen[tsCol.encoding()] = true;
+        for (uint32_t i = 0; i < n; i++) CHECK(ts[i] == makeFrame(frame + i).timestamp_us);
+
+        for (int j = 0; j < DATASET_JOINT_COUNT; j++) {
+            ColumnView col = chunk.column(COL_JOINT_0 + j);
+            CHECK(col.valid());
+            col.decode(joint.data());
+            seen[col.encoding()] = true;
+            for (uint32_t i = 0; i < n; i++) CHECK(joint[i] == makeFrame(frame + i).joints[j]);
+        }
+        for (int q = 0; q < DATASET_QUAT_COUNT; q++) {
+            ColumnView col = chunk.column(COL_QUAT_X + q);
+            col.decodeQuat(quat.data());
+            for (uint32_t i = 0; i < n; i++) {
+                CHECK(fabsf(quat[i] - makeFrame(frame + i).quat[q]) <= 0.5f / DATASET_QUAT_SCALE);
+            }
+        }
+        CHECK(!chunk.column(COL_COUNT).valid());
+        frame += n;
+    }
+    CHECK(frame == FRAME_COUNT);
+    for (int e = ENC_DELTA8; e <= ENC_RAW64; e++) CHECK(seen[e]);
+
+    // Seek to a frame in the middle of the second chunk
+    int64_t t = makeFrame(150).timestamp_us;
+    uint32_t c = reader.findChunk(t);
+    CHECK(c == 1);
+    CHECK(reader.chunk(c).lowerBound(t) == 50);
+    CHECK(reader.chunk(c).lowerBound(t - 1) == 50);
+    CHECK(reader.findChunk(makeFrame(FRAME_COUNT - 1).timestamp_us + 1) == reader.chunkCount());
+}
+
+// Timestamps must not go back, also from one chunk to the next
+static void testMonotonicAcrossChunks(const std::string& path) {
+    DatasetWriter writer;
+    CHECK(writer.open(path, 1, 0, CHUNK_FRAMES));
+    for (uint32_t i = 0; i < CHUNK_FRAMES; i++) CHECK(writer.append(makeFrame(i)));
+    // The first chunk has just been flushed
+    CHECK(!writer.append(makeFrame(CHUNK_FRAMES - 2)));
+    CHECK(writer.append(makeFrame(CHUNK_FRAMES - 1)));  // Equal to the last one is fine
+    CHECK(writer.append(makeFrame(CHUNK_FRAMES)));
+    CHECK(writer.close());
+
+    DatasetReader reader;
+    CHECK(reader.open(path));
+    CHECK(reader.frameCount() == CHUNK_FRAMES + 2);
+    CHECK(reader.chunkCount() == 2);
+}
+
+// Applies one kind of damage to a copy of the good file and expects open() to fail
+static void expectRejected(const std::string& good, const std::string& path, const char* what,
+                           void (*damage)(std::vector<uint8_t>&)) {
+    std::vector<uint8_t> bytes = readFile(good);
+    damage(bytes);
+    writeFile(path, bytes);
+
+    DatasetReader reader;
+    if (reader.open(path)) {
+        fprintf(stderr, "%s: damaged file opened\n", what);
+        failures++;
+    } else {
+        printf("%-28s rejected: %s\n", what, reader.error().c_str());
+    }
+}
+
+static ChunkHeader* firstChunk(std::vector<uint8_t>& bytes) {
+    return reinterpret_cast<ChunkHeader*>(&bytes[sizeof(FileHeader)]);
+}
+
+static ColumnDesc* firstColumn(std::vector<uint8_t>& bytes, int c) {
+    return reinterpret_cast<ColumnDesc*>(&bytes[sizeof(FileHeader) + sizeof(ChunkHeader)]) + c;
+}
+
+static void testCorrupted(const std::string& good, const std::string& path) {
+    expectRejected(good, path, "truncated", [](std::vector<uint8_t>& b) { b.resize(b.size() / 2); });
+    expectRejected(good, path, "trailer offset", [](std::vector<uint8_t>& b) {
+        FileTrailer* t = reinterpret_cast<FileTrailer*>(&b[b.size() - sizeof(FileTrailer)]);
+        t->index_offset = ~(uint64_t)0 - 8;
+    });
+    expectRejected(good, path, "chunk offset wraps", [](std::vector<uint8_t>& b) {
+        FileTrailer* t = reinterpret_cast<FileTrailer*>(&b[b.size() - sizeof(FileTrailer)]);
+        IndexEntry* entry = reinterpret_cast<IndexEntry*>(&b[t->index_offset]);
+        entry->offset = ~(uint64_t)0 - 7;  // Multiple of 8; offset + header wraps past zero
+    });
+    expectRejected(good, path, "column count", [](std::vector<uint8_t>& b) {
+        firstChunk(b)->column_count = 0xffff;
+    });
+    expectRejected(good, path, "chunk bytes", [](std::vector<uint8_t>& b) {
+        firstChunk(b)->chunk_bytes = 0xffffffff;
+    });
+    expectRejected(good, path, "frame count", [](std::vector<uint8_t>& b) {
+        firstChunk(b)->frame_count *= 1000;
+    });
+    expectRejected(good, path, "data offset", [](std::vector<uint8_t>& b) {
+        firstColumn(b, COL_JOINT_0 + 3)->data_offset = 0xfffffff8;
+    });
+    expectRejected(good, path, "data offset in descriptors", [](std::vector<uint8_t>& b) {
+        firstColumn(b, COL_JOINT_0 + 3)->data_offset = sizeof(ChunkHeader);
+    });
+    expectRejected(good, path, "data bytes", [](std::vector<uint8_t>& b) {
+        firstColumn(b, COL_TIMESTAMP_US)->data_bytes += 2;
+    });
+    expectRejected(good, path, "encoding", [](std::vector<uint8_t>& b) {
+        firstColumn(b, COL_QUAT_W)->encoding = 9;
+    });
+    expectRejected(good, path, "encoding width", [](std::vector<uint8_t>& b) {
+        // Same bytes read as wider deltas would run past the column
+        firstColumn(b, COL_TIMESTAMP_US)->encoding = ENC_DELTA32;
+    });
+}
+
+int main() {
+    std::string dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    std::string good = dir + "/glove_dataset_test.egds";
+    std::string bad = dir + "/glove_dataset_test_bad.egds";
+
+    testRoundTrip(good);
+    testMonotonicAcrossChunks(bad);
+    testCorrupted(good, bad);
+
+    remove(good.c_str());
+    remove(bad.c_str());
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("GloveDataset round trip OK\n");
+    return 0;
+}
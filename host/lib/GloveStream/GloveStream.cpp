@@ -0,0 +1,115 @@
+#include "GloveStream.h"
+
+namespace stream {
+
+void PacketDecoder::reset() {
+    codec_.reset();
+    haveTimestamp_ = false;
+    lastTimestamp_ = 0;
+    timestamp_ = 0;
+    decoded_ = 0;
+}
+
+int64_t PacketDecoder::unwrap(uint32_t timestamp_us) {
+    // The glove clock is a 32-bit micros() that wraps every ~71 minutes
+    if (haveTimestamp_) {
+        timestamp_ += (int32_t)(timestamp_us - lastTimestamp_);
+    } else {
+        timestamp_ = timestamp_us;
+        haveTimestamp_ = true;
+    }
+    lastTimestamp_ = timestamp_us;
+    return timestamp_;
+}
+
+bool PacketDecoder::decode(const uint8_t* buf, size_t len, std::vector<DecodedFrame>& out) {
+    size_t count = 0;
+    bool ok = codec_.decodePacket(buf, len, scratch_, UINT8_MAX, &count);
+
+    for (size_t i = 0; i < count; i++) {
+        const codec::Frame& in = scratch_[i];
+
+        DecodedFrame decoded = {};
+        decoded.frame.timestamp_us = unwrap(in.timestamp_us);
+        for (int j = 0; j < CODEC_JOINT_COUNT; j++) {
+            decoded.frame.joints[j] = (int32_t)in.joints[j] - CODEC_JOINT_OFFSET;
+        }
+        for (int j = 0; j < CODEC_QUAT_COUNT; j++) {
+            decoded.frame.quat[j] = in.quat[j] / CODEC_QUAT_SCALE;
+        }
+        for (int j = 0; j < CODEC_ACCEL_COUNT; j++) {
+            decoded.accel[j] = in.accel[j] / CODEC_ACCEL_SCALE;
+        }
+        out.push_back(decoded);
+    }
+    decoded_ += count;
+    return ok;
+}
+
+bool PacketDecoder::decode(const hand::FrameView& view, std::vector<DecodedFrame>& out) {
+    if (!view.valid()) {
+        return false;
+    }
+
+    DecodedFrame decoded = {};
+    decoded.frame.timestamp_us = unwrap(view.timestampUs());
+    for (int j = 0; j < HAND_FRAME_JOINT_COUNT; j++) {
+        decoded.frame.joints[j] = view.joint(j);
+    }
+    for (int j = 0; j < 4; j++) {
+        decoded.frame.quat[j] = view.quat(j);
+    }
+    for (int j = 0; j < 3; j++) {
+        decoded.accel[j] = view.linear(j);
+        decoded.gyro[j] = view.gyro(j);
+    }
+    decoded.buttons = view.buttons();
+    decoded.fault_mask = view.faultMask();
+    decoded.imu_status = view.imuStatus();
+    out.push_back(decoded);
+    decoded_++;
+    return true;
+}
+
+size_t StreamDeframer::feed(const uint8_t* buf, size_t len, PacketDecoder& decoder, std::vector<DecodedFrame>& out) {
+    buffer_.insert(buffer_.end(), buf, buf + len);
+
+    size_t packets = 0;
+    size_t pos = 0;
+    while (buffer_.size() - pos >= CODEC_STREAM_HEADER_BYTES) {
+        const uint8_t* p = buffer_.data() + pos;
+        if (p[0] != CODEC_STREAM_SYNC_0 || p[1] != CODEC_STREAM_SYNC_1) {
+            pos++;
+            skipped_++;
+            continue;
+        }
+        size_t length = p[2] | (p[3] << 8);
+        if (length == 0 || length > CODEC_STREAM_MAX_PACKET) {
+            pos++;
+            skipped_++;
+            continue;
+        }
+        if (buffer_.size() - pos < length + CODEC_STREAM_OVERHEAD) {
+            break;  // Wait for the rest of the packet
+        }
+        const uint8_t* packet = p + CODEC_STREAM_HEADER_BYTES;
+        if (codec::streamChecksum(packet, length) != packet[length]) {
+            // Sync bytes inside text or a corrupt packet: resume the hunt one byte on
+            badChecksums_++;
+            pos++;
+            skipped_++;
+            continue;
+        }
+        if (packet[0] == HAND_FRAME_MAGIC) {
+            decoder.decode(hand::FrameView(packet, length), out);
+        } else {
+            decoder.decode(packet, length, out);
+        }
+        packets++;
+        pos += length + CODEC_STREAM_OVERHEAD;
+    }
+    buffer_.erase(buffer_.begin(), buffer_.begin() + pos);
+    return packets;
+}
+
+}  // namespace stream
@@ -0,0 +1,87 @@
+#ifndef GLOVE_STREAM_H
+#define GLOVE_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "FrameCodec.h"
+#include "GloveDataset.h"
+#include "HandFrame.h"
+
+// Host side of the glove frame streams. The bit-level codec is the firmware's
+// own FrameCodec library (firmware/lib/FrameCodec) and uncompressed frames use
+// the shared HandFrame schema (firmware/lib/HandFrame), both compiled
+// unchanged; this layer turns their fixed-point frames into dataset frames.
+
+namespace stream {
+
+struct DecodedFrame {
+    dataset::Frame frame;   // Timestamp unwrapped to 64 bits, quaternion as floats
+    float accel[CODEC_ACCEL_COUNT];  // m/s^2
+    float gyro[3];          // rad/s, zero from the compressed stream
+    uint16_t buttons;       // HandFrame only
+    uint16_t fault_mask;    // HandFrame only
+    uint8_t imu_status;     // HandFrame only
+};
+
+/**
+ * Decodes packets and HandFrames from one glove, in arrival order.
+ */
+class PacketDecoder {
+public:
+    /**
+     * Appends every frame recovered from the packet to out.
+     * @return false if the packet was not a valid codec packet
+     */
+    bool decode(const uint8_t* buf, size_t len, std::vector<DecodedFrame>& out);
+
+    /**
+     * Appends one uncompressed frame read through a HandFrame view.
+     * @return false if the view is not a valid HandFrame
+     */
+    bool decode(const hand::FrameView& view, std::vector<DecodedFrame>& out);
+
+    void reset();
+
+    uint32_t lostPackets() const { return codec_.lostPackets(); }
+    uint32_t droppedFrames() const { return codec_.droppedFrames(); }
+    uint64_t decodedFrames() const { return decoded_; }
+
+private:
+    int64_t unwrap(uint32_t timestamp_us);
+
+    codec::Decoder codec_;
+    codec::Frame scratch_[UINT8_MAX];
+    bool haveTimestamp_ = false;
+    uint32_t lastTimestamp_ = 0;
+    int64_t timestamp_ = 0;
+    uint64_t decoded_ = 0;
+};
+
+/**
+ * Splits a byte stream (USB CDC) into codec packets and HandFrames using the
+ * framing from FrameCodec.h. Text and corrupt packets between frames are skipped.
+ */
+class StreamDeframer {
+public:
+    /**
+     * Consumes bytes; every complete packet or HandFrame is decoded into out.
+     * @return Number of packets decoded from this chunk
+     */
+    size_t feed(const uint8_t* buf, size_t len, PacketDecoder& decoder, std::vector<DecodedFrame>& out);
+
+    void reset() { buffer_.clear(); }
+
+    uint64_t skippedBytes() const { return skipped_; }
+    uint64_t badChecksums() const { return badChecksums_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+    uint64_t skipped_ = 0;
+    uint64_t badChecksums_ = 0;
+};
+
+}  // namespace stream
+
+#endif
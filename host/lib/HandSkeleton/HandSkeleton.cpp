@@ -0,0 +1,404 @@
+#include "HandSkeleton.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <thread>
+
+namespace skeleton {
+
+static const float DEG = 3.14159265358979f / 180.0f;
+static const float DEFAULT_HAND_LENGTH = 0.19f;
+
+// Glove channels (angles[] order) driving each chain
+static const int THUMB_CMC_FLEXION = 0;
+static const int THUMB_CMC_ABDUCTION = 1;
+static const int THUMB_MCP_FLEXION = 2;
+static const int THUMB_IP_FLEXION = 3;
+static const int FINGER_FIRST_CHANNEL = 4;   // Abduction, MCP flexion, PIP flexion per finger
+
+// First skeleton joint of each chain
+static const int chainJoint[SKELETON_FINGER_COUNT] = {
+    JOINT_THUMB_METACARPAL, JOINT_INDEX_METACARPAL, JOINT_MIDDLE_METACARPAL,
+    JOINT_RING_METACARPAL, JOINT_LITTLE_METACARPAL,
+};
+
+Profile defaultProfile(float hand_length) {
+    static const float base[SKELETON_FINGER_COUNT][3] = {
+        {0.025f, -0.005f, -0.015f},
+        {0.020f, 0.000f, -0.032f},
+        {0.000f, 0.000f, -0.030f},
+        {-0.018f, 0.000f, -0.028f},
+        {-0.034f, -0.002f, -0.026f},
+    };
+    static const float length[SKELETON_FINGER_COUNT][4] = {
+        {0.046f, 0.032f, 0.000f, 0.030f},
+        {0.065f, 0.040f, 0.024f, 0.019f},
+        {0.068f, 0.045f, 0.028f, 0.020f},
+        {0.060f, 0.042f, 0.027f, 0.020f},
+        {0.055f, 0.033f, 0.019f, 0.018f},
+    };
+    static const float yaw[SKELETON_FINGER_COUNT] = {40, 8, 0, -6, -14};
+    static const float pitch[SKELETON_FINGER_COUNT] = {35, 0, 0, 0, 0};
+    static const float roll[SKELETON_FINGER_COUNT] = {-60, 0, 0, 0, 0};
+
+    // Degrees per count, from the FingerTracking ranges (e.g. MCP flexion
+    // 0..240 covers 90 degrees)
+    static const float scale[SKELETON_CHANNEL_COUNT] = {
+        50.0f / 255, 40.0f / 125, 55.0f / 255, 80.0f / 255,
+        15.0f / 80, 90.0f / 240, 100.0f / 255,
+        15.0f / 80, 90.0f / 240, 100.0f / 255,
+        15.0f / 80, 90.0f / 240, 100.0f / 255,
+        15.0f / 80, 90.0f / 240, 100.0f / 255,
+    };
+
+    float k = hand_length / DEFAULT_HAND_LENGTH;
+    Profile p;
+    for (int f = 0; f < SKELETON_FINGER_COUNT; f++) {
+        for (int c = 0; c < 3; c++) {
+            p.base[f][c] = base[f][c] * k;
+        }
+        for (int s = 0; s < 4; s++) {
+            p.length[f][s] = length[f][s] * k;
+        }
+        p.base_yaw[f] = yaw[f] * DEG;
+        p.base_pitch[f] = pitch[f] * DEG;
+        p.base_roll[f] = roll[f] * DEG;
+    }
+    for (int c = 0; c < SKELETON_CHANNEL_COUNT; c++) {
+        p.zero[c] = 0;
+        p.scale[c] = scale[c] * DEG;
+    }
+    p.dip_coupling = 2.0f / 3.0f;
+    return p;
+}
+
+static bool profileError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+bool loadProfile(const std::string& path, Profile* out, std::string* error) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        return profileError(error, "cannot open " + path);
+    }
+
+    *out = defaultProfile();
+    char line[256];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char key[32];
+        int consumed = 0;
+        if (sscanf(line, "%31s%n", key, &consumed) != 1) {
+            continue;  // Blank line
+        }
+        const char* args = line + consumed;
+        int i;
+        float a, b, c, d;
+
+        if (strcmp(key, "hand_length") == 0 && sscanf(args, "%f", &a) == 1 && a > 0) {
+            *out = defaultProfile(a);
+        } else if (strcmp(key, "length") == 0 && sscanf(args, "%d %f %f %f %f", &i, &a, &b, &c, &d) == 5 &&
+                   i >= 0 && i < SKELETON_FINGER_COUNT) {
+            out->length[i][0] = a;
+            out->length[i][1] = b;
+            out->length[i][2] = c;
+            out->length[i][3] = d;
+        } else if (strcmp(key, "base") == 0 && sscanf(args, "%d %f %f %f", &i, &a, &b, &c) == 4 &&
+                   i >= 0 && i < SKELETON_FINGER_COUNT) {
+            out->base[i][0] = a;
+            out->base[i][1] = b;
+            out->base[i][2] = c;
+        } else if (strcmp(key, "base_angles") == 0 && sscanf(args, "%d %f %f %f", &i, &a, &b, &c) == 4 &&
+                   i >= 0 && i < SKELETON_FINGER_COUNT) {
+            out->base_yaw[i] = a * DEG;
+            out->base_pitch[i] = b * DEG;
+            out->base_roll[i] = c * DEG;
+        } else if (strcmp(key, "channel") == 0 && sscanf(args, "%d %f %f", &i, &a, &b) == 3 &&
+                   i >= 0 && i < SKELETON_CHANNEL_COUNT) {
+            out->zero[i] = a;
+            out->scale[i] = b * DEG;
+        } else if (strcmp(key, "dip_coupling") == 0 && sscanf(args, "%f", &a) == 1) {
+            out->dip_coupling = a;
+        } else {
+            ok = profileError(error, path + ":" + std::to_string(lineNumber) + ": bad line");
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+void PoseBatch::resize(size_t frames) {
+    if (frames > capacity_) {
+        capacity_ = frames;
+        data_.assign(SKELETON_JOINT_COUNT * 3 * capacity_, 0.0f);
+    }
+    size_ = frames;
+}
+
+// Scratch for one block of frames, every array indexed by frame
+struct Engine::Block {
+    float angle[SKELETON_CHANNEL_COUNT][SKELETON_BLOCK];
+    float quat[4][SKELETON_BLOCK];
+    float pos[SKELETON_JOINT_COUNT][3][SKELETON_BLOCK];
+    float sinYaw[SKELETON_BLOCK], cosYaw[SKELETON_BLOCK];
+    float pitch[SKELETON_BLOCK];
+    float local[3][SKELETON_BLOCK];
+};
+
+// sin and cos of any angle, branch free so the callers' loops vectorize.
+// Reduces to [-pi, pi], evaluates Taylor series at half the angle where they
+// converge fast, then doubles; absolute error below 1e-6.
+static inline void sinCos(float x, float* s, float* c) {
+    const float twoPi = 6.28318530717959f;
+    float k = (float)(int32_t)(x * (1.0f / twoPi) + (x >= 0 ? 0.5f : -0.5f));
+    float h = 0.5f * (x - k * twoPi);
+    float h2 = h * h;
+    float sh = h * (1.0f + h2 * (-1.0f / 6 + h2 * (1.0f / 120 + h2 * (-1.0f / 5040 + h2 * (1.0f / 362880 + h2 * (-1.0f / 39916800))))));
+    float ch = 1.0f + h2 * (-0.5f + h2 * (1.0f / 24 + h2 * (-1.0f / 720 + h2 * (1.0f / 40320 + h2 * (-1.0f / 3628800)))));
+    *s = 2.0f * sh * ch;
+    *c = 1.0f - 2.0f * sh * sh;
+}
+
+Engine::Engine(const Profile& profile) {
+    setProfile(profile);
+}
+
+void Engine::setProfile(const Profile& profile) {
+    profile_ = profile;
+    for (int f = 0; f < SKELETON_FINGER_COUNT; f++) {
+        // R = Ry(-yaw) * Rx(-pitch) * Rz(roll), so R * (0, 0, -1) points the
+        // chain along (yaw, pitch) the same way segment directions do
+        float sy = sinf(profile.base_yaw[f]), cy = cosf(profile.base_yaw[f]);
+        float sp = sinf(profile.base_pitch[f]), cp = cosf(profile.base_pitch[f]);
+        float sr = sinf(profile.base_roll[f]), cr = cosf(profile.base_roll[f]);
+        float ry[9] = {cy, 0, -sy, 0, 1, 0, sy, 0, cy};
+        float rx[9] = {1, 0, 0, 0, cp, sp, 0, -sp, cp};
+        float rz[9] = {cr, -sr, 0, sr, cr, 0, 0, 0, 1};
+        float yx[9];
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                yx[r * 3 + c] = ry[r * 3] * rx[c] + ry[r * 3 + 1] * rx[3 + c] + ry[r * 3 + 2] * rx[6 + c];
+            }
+        }
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                rotation_[f][r * 3 + c] = yx[r * 3] * rz[c] + yx[r * 3 + 1] * rz[3 + c] + yx[r * 3 + 2] * rz[6 + c];
+            }
+        }
+    }
+}
+
+void Engine::solveBlock(const dataset::Frame* frames, size_t n, Block& b) const {
+    const Profile& p = profile_;
+
+    // Transpose the frames into channel rows
+    for (size_t i = 0; i < n; i++) {
+        for (int c = 0; c < SKELETON_CHANNEL_COUNT; c++) {
+            b.angle[c][i] = frames[i].joints[c];
+        }
+        for (int c = 0; c < 4; c++) {
+            b.quat[c][i] = frames[i].quat[c];
+        }
+    }
+    for (int c = 0; c < SKELETON_CHANNEL_COUNT; c++) {
+        float zero = p.zero[c], scale = p.scale[c];
+        float* row = b.angle[c];
+        for (size_t i = 0; i < n; i++) {
+            row[i] = (row[i] - zero) * scale;
+        }
+    }
+
+    for (int f = 0; f < SKELETON_FINGER_COUNT; f++) {
+        // Each chain has three driven segments: yaw from the abduction channel,
+        // pitch accumulating gain[s] * flex[s] along the chain
+        const float* yaw;
+        const float* flex[3];
+        float gain[3] = {1.0f, 1.0f, 1.0f};
+        float segLength[3];
+        float rigid;  // Undriven metacarpal along -Z, none for the thumb
+        const float* len = p.length[f];
+        if (f == FINGER_THUMB) {
+            yaw = b.angle[THUMB_CMC_ABDUCTION];
+            flex[0] = b.angle[THUMB_CMC_FLEXION];
+            flex[1] = b.angle[THUMB_MCP_FLEXION];
+            flex[2] = b.angle[THUMB_IP_FLEXION];
+            segLength[0] = len[0];
+            segLength[1] = len[1];
+            segLength[2] = len[3];
+            rigid = 0.0f;
+        } else {
+            // Fingers have no distal sensor: the DIP follows the PIP
+            int first = FINGER_FIRST_CHANNEL + (f - 1) * 3;
+            yaw = b.angle[first];
+            flex[0] = b.angle[first + 1];
+            flex[1] = b.angle[first + 2];
+            flex[2] = b.angle[first + 2];
+            gain[2] = p.dip_coupling;
+            segLength[0] = len[1];
+            segLength[1] = len[2];
+            segLength[2] = len[3];
+            rigid = len[0];
+        }
+
+        // Chain positions in the chain's own frame, starting at the metacarpal joint
+        float* lx = b.local[0];
+        float* ly = b.local[1];
+        float* lz = b.local[2];
+        for (size_t i = 0; i < n; i++) {
+            lx[i] = 0;
+            ly[i] = 0;
+            lz[i] = -rigid;
+            b.pitch[i] = 0;
+            sinCos(yaw[i], &b.sinYaw[i], &b.cosYaw[i]);
+        }
+
+        const float* R = rotation_[f];
+        const float* base = p.base[f];
+        auto emit = [&](int j) {
+            float* x = b.pos[j][0];
+            float* y = b.pos[j][1];
+            float* z = b.pos[j][2];
+            for (size_t i = 0; i < n; i++) {
+                x[i] = R[0] * lx[i] + R[1] * ly[i] + R[2] * lz[i] + base[0];
+                y[i] = R[3] * lx[i] + R[4] * ly[i] + R[5] * lz[i] + base[1];
+                z[i] = R[6] * lx[i] + R[7] * ly[i] + R[8] * lz[i] + base[2];
+            }
+        };
+
+        int joint = chainJoint[f];
+        if (rigid != 0.0f) {
+            // Metacarpal joint sits at the base
+            float* x = b.pos[joint][0];
+            float* y = b.pos[joint][1];
+            float* z = b.pos[joint][2];
+            for (size_t i = 0; i < n; i++) {
+                x[i] = base[0];
+                y[i] = base[1];
+                z[i] = base[2];
+            }
+            joint++;
+        }
+        emit(joint);
+
+        for (int s = 0; s < 3; s++) {
+            const float* add = flex[s];
+            float k = gain[s];
+            float l = segLength[s];
+            for (size_t i = 0; i < n; i++) {
+                b.pitch[i] += k * add[i];
+                float sp, cp;
+                sinCos(b.pitch[i], &sp, &cp);
+                lx[i] += l * b.sinYaw[i] * cp;
+                ly[i] -= l * sp;
+                lz[i] -= l * b.cosYaw[i] * cp;
+            }
+            emit(joint + 1 + s);
+        }
+    }
+
+    // Wrist at the origin; palm halfway along the middle metacarpal
+    for (int c = 0; c < 3; c++) {
+        const float* a = b.pos[JOINT_MIDDLE_METACARPAL][c];
+        const float* m = b.pos[JOINT_MIDDLE_PROXIMAL][c];
+        float* palm = b.pos[JOINT_PALM][c];
+        float* wrist = b.pos[JOINT_WRIST][c];
+        for (size_t i = 0; i < n; i++) {
+            palm[i] = 0.5f * (a[i] + m[i]);
+            wrist[i] = 0;
+        }
+    }
+
+    // Rotate the hand by the IMU orientation: v' = v + 2w(q x v) + 2 q x (q x v)
+    const float* qx = b.quat[0];
+    const float* qy = b.quat[1];
+    const float* qz = b.quat[2];
+    const float* qw = b.quat[3];
+    for (int j = JOINT_THUMB_METACARPAL; j < SKELETON_JOINT_COUNT; j++) {
+        float* x = b.pos[j][0];
+        float* y = b.pos[j][1];
+        float* z = b.pos[j][2];
+        for (size_t i = 0; i < n; i++) {
+            float tx = 2.0f * (qy[i] * z[i] - qz[i] * y[i]);
+            float ty = 2.0f * (qz[i] * x[i] - qx[i] * z[i]);
+            float tz = 2.0f * (qx[i] * y[i] - qy[i] * x[i]);
+            float vx = x[i] + qw[i] * tx + (qy[i] * tz - qz[i] * ty);
+            float vy = y[i] + qw[i] * ty + (qz[i] * tx - qx[i] * tz);
+            float vz = z[i] + qw[i] * tz + (qx[i] * ty - qy[i] * tx);
+            x[i] = vx;
+            y[i] = vy;
+            z[i] = vz;
+        }
+    }
+}
+
+void Engine::storeBlock(const Block& b, size_t n, PoseBatch& out, size_t first) const {
+    for (int j = 0; j < SKELETON_JOINT_COUNT; j++) {
+        for (int c = 0; c < 3; c++) {
+            memcpy(out.component(j, c) + first, b.pos[j][c], n * sizeof(float));
+        }
+    }
+}
+
+void Engine::solve(const dataset::Frame* frames, size_t count, PoseBatch& out) {
+    out.resize(count);
+    std::unique_ptr<Block> block(new Block);
+    for (size_t first = 0; first < count; first += SKELETON_BLOCK) {
+        size_t n = count - first < SKELETON_BLOCK ? count - first : SKELETON_BLOCK;
+        solveBlock(frames + first, n, *block);
+        storeBlock(*block, n, out, first);
+    }
+}
+
+void Engine::solveParallel(const dataset::Frame* frames, size_t count, PoseBatch& out, unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    size_t blocks = (count + SKELETON_BLOCK - 1) / SKELETON_BLOCK;
+    if (threads <= 1 || blocks < 2) {
+        solve(frames, count, out);
+        return;
+    }
+    if (threads > blocks) {
+        threads = blocks;
+    }
+
+    out.resize(count);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        // Whole blocks per thread so no two threads write the same cache line run
+        size_t first = blocks * t / threads * SKELETON_BLOCK;
+        size_t last = blocks * (t + 1) / threads * SKELETON_BLOCK;
+        if (last > count) last = count;
+        workers.emplace_back([this, frames, first, last, &out]() {
+            std::unique_ptr<Block> block(new Block);
+            for (size_t i = first; i < last; i += SKELETON_BLOCK) {
+                size_t n = last - i < SKELETON_BLOCK ? last - i : SKELETON_BLOCK;
+                solveBlock(frames + i, n, *block);
+                storeBlock(*block, n, out, i);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void Engine::solveOne(const dataset::Frame& frame, float positions[SKELETON_JOINT_COUNT][3]) {
+    thread_local std::unique_ptr<Block> block(new Block);
+    solveBlock(&frame, 1, *block);
+    for (int j = 0; j < SKELETON_JOINT_COUNT; j++) {
+        for (int c = 0; c < 3; c++) {
+            positions[j][c] = block->pos[j][c][0];
+        }
+    }
+}
+
+}  // namespace skeleton
@@ -0,0 +1,178 @@
+#ifndef HAND_SKELETON_H
+#define HAND_SKELETON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "GloveDataset.h"
+
+// Forward kinematics from glove frames to a 26-joint hand skeleton laid out
+// like OpenXR's XR_EXT_hand_tracking joint set.
+//
+// Hand frame (right hand): origin at the wrist joint, -Z towards the
+// fingertips, +Y out of the back of the hand, +X towards the thumb. The
+// whole hand is then rotated by the frame's IMU quaternion, so positions are
+// in the IMU's world frame, in metres, relative to the wrist.
+//
+// Frames are processed in blocks of SKELETON_BLOCK laid out as structure of
+// arrays: every inner loop runs over frames with no branches and no libm
+// calls, so the compiler vectorizes it (build with -O2 or higher; -O3
+// -march=native for the widest SIMD).
+
+#define SKELETON_JOINT_COUNT 26
+#define SKELETON_FINGER_COUNT 5
+#define SKELETON_CHANNEL_COUNT 16
+#define SKELETON_BLOCK 64
+
+namespace skeleton {
+
+enum Joint {
+    JOINT_PALM = 0,
+    JOINT_WRIST,
+    JOINT_THUMB_METACARPAL,
+    JOINT_THUMB_PROXIMAL,
+    JOINT_THUMB_DISTAL,
+    JOINT_THUMB_TIP,
+    JOINT_INDEX_METACARPAL,
+    JOINT_INDEX_PROXIMAL,
+    JOINT_INDEX_INTERMEDIATE,
+    JOINT_INDEX_DISTAL,
+    JOINT_INDEX_TIP,
+    JOINT_MIDDLE_METACARPAL,
+    JOINT_MIDDLE_PROXIMAL,
+    JOINT_MIDDLE_INTERMEDIATE,
+    JOINT_MIDDLE_DISTAL,
+    JOINT_MIDDLE_TIP,
+    JOINT_RING_METACARPAL,
+    JOINT_RING_PROXIMAL,
+    JOINT_RING_INTERMEDIATE,
+    JOINT_RING_DISTAL,
+    JOINT_RING_TIP,
+    JOINT_LITTLE_METACARPAL,
+    JOINT_LITTLE_PROXIMAL,
+    JOINT_LITTLE_INTERMEDIATE,
+    JOINT_LITTLE_DISTAL,
+    JOINT_LITTLE_TIP,
+};
+
+enum Finger {
+    FINGER_THUMB = 0,
+    FINGER_INDEX,
+    FINGER_MIDDLE,
+    FINGER_RING,
+    FINGER_LITTLE,
+};
+
+/**
+ * One user's hand. Lengths are in metres, angles in radians.
+ */
+struct Profile {
+    // Metacarpal joint position in the hand frame
+    float base[SKELETON_FINGER_COUNT][3];
+
+    // Fixed orientation of each finger's chain at its metacarpal joint: yaw
+    // turns the chain towards +X, pitch towards the palm (-Y), roll turns it
+    // about its own axis. Fingers are nearly flat; the thumb is rolled and
+    // yawed out of the palm. Within a chain abduction acts like yaw and
+    // flexion like pitch.
+    float base_yaw[SKELETON_FINGER_COUNT];
+    float base_pitch[SKELETON_FINGER_COUNT];
+    float base_roll[SKELETON_FINGER_COUNT];
+
+    // Metacarpal, proximal, intermediate, distal. The thumb has no
+    // intermediate phalanx, its entry is ignored.
+    float length[SKELETON_FINGER_COUNT][4];
+
+    // angle = (channel value - zero) * scale, per glove channel (the order of
+    // angles[] on the glove)
+    float zero[SKELETON_CHANNEL_COUNT];
+    float scale[SKELETON_CHANNEL_COUNT];
+
+    // Distal flexion of the four fingers, as a fraction of the PIP flexion
+    float dip_coupling;
+};
+
+/**
+ * Average adult right hand, scaled so the middle finger from wrist to tip
+ * measures hand_length metres.
+ */
+Profile defaultProfile(float hand_length = 0.19f);
+
+/**
+ * Reads a profile from a text file. Each line is a key and its values;
+ * missing keys keep their values from defaultProfile(), '#' starts a comment.
+ *   hand_length <m>                           rescale the default first
+ *   length <finger 0-4> <meta> <prox> <inter> <dist>
+ *   base <finger> <x> <y> <z>
+ *   base_angles <finger> <yaw> <pitch> <roll> degrees
+ *   channel <0-15> <zero> <degrees per count>
+ *   dip_coupling <fraction>
+ * @return false on an unreadable file or malformed line; see error
+ */
+bool loadProfile(const std::string& path, Profile* out, std::string* error = nullptr);
+
+/**
+ * Joint positions for a batch of frames, structure of arrays: component c of
+ * joint j for frame i is at data[(j * 3 + c) * capacity + i].
+ */
+class PoseBatch {
+public:
+    void resize(size_t frames);
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    float* component(int joint, int axis) { return &data_[(joint * 3 + axis) * capacity_]; }
+    const float* component(int joint, int axis) const { return &data_[(joint * 3 + axis) * capacity_]; }
+
+    void position(int joint, size_t frame, float out[3]) const {
+        for (int c = 0; c < 3; c++) {
+            out[c] = component(joint, c)[frame];
+        }
+    }
+
+private:
+    std::vector<float> data_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+/**
+ * Computes skeletons for one profile. Solving does not modify the engine, so
+ * one engine can serve several threads as long as the profile is not changed.
+ */
+class Engine {
+public:
+    explicit Engine(const Profile& profile = defaultProfile());
+
+    void setProfile(const Profile& profile);
+    const Profile& profile() const { return profile_; }
+
+    /**
+     * Skeleton for frames[0..count); out is resized to count.
+     */
+    void solve(const dataset::Frame* frames, size_t count, PoseBatch& out);
+
+    /**
+     * Same, split over threads (0 = hardware concurrency) for offline datasets.
+     */
+    void solveParallel(const dataset::Frame* frames, size_t count, PoseBatch& out, unsigned threads = 0);
+
+    /**
+     * Skeleton for one live frame, positions[joint][axis].
+     */
+    void solveOne(const dataset::Frame& frame, float positions[SKELETON_JOINT_COUNT][3]);
+
+private:
+    struct Block;
+    void solveBlock(const dataset::Frame* frames, size_t n, Block& block) const;
+    void storeBlock(const Block& block, size_t n, PoseBatch& out, size_t first) const;
+
+    Profile profile_;
+    float rotation_[SKELETON_FINGER_COUNT][9];  // Chain base rotations, row major
+};
+
+}  // namespace skeleton
+
+#endif
@@ -0,0 +1,384 @@
+#include "Retarget.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+
+namespace retarget {
+
+static const float DEG = 3.14159265358979f / 180.0f;
+
+static const char* const fingerNames[SKELETON_FINGER_COUNT] = {"thumb", "index", "middle", "ring", "little"};
+
+static const int tipJoint[SKELETON_FINGER_COUNT] = {
+    skeleton::JOINT_THUMB_TIP, skeleton::JOINT_INDEX_TIP, skeleton::JOINT_MIDDLE_TIP,
+    skeleton::JOINT_RING_TIP, skeleton::JOINT_LITTLE_TIP,
+};
+
+size_t RobotHand::dof() const {
+    size_t n = 0;
+    for (const ChainDesc& chain : chains) {
+        n += chain.joints.size();
+    }
+    return n;
+}
+
+static bool parseError(std::string* error, int line, const std::string& message) {
+    if (error) *error = "line " + std::to_string(line) + ": " + message;
+    return false;
+}
+
+bool parseRobotHand(const std::string& text, RobotHand* out, std::string* error) {
+    *out = RobotHand();
+    std::istringstream lines(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) {
+            continue;  // Blank line
+        }
+
+        if (key == "hand") {
+            in >> out->name;
+        } else if (key == "scale") {
+            if (!(in >> out->scale) || out->scale <= 0) return parseError(error, lineNumber, "bad scale");
+        } else if (key == "chain") {
+            ChainDesc chain;
+            std::string finger;
+            if (!(in >> chain.name >> finger)) return parseError(error, lineNumber, "chain needs a name and a finger");
+            chain.human_finger = -1;
+            for (int f = 0; f < SKELETON_FINGER_COUNT; f++) {
+                if (finger == fingerNames[f]) chain.human_finger = f;
+            }
+            if (chain.human_finger < 0) return parseError(error, lineNumber, "unknown finger " + finger);
+            if (!(in >> chain.weight)) chain.weight = 1.0f;
+            memset(chain.tip, 0, sizeof(chain.tip));
+            out->chains.push_back(chain);
+        } else if (key == "joint") {
+            if (out->chains.empty()) return parseError(error, lineNumber, "joint before any chain");
+            ChainDesc& chain = out->chains.back();
+            if (chain.joints.size() >= RETARGET_MAX_CHAIN_JOINTS) return parseError(error, lineNumber, "too many joints in chain");
+            JointDesc joint;
+            if (!(in >> joint.name >> joint.offset[0] >> joint.offset[1] >> joint.offset[2] >>
+                  joint.axis[0] >> joint.axis[1] >> joint.axis[2] >> joint.min >> joint.max)) {
+                return parseError(error, lineNumber, "joint needs name, offset, axis and limits");
+            }
+            float norm = sqrtf(joint.axis[0] * joint.axis[0] + joint.axis[1] * joint.axis[1] + joint.axis[2] * joint.axis[2]);
+            if (norm < 1e-6f || joint.min > joint.max) return parseError(error, lineNumber, "bad axis or limits");
+            for (int c = 0; c < 3; c++) joint.axis[c] /= norm;
+            if (!(in >> joint.rest)) joint.rest = 0.5f * (joint.min + joint.max);
+            if (joint.rest < joint.min || joint.rest > joint.max) return parseError(error, lineNumber, "rest outside the limits");
+            joint.min *= DEG;
+            joint.max *= DEG;
+            joint.rest *= DEG;
+            chain.joints.push_back(joint);
+        } else if (key == "tip") {
+            if (out->chains.empty()) return parseError(error, lineNumber, "tip before any chain");
+            float* tip = out->chains.back().tip;
+            if (!(in >> tip[0] >> tip[1] >> tip[2])) return parseError(error, lineNumber, "tip needs an offset");
+        } else {
+            return parseError(error, lineNumber, "unknown key " + key);
+        }
+    }
+    for (const ChainDesc& chain : out->chains) {
+        if (chain.joints.empty()) return parseError(error, lineNumber, "chain " + chain.name + " has no joints");
+    }
+    return true;
+}
+
+bool loadRobotHand(const std::string& path, RobotHand* out, std::string* error) {
+    std::ifstream file(path);
+    if (!file) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    if (!parseRobotHand(text.str(), out, error)) {
+        if (error) *error = path + ": " + *error;
+        return false;
+    }
+    return true;
+}
+
+bool Retargeter::setHand(const RobotHand& hand, std::string* error) {
+    if (hand.chains.empty()) {
+        if (error) *error = "robot hand has no chains";
+        return false;
+    }
+    hand_ = hand;
+    chains_.clear();
+    size_t first = 0;
+    for (const ChainDesc& desc : hand_.chains) {
+        Chain chain = {};
+        chain.first = first;
+        chain.count = desc.joints.size();
+        chains_.push_back(chain);
+        first += chain.count;
+    }
+    q_.assign(first, 0.0f);
+    reset();
+    return true;
+}
+
+void Retargeter::reset() {
+    for (size_t c = 0; c < chains_.size(); c++) {
+        const ChainDesc& desc = hand_.chains[c];
+        for (size_t j = 0; j < chains_[c].count; j++) {
+            // Straight where the limits allow it
+            const JointDesc& joint = desc.joints[j];
+            q_[chains_[c].first + j] = joint.min > 0 ? joint.min : (joint.max < 0 ? joint.max : 0.0f);
+        }
+        chains_[c].jacobianValid = false;
+    }
+    stats_ = SolverStats();
+}
+
+// Forward kinematics of one chain. Fills the Jacobian of the tip position
+// when jacobian is not null.
+void Retargeter::forward(const ChainDesc& desc, const float* q, float tip[3],
+                         float jacobian[3][RETARGET_MAX_CHAIN_JOINTS]) const {
+    float R[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    float p[3] = {0, 0, 0};
+    float jointPos[RETARGET_MAX_CHAIN_JOINTS][3];
+    float jointAxis[RETARGET_MAX_CHAIN_JOINTS][3];
+    size_t n = desc.joints.size();
+
+    for (size_t k = 0; k < n; k++) {
+        const JointDesc& joint = desc.joints[k];
+        const float* o = joint.offset;
+        const float* a = joint.axis;
+        for (int r = 0; r < 3; r++) {
+            p[r] += R[r * 3] * o[0] + R[r * 3 + 1] * o[1] + R[r * 3 + 2] * o[2];
+        }
+        for (int r = 0; r < 3; r++) {
+            jointPos[k][r] = p[r];
+            jointAxis[k][r] = R[r * 3] * a[0] + R[r * 3 + 1] * a[1] + R[r * 3 + 2] * a[2];
+        }
+
+        // R = R * rot(axis, q) by Rodrigues
+        float s = sinf(q[k]), c = cosf(q[k]), t = 1.0f - c;
+        float rot[9] = {
+            t * a[0] * a[0] + c,        t * a[0] * a[1] - s * a[2], t * a[0] * a[2] + s * a[1],
+            t * a[0] * a[1] + s * a[2], t * a[1] * a[1] + c,        t * a[1] * a[2] - s * a[0],
+            t * a[0] * a[2] - s * a[1], t * a[1] * a[2] + s * a[0], t * a[2] * a[2] + c,
+        };
+        float next[9];
+        for (int r = 0; r < 3; r++) {
+            for (int col = 0; col < 3; col++) {
+                next[r * 3 + col] = R[r * 3] * rot[col] + R[r * 3 + 1] * rot[3 + col] + R[r * 3 + 2] * rot[6 + col];
+            }
+        }
+        memcpy(R, next, sizeof(R));
+    }
+    for (int r = 0; r < 3; r++) {
+        tip[r] = p[r] + R[r * 3] * desc.tip[0] + R[r * 3 + 1] * desc.tip[1] + R[r * 3 + 2] * desc.tip[2];
+    }
+
+    if (jacobian != nullptr) {
+        // Column k: axis_k x (tip - joint_k)
+        for (size_t k = 0; k < n; k++) {
+            const float* a = jointAxis[k];
+            float d[3] = {tip[0] - jointPos[k][0], tip[1] - jointPos[k][1], tip[2] - jointPos[k][2]};
+            jacobian[0][k] = a[1] * d[2] - a[2] * d[1];
+            jacobian[1][k] = a[2] * d[0] - a[0] * d[2];
+            jacobian[2][k] = a[0] * d[1] - a[1] * d[0];
+        }
+    }
+}
+
+// Solves A x = b in place for a small symmetric positive definite A (n x n,
+// row stride RETARGET_MAX_CHAIN_JOINTS). Returns false if A is not positive definite.
+static bool choleskySolve(float A[RETARGET_MAX_CHAIN_JOINTS][RETARGET_MAX_CHAIN_JOINTS], float* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            float sum = A[i][j];
+            for (size_t k = 0; k < j; k++) {
+                sum -= A[i][k] * A[j][k];
+            }
+            if (i == j) {
+                if (sum <= 0) return false;
+                A[i][i] = sqrtf(sum);
+            } else {
+                A[i][j] = sum / A[j][j];
+            }
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        float sum = b[i];
+        for (size_t k = 0; k < i; k++) sum -= A[i][k] * b[k];
+        b[i] = sum / A[i][i];
+    }
+    for (size_t i = n; i-- > 0;) {
+        float sum = b[i];
+        for (size_t k = i + 1; k < n; k++) sum -= A[k][i] * b[k];
+        b[i] = sum / A[i][i];
+    }
+    return true;
+}
+
+float Retargeter::solveChain(size_t c, const float target[3]) {
+    const ChainDesc& desc = hand_.chains[c];
+    Chain& chain = chains_[c];
+    float* q = &q_[chain.first];
+    size_t n = chain.count;
+    float (*J)[RETARGET_MAX_CHAIN_JOINTS] = chain.jacobian;
+
+    float previous[RETARGET_MAX_CHAIN_JOINTS];
+    memcpy(previous, q, n * sizeof(float));
+    float weight = desc.weight > 0 ? desc.weight : 1.0f;
+    float smoothing = config_.smoothing / weight;
+    float posture = config_.posture / weight;
+
+    // Warm start: last frame's joints, and its Jacobian if we still have one
+    float tip[3];
+    if (chain.jacobianValid) {
+        forward(desc, q, tip, nullptr);
+    } else {
+        forward(desc, q, tip, J);
+        stats_.jacobians++;
+        chain.jacobianValid = true;
+        chain.sinceRefresh = 0;
+    }
+    stats_.forward++;
+
+    float err[3] = {target[0] - tip[0], target[1] - tip[1], target[2] - tip[2]};
+    float e2 = err[0] * err[0] + err[1] * err[1] + err[2] * err[2];
+    float lambda = config_.damping;
+    float tolerance2 = config_.tolerance * config_.tolerance;
+
+    for (int it = 0; it < config_.max_iterations && e2 > tolerance2; it++) {
+        stats_.iterations++;
+
+        // (J^T J + (lambda + smoothing + posture) I) step
+        //     = J^T err + smoothing (previous - q) + posture (rest - q),
+        // over the joints not pinned at a limit. A joint whose step would push
+        // it further into the limit it sits on is pinned and the step re-solved,
+        // so the others can still make progress.
+        bool pinned[RETARGET_MAX_CHAIN_JOINTS] = {false};
+        float step[RETARGET_MAX_CHAIN_JOINTS];
+        bool solved = false;
+        for (size_t attempt = 0; attempt <= n && !solved; attempt++) {
+            float A[RETARGET_MAX_CHAIN_JOINTS][RETARGET_MAX_CHAIN_JOINTS];
+            for (size_t i = 0; i < n; i++) {
+                for (size_t j = 0; j <= i; j++) {
+                    A[i][j] = (pinned[i] || pinned[j]) ? 0.0f
+                            : J[0][i] * J[0][j] + J[1][i] * J[1][j] + J[2][i] * J[2][j];
+                }
+                A[i][i] = pinned[i] ? 1.0f : A[i][i] + lambda + smoothing + posture;
+                step[i] = pinned[i] ? 0.0f
+                        : J[0][i] * err[0] + J[1][i] * err[1] + J[2][i] * err[2] +
+                          smoothing * (previous[i] - q[i]) + posture * (desc.joints[i].rest - q[i]);
+            }
+            if (!choleskySolve(A, step, n)) {
+                break;
+            }
+            solved = true;
+            for (size_t i = 0; i < n; i++) {
+                const JointDesc& joint = desc.joints[i];
+                if (!pinned[i] && ((q[i] <= joint.min && step[i] < 0) || (q[i] >= joint.max && step[i] > 0))) {
+                    pinned[i] = true;
+                    solved = false;
+                }
+            }
+        }
+        if (!solved) {
+            lambda *= 10;
+            continue;
+        }
+
+        float trial[RETARGET_MAX_CHAIN_JOINTS];
+        float stepNorm2 = 0;
+        for (size_t i = 0; i < n; i++) {
+            const JointDesc& joint = desc.joints[i];
+            float v = q[i] + step[i];
+            trial[i] = v < joint.min ? joint.min : (v > joint.max ? joint.max : v);
+            step[i] = trial[i] - q[i];
+            stepNorm2 += step[i] * step[i];
+        }
+        if (stepNorm2 < 1e-14f) {
+            break;  // Pinned against the limits
+        }
+
+        float trialTip[3];
+        forward(desc, trial, trialTip, nullptr);
+        stats_.forward++;
+        float trialErr[3] = {target[0] - trialTip[0], target[1] - trialTip[1], target[2] - trialTip[2]};
+        float trialE2 = trialErr[0] * trialErr[0] + trialErr[1] * trialErr[1] + trialErr[2] * trialErr[2];
+
+        if (trialE2 < e2) {
+            // Unreachable targets converge to the closest pose; don't spend
+            // the remaining iterations polishing it
+            bool stalled = trialE2 > e2 * (1.0f - config_.min_progress);
+
+            // Broyden update: make J reproduce the tip motion this step produced
+            for (int r = 0; r < 3; r++) {
+                float predicted = 0;
+                for (size_t i = 0; i < n; i++) predicted += J[r][i] * step[i];
+                float correction = (trialTip[r] - tip[r] - predicted) / stepNorm2;
+                for (size_t i = 0; i < n; i++) J[r][i] += correction * step[i];
+            }
+            memcpy(q, trial, n * sizeof(float));
+            memcpy(tip, trialTip, sizeof(tip));
+            memcpy(err, trialErr, sizeof(err));
+            e2 = trialE2;
+            lambda = lambda * 0.5f > config_.damping ? lambda * 0.5f : config_.damping;
+
+            if (++chain.sinceRefresh >= config_.jacobian_refresh) {
+                forward(desc, q, tip, J);
+                stats_.jacobians++;
+                stats_.forward++;
+                chain.sinceRefresh = 0;
+            }
+            if (stalled) {
+                break;
+            }
+        } else if (chain.sinceRefresh > 0) {
+            // The approximate Jacobian misled us: retry from an exact one
+            forward(desc, q, tip, J);
+            stats_.jacobians++;
+            stats_.forward++;
+            chain.sinceRefresh = 0;
+        } else {
+            lambda *= 10;
+        }
+    }
+    return e2;
+}
+
+const float* Retargeter::solve(const float tips[SKELETON_FINGER_COUNT][3]) {
+    float weighted = 0;
+    float weights = 0;
+    for (size_t c = 0; c < chains_.size(); c++) {
+        const ChainDesc& desc = hand_.chains[c];
+        const float* human = tips[desc.human_finger];
+        float target[3] = {human[0] * hand_.scale, human[1] * hand_.scale, human[2] * hand_.scale};
+        weighted += desc.weight * solveChain(c, target);
+        weights += desc.weight;
+    }
+    stats_.frames++;
+    stats_.residual = weights > 0 ? sqrtf(weighted / weights) : 0;
+    return q_.data();
+}
+
+const float* Retargeter::solvePose(const float positions[SKELETON_JOINT_COUNT][3]) {
+    float tips[SKELETON_FINGER_COUNT][3];
+    for (int f = 0; f < SKELETON_FINGER_COUNT; f++) {
+        memcpy(tips[f], positions[tipJoint[f]], sizeof(tips[f]));
+    }
+    return solve(tips);
+}
+
+void Retargeter::tip(size_t c, float out[3]) const {
+    forward(hand_.chains[c], &q_[chains_[c].first], out, nullptr);
+}
+
+}  // namespace retarget
@@ -0,0 +1,153 @@
+#ifndef RETARGET_H
+#define RETARGET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "HandSkeleton.h"
+
+// Glove to robot hand retargeting by fingertip matching.
+//
+// A robot hand is a set of serial chains of revolute joints, one per robot
+// finger, each paired with a human finger. Every frame the solver moves each
+// chain so its tip reaches the paired human fingertip (taken from the
+// HandSkeleton pose, scaled into the robot's size) with damped least squares:
+//
+//   minimise |target - tip(q)|^2 + smoothing |q - q_previous|^2
+//            + posture |q - q_rest|^2
+//
+// The posture term is small; it only decides between poses that reach the tip
+// equally well (robot fingers usually have more joints than a tip has
+// coordinates) and keeps the solution away from hyperextended branches.
+// q_rest is each joint's rest angle, by default the middle of its limits.
+//
+// Chains are solved independently. Each solve starts from the previous
+// frame's joints and reuses that frame's Jacobian, refreshing it with rank-one
+// (Broyden) updates and only recomputing it exactly every few steps or when a
+// step fails, so a typical frame costs one or two forward passes per chain.
+//
+// Robot frame: same axes as the HandSkeleton hand frame (-Z along the fingers,
+// +Y out of the back of the hand, +X towards the thumb), origin at the wrist.
+
+#define RETARGET_MAX_CHAIN_JOINTS 6
+
+namespace retarget {
+
+struct JointDesc {
+    std::string name;
+    float offset[3];        // From the previous joint (or the chain base), in its frame
+    float axis[3];          // Rotation axis in this joint's frame, unit length
+    float min, max;         // Limits, radians
+    float rest;             // Preferred angle, radians
+};
+
+struct ChainDesc {
+    std::string name;
+    int human_finger;       // skeleton::Finger whose tip this chain follows
+    float weight;           // Relative importance of this tip
+    std::vector<JointDesc> joints;
+    float tip[3];           // Tip offset from the last joint, in its frame
+};
+
+struct RobotHand {
+    std::string name;
+    float scale = 1.0f;     // Robot size over human size
+    std::vector<ChainDesc> chains;
+
+    size_t dof() const;
+};
+
+/**
+ * Parses a robot hand description:
+ *   hand <name>
+ *   scale <robot/human>
+ *   chain <name> <thumb|index|middle|ring|little> [weight]
+ *   joint <name> <ox> <oy> <oz> <ax> <ay> <az> <min deg> <max deg> [rest deg]
+ *   tip <ox> <oy> <oz>
+ * joint and tip lines belong to the preceding chain. Lengths in metres,
+ * '#' starts a comment.
+ * @return false on a malformed description; see error
+ */
+bool parseRobotHand(const std::string& text, RobotHand* out, std::string* error = nullptr);
+bool loadRobotHand(const std::string& path, RobotHand* out, std::string* error = nullptr);
+
+struct SolverConfig {
+    int max_iterations = 10;        // Per chain per frame
+    float tolerance = 0.5e-3f;      // Stop when the tip is this close, metres
+    float damping = 1e-4f;          // Levenberg-Marquardt lambda, m^2
+    float smoothing = 1e-5f;        // Pull towards the previous frame, m^2 per rad^2
+    float posture = 1e-6f;          // Pull towards the rest angles, m^2 per rad^2
+    int jacobian_refresh = 4;       // Broyden steps before an exact Jacobian
+    float min_progress = 0.02f;     // Stop once a step shrinks the squared error by less than this fraction
+};
+
+struct SolverStats {
+    uint64_t frames = 0;
+    uint64_t iterations = 0;        // Summed over chains
+    uint64_t jacobians = 0;         // Exact Jacobian evaluations
+    uint64_t forward = 0;           // Forward kinematics passes
+    float residual = 0;             // Weighted RMS tip error of the last frame, metres
+};
+
+/**
+ * Solves one robot hand frame by frame. Not thread safe; use one per hand.
+ */
+class Retargeter {
+public:
+    Retargeter() {}
+
+    bool setHand(const RobotHand& hand, std::string* error = nullptr);
+    const RobotHand& hand() const { return hand_; }
+
+    void setConfig(const SolverConfig& config) { config_ = config; }
+    const SolverConfig& config() const { return config_; }
+
+    /**
+     * Forgets the previous solution; the next solve starts from straight joints.
+     */
+    void reset();
+
+    /**
+     * Solves for one frame of human fingertips in the hand frame, metres.
+     * @return dof() joint angles, chain by chain, valid until the next call
+     */
+    const float* solve(const float tips[SKELETON_FINGER_COUNT][3]);
+
+    /**
+     * Same, from a skeleton pose solved with an identity IMU quaternion.
+     */
+    const float* solvePose(const float positions[SKELETON_JOINT_COUNT][3]);
+
+    /**
+     * Robot tip position of chain c for the current joints.
+     */
+    void tip(size_t c, float out[3]) const;
+
+    const float* joints() const { return q_.data(); }
+    size_t dof() const { return q_.size(); }
+    const SolverStats& stats() const { return stats_; }
+
+private:
+    struct Chain {
+        size_t first;           // Index of the chain's first joint in q_
+        size_t count;
+        float jacobian[3][RETARGET_MAX_CHAIN_JOINTS];
+        bool jacobianValid;
+        int sinceRefresh;
+    };
+
+    void forward(const ChainDesc& desc, const float* q, float tip[3], float jacobian[3][RETARGET_MAX_CHAIN_JOINTS]) const;
+    float solveChain(size_t c, const float target[3]);
+
+    RobotHand hand_;
+    SolverConfig config_;
+    std::vector<Chain> chains_;
+    std::vector<float> q_;
+    SolverStats stats_;
+};
+
+}  // namespace retarget
+
+#endif
@@ -0,0 +1,449 @@
+#include "WebSocket.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/sockios.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace ws {
+
+static const size_t MAX_REQUEST_BYTES = 8192;   // Handshake request
+static const size_t MAX_INPUT_BYTES = 4096;     // Largest client frame we accept
+static const int SEND_BUFFER_BYTES = 4096;      // Kernel send buffer per client
+static const int BUSY_POLL_MS = 5;              // Recheck interval for busy clients
+
+enum Opcode {
+    OP_CONTINUATION = 0x0,
+    OP_TEXT = 0x1,
+    OP_BINARY = 0x2,
+    OP_CLOSE = 0x8,
+    OP_PING = 0x9,
+    OP_PONG = 0xA,
+};
+
+// ---------------------------------------------------------------------------
+// Handshake helpers
+
+static uint32_t rotl(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1(const uint8_t* data, size_t len, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    // Message, 0x80, zeros, then the bit length, padded to whole blocks
+    std::vector<uint8_t> msg(data, data + len);
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56) msg.push_back(0);
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 7; i >= 0; i--) msg.push_back((uint8_t)(bits >> (i * 8)));
+
+    for (size_t block = 0; block < msg.size(); block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* p = &msg[block + i * 4];
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rotl(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4 + 0] = (uint8_t)(h[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)h[i];
+    }
+}
+
+static std::string base64(const uint8_t* data, size_t len) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t n = (uint32_t)data[i] << 16;
+        if (i + 1 < len) n |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) n |= data[i + 2];
+        out += alphabet[(n >> 18) & 63];
+        out += alphabet[(n >> 12) & 63];
+        out += i + 1 < len ? alphabet[(n >> 6) & 63] : '=';
+        out += i + 2 < len ? alphabet[n & 63] : '=';
+    }
+    return out;
+}
+
+std::string acceptKey(const std::string& key) {
+    std::string text = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[20];
+    sha1(reinterpret_cast<const uint8_t*>(text.data()), text.size(), digest);
+    return base64(digest, sizeof(digest));
+}
+
+static std::string lower(std::string s) {
+    for (char& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    size_t end = s.find_last_not_of(" \t\r");
+    return begin == std::string::npos ? std::string() : s.substr(begin, end - begin + 1);
+}
+
+// Server to client frame: FIN set, never masked
+static void frame(uint8_t opcode, const uint8_t* payload, size_t len, std::vector<uint8_t>& out) {
+    out.clear();
+    out.push_back(0x80 | opcode);
+    if (len < 126) {
+        out.push_back((uint8_t)len);
+    } else if (len <= 0xFFFF) {
+        out.push_back(126);
+        out.push_back((uint8_t)(len >> 8));
+        out.push_back((uint8_t)len);
+    } else {
+        out.push_back(127);
+        for (int i = 7; i >= 0; i--) out.push_back((uint8_t)((uint64_t)len >> (i * 8)));
+    }
+    out.insert(out.end(), payload, payload + len);
+}
+
+// ---------------------------------------------------------------------------
+// Server
+
+Server::~Server() {
+    close();
+}
+
+bool Server::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool Server::listen(uint16_t port, bool loopback_only) {
+    if (listenFd_ >= 0) return fail("server already listening");
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return fail(std::string("socket: ") + strerror(errno));
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 16) < 0) {
+        std::string message = "cannot listen on port " + std::to_string(port) + ": " + strerror(errno);
+        ::close(fd);
+        return fail(message);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    listenFd_ = fd;
+    return true;
+}
+
+void Server::close() {
+    for (Client& client : clients_) {
+        if (client.fd >= 0) ::close(client.fd);
+    }
+    clients_.clear();
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+    }
+}
+
+size_t Server::clientCount() const {
+    size_t count = 0;
+    for (const Client& client : clients_) {
+        if (client.state == OPEN) count++;
+    }
+    return count;
+}
+
+void Server::accept() {
+    for (;;) {
+        int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) return;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        // A small kernel buffer keeps what a slow client has queued short, so
+        // backpressure shows up here instead of as latency in the browser
+        int size = SEND_BUFFER_BYTES;
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+        Client client;
+        client.fd = fd;
+        client.state = HANDSHAKE;
+        client.sent = 0;
+        clients_.push_back(std::move(client));
+    }
+}
+
+bool Server::busy(const Client& client) const {
+    if (client.sent < client.sending.size() || !client.control.empty()) return true;
+#if defined(__linux__) && defined(SIOCOUTQ)
+    int queued = 0;
+    if (ioctl(client.fd, SIOCOUTQ, &queued) == 0 && (size_t)queued > MAX_QUEUED_BYTES) return true;
+#endif
+    return false;
+}
+
+void Server::queueControl(Client& client, uint8_t opcode, const uint8_t* payload, size_t len) {
+    std::vector<uint8_t> bytes;
+    frame(opcode, payload, len, bytes);
+    client.control.insert(client.control.end(), bytes.begin(), bytes.end());
+}
+
+void Server::flush(Client& client) {
+    while (client.fd >= 0) {
+        if (client.sent == client.sending.size()) {
+            client.sending.clear();
+            client.sent = 0;
+            if (!client.control.empty()) {
+                client.sending.swap(client.control);
+            } else if (!client.pending.empty() && client.state == OPEN && !busy(client)) {
+                client.sending.swap(client.pending);
+                client.pending.clear();
+                stats_.messages++;
+            } else {
+                break;
+            }
+        }
+
+        ssize_t n = send(client.fd, client.sending.data() + client.sent, client.sending.size() - client.sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+            ::close(client.fd);
+            client.fd = -1;
+            return;
+        }
+        client.sent += (size_t)n;
+    }
+
+    // Close once the close frame (or a handshake rejection) is out
+    if (client.fd >= 0 && client.state == CLOSING && client.sent == client.sending.size()) {
+        ::close(client.fd);
+        client.fd = -1;
+    }
+}
+
+void Server::handshake(Client& client) {
+    const char* end = "\r\n\r\n";
+    auto it = std::search(client.input.begin(), client.input.end(), end, end + 4);
+    if (it == client.input.end()) {
+        if (client.input.size() > MAX_REQUEST_BYTES) {
+            ::close(client.fd);
+            client.fd = -1;
+        }
+        return;
+    }
+    std::string request(client.input.begin(), it);
+    client.input.erase(client.input.begin(), it + 4);
+
+    std::string key;
+    bool upgrade = false;
+    size_t pos = request.find("\r\n");
+    bool get = request.compare(0, 4, "GET ") == 0;
+    while (pos != std::string::npos) {
+        size_t next = request.find("\r\n", pos + 2);
+        std::string line = request.substr(pos + 2, next == std::string::npos ? std::string::npos : next - pos - 2);
+        size_t colon = line.find(':');
+        if (colon != std::string::npos) {
+            std::string name = lower(trim(line.substr(0, colon)));
+            std::string value = trim(line.substr(colon + 1));
+            if (name == "sec-websocket-key") key = value;
+            if (name == "upgrade" && lower(value).find("websocket") != std::string::npos) upgrade = true;
+        }
+        pos = next;
+    }
+
+    std::string response;
+    if (!get || !upgrade || key.empty()) {
+        response = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        client.state = CLOSING;
+    } else {
+        response = "HTTP/1.1 101 Switching Protocols\r\n"
+                   "Upgrade: websocket\r\n"
+                   "Connection: Upgrade\r\n"
+                   "Sec-WebSocket-Accept: " + acceptKey(key) + "\r\n\r\n";
+        client.state = OPEN;
+        stats_.accepted++;
+    }
+    client.control.insert(client.control.end(), response.begin(), response.end());
+    flush(client);
+}
+
+void Server::parseFrames(Client& client) {
+    std::vector<uint8_t>& in = client.input;
+    size_t offset = 0;
+    while (client.fd >= 0 && client.state == OPEN) {
+        if (in.size() - offset < 2) break;
+        const uint8_t* p = &in[offset];
+        uint8_t opcode = p[0] & 0x0F;
+        bool masked = p[1] & 0x80;
+        uint64_t len = p[1] & 0x7F;
+        size_t header = 2;
+        if (len == 126) {
+            if (in.size() - offset < 4) break;
+            len = (uint64_t)p[2] << 8 | p[3];
+            header = 4;
+        } else if (len == 127) {
+            if (in.size() - offset < 10) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+            header = 10;
+        }
+
+        // Clients must mask; we never expect large messages from them
+        if (!masked || len > MAX_INPUT_BYTES) {
+            ::close(client.fd);
+            client.fd = -1;
+            break;
+        }
+        if (in.size() - offset < header + 4 + len) break;
+
+        const uint8_t* mask = p + header;
+        uint8_t* payload = &in[offset + header + 4];
+        for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+
+        if (opcode == OP_CLOSE) {
+            // Echo the status code and stop sending data
+            queueControl(client, OP_CLOSE, payload, len >= 2 ? 2 : 0);
+            client.pending.clear();
+            client.state = CLOSING;
+        } else if (opcode == OP_PING) {
+            queueControl(client, OP_PONG, payload, (size_t)len);
+        }
+        // Data and pong frames from clients are ignored
+        offset += header + 4 + (size_t)len;
+    }
+    if (client.fd >= 0) in.erase(in.begin(), in.begin() + offset);
+}
+
+void Server::receive(Client& client) {
+    uint8_t buf[1024];
+    for (;;) {
+        ssize_t n = recv(client.fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            ::close(client.fd);
+            client.fd = -1;
+            return;
+        }
+        if (n < 0) break;
+        client.input.insert(client.input.end(), buf, buf + n);
+        if (client.input.size() > MAX_REQUEST_BYTES + MAX_INPUT_BYTES) break;
+    }
+
+    if (client.state == HANDSHAKE) handshake(client);
+    if (client.fd >= 0 && client.state == OPEN) parseFrames(client);
+    if (client.fd >= 0) flush(client);
+}
+
+bool Server::poll(int timeout_ms, int watch_fd) {
+    std::vector<pollfd> fds;
+    fds.reserve(clients_.size() + 2);
+    if (listenFd_ >= 0) fds.push_back({listenFd_, POLLIN, 0});
+    if (watch_fd >= 0) fds.push_back({watch_fd, POLLIN, 0});
+    size_t firstClient = fds.size();
+
+    bool waiting = false;
+    for (const Client& client : clients_) {
+        short events = POLLIN;
+        if (busy(client)) {
+            events |= POLLOUT;
+            // A client can be busy only by its kernel queue, which poll
+            // cannot wait on; come back soon to hand it its pending message
+            waiting |= !client.pending.empty();
+        }
+        fds.push_back({client.fd, events, 0});
+    }
+    if (waiting && (timeout_ms < 0 || timeout_ms > BUSY_POLL_MS)) timeout_ms = BUSY_POLL_MS;
+
+    int ready = ::poll(fds.data(), fds.size(), timeout_ms);
+    bool watched = false;
+    if (ready > 0) {
+        for (size_t i = 0; i < firstClient; i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (fds[i].fd == listenFd_) {
+                accept();
+            } else {
+                watched = true;
+            }
+        }
+    }
+    for (size_t i = firstClient; i < fds.size(); i++) {
+        Client& client = clients_[i - firstClient];
+        if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+            receive(client);
+        } else if (client.fd >= 0) {
+            flush(client);
+        }
+    }
+
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [](const Client& c) { return c.fd < 0; }),
+                   clients_.end());
+    return watched;
+}
+
+void Server::broadcast(const uint8_t* data, size_t len) {
+    for (Client& client : clients_) {
+        if (client.fd < 0 || client.state != OPEN) continue;
+        if (!client.pending.empty()) stats_.dropped++;
+        frame(OP_BINARY, data, len, client.pending);
+        flush(client);
+    }
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [](const Client& c) { return c.fd < 0; }),
+                   clients_.end());
+}
+
+}  // namespace ws
@@ -0,0 +1,96 @@
+#ifndef WEB_SOCKET_H
+#define WEB_SOCKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Minimal WebSocket (RFC 6455) broadcast server for streaming glove frames to
+// browsers. Single threaded, non-blocking, driven by poll(): the caller calls
+// Server::poll() in its loop and broadcast() whenever a new frame is ready.
+//
+// Every message is binary and each client only ever holds the newest one:
+// while a client is still sending an earlier message (its socket queue is
+// full), a new broadcast replaces its pending message instead of queueing
+// behind it. A slow dashboard therefore sees fewer frames, never older ones,
+// and never slows down the other clients.
+
+namespace ws {
+
+struct ServerStats {
+    uint64_t accepted = 0;      // Connections that completed the handshake
+    uint64_t messages = 0;      // Messages handed to a client's socket
+    uint64_t dropped = 0;       // Messages replaced before a busy client could take them
+};
+
+class Server {
+public:
+    Server() {}
+    ~Server();
+
+    /**
+     * Listens on port, on the loopback interface unless loopback_only is false.
+     * @return false on failure; see error()
+     */
+    bool listen(uint16_t port, bool loopback_only = true);
+    void close();
+
+    /**
+     * Accepts clients, completes handshakes, answers pings and closes, and
+     * keeps sending pending messages. Waits up to timeout_ms for activity on
+     * the server or on watch_fd (e.g. the glove input), -1 for none.
+     * @return true if watch_fd is readable
+     */
+    bool poll(int timeout_ms, int watch_fd = -1);
+
+    /**
+     * Sends one binary message to every connected client, replacing any
+     * message a busy client has not started sending yet.
+     */
+    void broadcast(const uint8_t* data, size_t len);
+
+    size_t clientCount() const;
+    const ServerStats& stats() const { return stats_; }
+    const std::string& error() const { return error_; }
+
+    // A client whose kernel send queue holds more than this many bytes is
+    // treated as busy; keeps a slow client's latency to a frame or two
+    static const size_t MAX_QUEUED_BYTES = 1024;
+
+private:
+    enum State { HANDSHAKE, OPEN, CLOSING };
+
+    struct Client {
+        int fd;
+        State state;
+        std::vector<uint8_t> input;     // Unparsed bytes from the client
+        std::vector<uint8_t> sending;   // Framed message being written
+        size_t sent;                    // Bytes of sending already written
+        std::vector<uint8_t> control;   // Pongs and closes, go out before pending
+        std::vector<uint8_t> pending;   // Newest data message, framed
+    };
+
+    bool fail(const std::string& message);
+    void accept();
+    void receive(Client& client);
+    void handshake(Client& client);
+    void parseFrames(Client& client);
+    void queueControl(Client& client, uint8_t opcode, const uint8_t* payload, size_t len);
+    void flush(Client& client);
+    bool busy(const Client& client) const;
+
+    int listenFd_ = -1;
+    std::vector<Client> clients_;
+    ServerStats stats_;
+    std::string error_;
+};
+
+/**
+ * Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key.
+ */
+std::string acceptKey(const std::string& key);
+
+}  // namespace ws
+
+#endif
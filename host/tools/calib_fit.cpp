@@ -0,0 +1,376 @@
+// Fits every glove of a fleet its own Hall sensor calibration tables.
+//
+// Each glove records the same calibration routine with its sensor readings
+// streamed instead of angles ('w' on its serial console): every joint worked
+// slowly through its full range a few times. Because the routine is the same,
+// the readings of one sensor follow the same distribution of joint angles on
+// every glove, and only each glove's magnets and sensors map those angles to
+// different readings. So a glove's readings are mapped quantile by quantile
+// onto the reference glove's (by default the fleet median), and from there
+// through the default quadratic for that sensor:
+//
+//   angle = poly(Q_reference(F_glove(reading)))
+//
+// The result is monotone by construction (and forced to be after quantizing),
+// flat beyond the recorded range, and written as one CalibrationBlob per glove
+// (firmware/lib/CalibrationTable/CalibrationBlob.h). Sessions are read, and
+// tables fitted, on all cores.
+//
+//   calib_fit [-o DIR] [--reference ID] [--threads N] SESSION...
+//
+// A SESSION is a .egds file (the glove id comes from its header) or a raw USB
+// CDC capture given as ID:PATH, e.g. `cat /dev/ttyACM0 > glove7.bin` becomes
+// 7:glove7.bin. Several sessions of one glove are pooled. Blobs go to
+// DIR/glove<ID>.cal (default .); load one with 'c' on the glove's serial
+// console followed by the file.
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <map>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "CalibrationBlob.h"
+#include "GloveDataset.h"
+#include "GloveStream.h"
+
+#define FIT_READING_COUNT 4096
+#define FIT_LEVELS 257                  // Quantiles per sensor
+#define FIT_TAIL 0.005                  // Fraction ignored at each end as outliers
+#define FIT_MIN_RANGE 100               // Counts between the outer quantiles for a sensor to count as moved
+
+typedef double Quantiles[FIT_LEVELS];
+
+struct Session {
+    std::string path;
+    bool capture = false;               // Raw USB CDC bytes rather than .egds
+};
+
+struct Glove {
+    uint32_t id = 0;
+    std::vector<Session> sessions;
+    uint64_t frames = 0;
+    std::string error;
+    Quantiles quantiles[CALIBRATION_SENSOR_COUNT];
+    bool moved[CALIBRATION_SENSOR_COUNT] = {};
+    calib::Table tables[CALIBRATION_SENSOR_COUNT];
+};
+
+struct Histogram {
+    uint32_t counts[CALIBRATION_SENSOR_COUNT][FIT_READING_COUNT];
+};
+
+static void count(Histogram& histogram, const int32_t* joints) {
+    for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) {
+        int32_t reading = joints[s] + CALIBRATION_READING_OFFSET;
+        histogram.counts[s][reading < 0 ? 0 : reading >= FIT_READING_COUNT ? FIT_READING_COUNT - 1 : reading]++;
+    }
+}
+
+static bool readDataset(const std::string& path, Histogram& histogram, uint64_t& frames, std::string& error) {
+    dataset::DatasetReader reader;
+    if (!reader.open(path)) {
+        error = reader.error();
+        return false;
+    }
+    std::vector<int32_t> column[CALIBRATION_SENSOR_COUNT];
+    for (uint32_t c = 0; c < reader.chunkCount(); c++) {
+        dataset::ChunkView chunk = reader.chunk(c);
+        uint32_t n = chunk.frameCount();
+        for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) {
+            dataset::ColumnView view = chunk.column(dataset::COL_JOINT_0 + s);
+            column[s].assign(n, -CALIBRATION_READING_OFFSET);
+            if (view.valid()) view.decode(column[s].data());
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            int32_t joints[CALIBRATION_SENSOR_COUNT];
+            for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) joints[s] = column[s][i];
+            count(histogram, joints);
+        }
+        frames += n;
+    }
+    return true;
+}
+
+static bool readCapture(const std::string& path, Histogram& histogram, uint64_t& frames, std::string& error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+    stream::PacketDecoder decoder;
+    stream::StreamDeframer deframer;
+    std::vector<stream::DecodedFrame> decoded;
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        decoded.clear();
+        deframer.feed(buf, n, decoder, decoded);
+        for (const stream::DecodedFrame& frame : decoded) {
+            count(histogram, frame.frame.joints);
+        }
+        frames += decoded.size();
+    }
+    fclose(file);
+    return true;
+}
+
+// Quantile levels from FIT_TAIL to 1 - FIT_TAIL, each reading spread evenly over its count
+static void quantiles(const uint32_t* histogram, uint64_t total, Quantiles out) {
+    uint64_t below = 0;
+    int bin = 0;
+    for (int m = 0; m < FIT_LEVELS; m++) {
+        double rank = (FIT_TAIL + (1 - 2 * FIT_TAIL) * m / (FIT_LEVELS - 1)) * total;
+        while (bin < FIT_READING_COUNT - 1 && below + histogram[bin] < rank) {
+            below += histogram[bin++];
+        }
+        double within = histogram[bin] ? (rank - below) / histogram[bin] : 0.5;
+        out[m] = bin - 0.5 + within;
+    }
+}
+
+static void analyze(Glove& glove) {
+    std::unique_ptr<Histogram> histogram(new Histogram());
+    for (const Session& session : glove.sessions) {
+        bool ok = session.capture ? readCapture(session.path, *histogram, glove.frames, glove.error)
+                                  : readDataset(session.path, *histogram, glove.frames, glove.error);
+        if (!ok) return;
+    }
+    if (glove.frames == 0) {
+        glove.error = "no frames";
+        return;
+    }
+    for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) {
+        quantiles(histogram->counts[s], glove.frames, glove.quantiles[s]);
+        glove.moved[s] = glove.quantiles[s][FIT_LEVELS - 1] - glove.quantiles[s][0] >= FIT_MIN_RANGE;
+    }
+}
+
+// Pool adjacent violators: the closest non-decreasing (or non-increasing) sequence
+static void makeMonotone(double* v, int n) {
+    bool rising = v[n - 1] >= v[0];
+    std::vector<double> sum, width;
+    for (int i = 0; i < n; i++) {
+        sum.push_back(rising ? v[i] : -v[i]);
+        width.push_back(1);
+        while (sum.size() > 1 && sum[sum.size() - 2] / width[width.size() - 2] > sum.back() / width.back()) {
+            sum[sum.size() - 2] += sum.back();
+            width[width.size() - 2] += width.back();
+            sum.pop_back();
+            width.pop_back();
+        }
+    }
+    int i = 0;
+    for (size_t b = 0; b < sum.size(); b++) {
+        for (int k = 0; k < (int)width[b]; k++) {
+            v[i++] = rising ? sum[b] / width[b] : -sum[b] / width[b];
+        }
+    }
+}
+
+static void fit(Glove& glove, const Quantiles* reference, const bool* referenceMoved) {
+    for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) {
+        if (!glove.moved[s] || !referenceMoved[s]) {
+            calib::defaultTable(s, glove.tables[s]);
+            continue;
+        }
+        const double* q = glove.quantiles[s];
+        const double* r = reference[s];
+        const double* p = calib::DEFAULT_POLY[s];
+        double angles[CALIBRATION_KNOT_COUNT];
+        for (int k = 0; k < CALIBRATION_KNOT_COUNT; k++) {
+            double reading = k << CALIBRATION_KNOT_SHIFT;
+            double mapped;
+            if (reading <= q[0]) {
+                mapped = r[0];
+            } else if (reading >= q[FIT_LEVELS - 1]) {
+                mapped = r[FIT_LEVELS - 1];
+            } else {
+                int m = (int)(std::upper_bound(q, q + FIT_LEVELS, reading) - q) - 1;
+                double t = q[m + 1] > q[m] ? (reading - q[m]) / (q[m + 1] - q[m]) : 0;
+                mapped = r[m] + t * (r[m + 1] - r[m]);
+            }
+            angles[k] = p[0] * mapped * mapped + p[1] * mapped + p[2];
+        }
+        // The quadratic can turn over near the ends of the reference range
+        makeMonotone(angles, CALIBRATION_KNOT_COUNT);
+        for (int k = 0; k < CALIBRATION_KNOT_COUNT; k++) {
+            glove.tables[s][k] = calib::toKnot(angles[k]);
+        }
+    }
+}
+
+static bool writeBlob(const Glove& glove, const std::string& dir, int64_t created) {
+    std::vector<uint8_t> blob(calib::BLOB_SIZE);
+    calib::BlobHeader header = {};
+    header.magic = CALIBRATION_MAGIC;
+    header.version = CALIBRATION_VERSION;
+    header.header_size = sizeof(header);
+    header.device_id = glove.id;
+    header.sensor_count = CALIBRATION_SENSOR_COUNT;
+    header.knot_count = CALIBRATION_KNOT_COUNT;
+    header.knot_shift = CALIBRATION_KNOT_SHIFT;
+    header.created_unix_ms = created;
+    memcpy(blob.data() + sizeof(header), glove.tables, sizeof(glove.tables));
+    header.crc = calib::crc32(blob.data() + sizeof(header), blob.size() - sizeof(header));
+    memcpy(blob.data(), &header, sizeof(header));
+
+    std::string path = dir + "/glove" + std::to_string(glove.id) + ".cal";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file || fwrite(blob.data(), 1, blob.size(), file) != blob.size() || fclose(file) != 0) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// Runs job(i) for every i < n on up to threads threads
+template <typename Job>
+static void parallelFor(size_t n, unsigned threads, Job job) {
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads && t < n; t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < n; i = next++) job(i);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+static double seconds(const timespec& a, const timespec& b) {
+    return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    std::string dir = ".";
+    long referenceId = -1;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::map<uint32_t, size_t> byId;
+    std::vector<Glove> gloves;
+
+    std::vector<std::pair<uint32_t, Session>> sessions;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "-o" && value) {
+            dir = argv[++i];
+        } else if (arg == "--reference" && value) {
+            referenceId = atol(argv[++i]);
+        } else if (arg == "--threads" && value) {
+            threads = (unsigned)atoi(argv[++i]);
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 1;
+        } else {
+            Session session;
+            uint32_t id = 0;
+            size_t colon = arg.find(':');
+            if (colon != std::string::npos && colon > 0 && arg.find_first_not_of("0123456789") == colon) {
+                id = (uint32_t)strtoul(arg.c_str(), nullptr, 10);
+                session.path = arg.substr(colon + 1);
+                session.capture = true;
+            } else {
+                session.path = arg;
+                dataset::DatasetReader reader;
+                if (!reader.open(arg)) {
+                    fprintf(stderr, "%s: %s (raw captures are given as ID:PATH)\n", arg.c_str(), reader.error().c_str());
+                    return 1;
+                }
+                id = reader.header().device_id;
+            }
+            sessions.push_back({id, session});
+        }
+    }
+    if (sessions.empty()) {
+        fprintf(stderr, "usage: %s [-o DIR] [--reference ID] [--threads N] SESSION...\n", argv[0]);
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+
+    for (const auto& entry : sessions) {
+        auto found = byId.find(entry.first);
+        if (found == byId.end()) {
+            found = byId.emplace(entry.first, gloves.size()).first;
+            gloves.emplace_back();
+            gloves.back().id = entry.first;
+        }
+        gloves[found->second].sessions.push_back(entry.second);
+    }
+
+    timespec start, read, done;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    parallelFor(gloves.size(), threads, [&](size_t i) { analyze(gloves[i]); });
+    clock_gettime(CLOCK_MONOTONIC, &read);
+
+    std::vector<Glove*> usable;
+    for (Glove& glove : gloves) {
+        if (!glove.error.empty()) {
+            fprintf(stderr, "glove %u: %s, skipped\n", glove.id, glove.error.c_str());
+        } else {
+            usable.push_back(&glove);
+        }
+    }
+    if (usable.empty()) {
+        fprintf(stderr, "no usable sessions\n");
+        return 1;
+    }
+
+    // Reference: one glove, or per sensor and level the median over the gloves where the sensor moved
+    Quantiles reference[CALIBRATION_SENSOR_COUNT];
+    bool referenceMoved[CALIBRATION_SENSOR_COUNT];
+    if (referenceId >= 0) {
+        auto found = byId.find((uint32_t)referenceId);
+        if (found == byId.end() || !gloves[found->second].error.empty()) {
+            fprintf(stderr, "reference glove %ld has no usable sessions\n", referenceId);
+            return 1;
+        }
+        memcpy(reference, gloves[found->second].quantiles, sizeof(reference));
+        memcpy(referenceMoved, gloves[found->second].moved, sizeof(referenceMoved));
+    } else {
+        std::vector<double> values;
+        for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) {
+            referenceMoved[s] = false;
+            for (int m = 0; m < FIT_LEVELS; m++) {
+                values.clear();
+                for (const Glove* glove : usable) {
+                    if (glove->moved[s]) values.push_back(glove->quantiles[s][m]);
+                }
+                if (values.empty()) continue;
+                std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+                reference[s][m] = values[values.size() / 2];
+                referenceMoved[s] = true;
+            }
+        }
+    }
+
+    parallelFor(usable.size(), threads, [&](size_t i) { fit(*usable[i], reference, referenceMoved); });
+    int64_t created = (int64_t)time(nullptr) * 1000;
+    size_t written = 0;
+    uint64_t frames = 0;
+    printf("%8s %9s %10s  %s\n", "glove", "sessions", "frames", "sensors left at the default (did not move)");
+    for (const Glove* glove : usable) {
+        std::string still;
+        for (int s = 0; s < CALIBRATION_SENSOR_COUNT; s++) {
+            if (!glove->moved[s] || !referenceMoved[s]) still += " " + std::to_string(s);
+        }
+        printf("%8u %9zu %10llu  %s\n", glove->id, glove->sessions.size(), (unsigned long long)glove->frames,
+               still.empty() ? "-" : still.c_str() + 1);
+        written += writeBlob(*glove, dir, created);
+        frames += glove->frames;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &done);
+    printf("%zu of %zu gloves written to %s, %llu frames read in %.2f s, fitted in %.3f s on %u threads\n",
+           written, gloves.size(), dir.c_str(), (unsigned long long)frames, seconds(start, read), seconds(read, done),
+           threads);
+    return written == usable.size() ? 0 : 1;
+}
@@ -0,0 +1,568 @@
+// Trains the glove's gesture classifier and exports it for the firmware.
+//
+// Each session is a recording of one gesture class: class 0 is "no gesture"
+// (free hand motion and rest poses), classes 1.. are the gestures, each held
+// or repeated for the whole session. A small MLP is trained in float on
+// windows of every joint plus orientation, then quantized to int8 and scored
+// with the firmware's own kernel (firmware/lib/GestureNet/GestureModel.h), so
+// the int8 accuracy printed is what the glove will get. The held-out part is
+// the end of every session.
+//
+//   gesture_train [-o FILE] [--window N] [--stride N] [--hidden A,B] [--epochs N]
+//                 [--trim-ms MS] [--holdout F] [--seed N] CLASS:SESSION...
+//
+// A SESSION is a .egds file or a raw USB CDC capture. FILE ending in .h is
+// written as a GestureModelData.h to drop into firmware/lib/GestureNet
+// (default ./GestureModelData.h); any other name gets the raw model blob.
+
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "GestureModel.h"
+#include "GloveDataset.h"
+#include "GloveStream.h"
+#include "HandFrame.h"
+
+#define TRAIN_BATCH 64
+#define TRAIN_LEARNING_RATE 1e-3f
+#define TRAIN_INPUT_TAIL 0.005          // Fraction of each feature's values left outside the int8 range, per end
+#define TRAIN_ACTIVATION_TAIL 0.0001    // Same for hidden activations
+
+struct Options {
+    std::string output = "GestureModelData.h";
+    int window = 8;
+    int stride = 4;
+    std::vector<int> hidden = {32, 16};
+    int epochs = 20;
+    int trimMs = 500;
+    double holdout = 0.2;
+    uint32_t seed = 1;
+};
+
+struct Session {
+    int label = 0;
+    std::string path;
+    std::vector<int64_t> timestamps;
+    std::vector<std::array<int32_t, GESTURE_FRAME_FEATURES>> features;
+    std::vector<int8_t> quantized;      // GESTURE_FRAME_FEATURES per frame
+    size_t first = 0, split = 0, end = 0;   // Trimmed range; windows ending before split train
+};
+
+struct Sample {
+    const Session* session;
+    size_t last;                        // Newest frame of the window
+};
+
+static void addFrame(Session& session, int64_t t, const int32_t* joints, const float* quat) {
+    int16_t j[GESTURE_JOINT_COUNT];
+    int16_t q[4];
+    for (int i = 0; i < GESTURE_JOINT_COUNT; i++) {
+        j[i] = (int16_t)std::max(-32768, std::min(32767, joints[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+        q[i] = hand::toFixed(quat[i], HAND_FRAME_QUAT_SCALE);
+    }
+    std::array<int32_t, GESTURE_FRAME_FEATURES> f;
+    gesture::frameFeatures(j, q, f.data());
+    session.timestamps.push_back(t);
+    session.features.push_back(f);
+}
+
+static bool readDataset(Session& session, std::string& error) {
+    dataset::DatasetReader reader;
+    if (!reader.open(session.path)) {
+        error = reader.error();
+        return false;
+    }
+    std::vector<int64_t> time;
+    std::vector<int32_t> joints[GESTURE_JOINT_COUNT];
+    std::vector<float> quat;
+    for (uint32_t c = 0; c < reader.chunkCount(); c++) {
+        dataset::ChunkView chunk = reader.chunk(c);
+        uint32_t n = chunk.frameCount();
+        time.assign(n, 0);
+        chunk.column(dataset::COL_TIMESTAMP_US).decode(time.data());
+        for (int s = 0; s < GESTURE_JOINT_COUNT; s++) {
+            dataset::ColumnView view = chunk.column(dataset::COL_JOINT_0 + s);
+            joints[s].assign(n, 0);
+            if (view.valid()) view.decode(joints[s].data());
+        }
+        std::vector<float> q[4];
+        for (int k = 0; k < 4; k++) {
+            dataset::ColumnView view = chunk.column(dataset::COL_QUAT_X + k);
+            q[k].assign(n, k == 3 ? 1.0f : 0.0f);
+            if (view.valid()) view.decodeQuat(q[k].data());
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            int32_t j[GESTURE_JOINT_COUNT];
+            float qi[4] = {q[0][i], q[1][i], q[2][i], q[3][i]};
+            for (int s = 0; s < GESTURE_JOINT_COUNT; s++) j[s] = joints[s][i];
+            addFrame(session, time[i], j, qi);
+        }
+    }
+    return true;
+}
+
+static bool readCapture(Session& session, std::string& error) {
+    FILE* file = fopen(session.path.c_str(), "rb");
+    if (!file) {
+        error = session.path + ": " + strerror(errno);
+        return false;
+    }
+    stream::PacketDecoder decoder;
+    stream::StreamDeframer deframer;
+    std::vector<stream::DecodedFrame> decoded;
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        decoded.clear();
+        deframer.feed(buf, n, decoder, decoded);
+        for (const stream::DecodedFrame& frame : decoded) {
+            addFrame(session, frame.frame.timestamp_us, frame.frame.joints, frame.frame.quat);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+// Input quantization from the spread of each feature over the training frames
+static void fitInputs(const std::vector<Session>& sessions, gesture::InputQuant* inputs) {
+    for (int f = 0; f < GESTURE_FRAME_FEATURES; f++) {
+        std::vector<int32_t> values;
+        for (const Session& s : sessions) {
+            for (size_t i = s.first; i < s.split; i++) values.push_back(s.features[i][f]);
+        }
+        std::sort(values.begin(), values.end());
+        double lo = values[(size_t)(TRAIN_INPUT_TAIL * (values.size() - 1))];
+        double hi = values[(size_t)((1 - TRAIN_INPUT_TAIL) * (values.size() - 1))];
+        double half = std::max((hi - lo) / 2, 1.0);
+        inputs[f].offset = (int32_t)lround((lo + hi) / 2);
+        inputs[f].scale_q16 = (int32_t)lround(127.0 * 65536.0 / half);
+    }
+}
+
+// --- Float MLP ---
+
+struct Layer {
+    int inputs, outputs;
+    std::vector<float> w, b;                // w[o * inputs + i]
+    std::vector<float> gw, gb, mw, vw, mb, vb;
+};
+
+struct Net {
+    std::vector<Layer> layers;
+    int step = 0;
+};
+
+static void initNet(Net& net, const std::vector<int>& sizes, std::mt19937& rng) {
+    for (size_t l = 0; l + 1 < sizes.size(); l++) {
+        Layer layer;
+        layer.inputs = sizes[l];
+        layer.outputs = sizes[l + 1];
+        std::normal_distribution<float> normal(0.0f, sqrtf(2.0f / layer.inputs));
+        layer.w.resize((size_t)layer.inputs * layer.outputs);
+        for (float& w : layer.w) w = normal(rng);
+        layer.b.assign(layer.outputs, 0.0f);
+        layer.gw.assign(layer.w.size(), 0.0f);
+        layer.mw = layer.vw = layer.gw;
+        layer.gb.assign(layer.outputs, 0.0f);
+        layer.mb = layer.vb = layer.gb;
+        net.layers.push_back(layer);
+    }
+}
+
+// Activations of every layer; ReLU on all but the last
+static void forward(const Net& net, const float* input, std::vector<std::vector<float>>& acts) {
+    acts.resize(net.layers.size() + 1);
+    acts[0].assign(input, input + net.layers[0].inputs);
+    for (size_t l = 0; l < net.layers.size(); l++) {
+        const Layer& layer = net.layers[l];
+        std::vector<float>& out = acts[l + 1];
+        out.assign(layer.outputs, 0.0f);
+        for (int o = 0; o < layer.outputs; o++) {
+            const float* row = &layer.w[(size_t)o * layer.inputs];
+            float a = layer.b[o];
+            for (int i = 0; i < layer.inputs; i++) a += row[i] * acts[l][i];
+            out[o] = l + 1 < net.layers.size() ? std::max(a, 0.0f) : a;
+        }
+    }
+}
+
+static int argmax(const std::vector<float>& v) {
+    return (int)(std::max_element(v.begin(), v.end()) - v.begin());
+}
+
+// Softmax cross-entropy gradients accumulated into gw/gb
+static float backward(Net& net, std::vector<std::vector<float>>& acts, int label) {
+    std::vector<float>& logits = acts.back();
+    float top = *std::max_element(logits.begin(), logits.end());
+    float sum = 0;
+    std::vector<float> delta(logits.size());
+    for (size_t c = 0; c < logits.size(); c++) sum += delta[c] = expf(logits[c] - top);
+    for (size_t c = 0; c < logits.size(); c++) delta[c] = delta[c] / sum - (c == (size_t)label ? 1.0f : 0.0f);
+    float loss = -(logits[label] - top - logf(sum));
+
+    for (int l = (int)net.layers.size() - 1; l >= 0; l--) {
+        Layer& layer = net.layers[l];
+        const std::vector<float>& in = acts[l];
+        std::vector<float> previous(layer.inputs, 0.0f);
+        for (int o = 0; o < layer.outputs; o++) {
+            float d = delta[o];
+            if (d == 0) continue;
+            float* grow = &layer.gw[(size_t)o * layer.inputs];
+            const float* row = &layer.w[(size_t)o * layer.inputs];
+            for (int i = 0; i < layer.inputs; i++) {
+                grow[i] += d * in[i];
+                previous[i] += d * row[i];
+            }
+            layer.gb[o] += d;
+        }
+        if (l > 0) {
+            for (int i = 0; i < layer.inputs; i++) {
+                if (in[i] <= 0) previous[i] = 0;
+            }
+        }
+        delta.swap(previous);
+    }
+    return loss;
+}
+
+static void adam(Net& net, int batch) {
+    const float b1 = 0.9f, b2 = 0.999f, eps = 1e-8f;
+    net.step++;
+    float c1 = 1 - powf(b1, net.step), c2 = 1 - powf(b2, net.step);
+    auto update = [&](std::vector<float>& p, std::vector<float>& g, std::vector<float>& m, std::vector<float>& v) {
+        for (size_t i = 0; i < p.size(); i++) {
+            float gi = g[i] / batch;
+            m[i] = b1 * m[i] + (1 - b1) * gi;
+            v[i] = b2 * v[i] + (1 - b2) * gi * gi;
+            p[i] -= TRAIN_LEARNING_RATE * (m[i] / c1) / (sqrtf(v[i] / c2) + eps);
+            g[i] = 0;
+        }
+    };
+    for (Layer& layer : net.layers) {
+        update(layer.w, layer.gw, layer.mw, layer.vw);
+        update(layer.b, layer.gb, layer.mb, layer.vb);
+    }
+}
+
+// --- Windows ---
+
+static void windowInt8(const Options& opt, const Sample& s, int8_t* out) {
+    size_t span = (size_t)(opt.window - 1) * opt.stride;
+    for (int k = 0; k < opt.window; k++) {
+        size_t frame = s.last - span + (size_t)k * opt.stride;
+        memcpy(out + k * GESTURE_FRAME_FEATURES, &s.session->quantized[frame * GESTURE_FRAME_FEATURES],
+               GESTURE_FRAME_FEATURES);
+    }
+}
+
+static void windowFloat(const Options& opt, const Sample& s, float* out) {
+    int8_t q[GESTURE_MAX_WIDTH];
+    windowInt8(opt, s, q);
+    for (int i = 0; i < opt.window * GESTURE_FRAME_FEATURES; i++) out[i] = q[i] / 127.0f;
+}
+
+// --- Export ---
+
+static void appendBytes(std::vector<uint8_t>& blob, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    blob.insert(blob.end(), p, p + len);
+}
+
+// Largest activation of each hidden layer over the training windows, outliers aside
+static std::vector<float> activationRanges(const Options& opt, const Net& net, const std::vector<Sample>& train) {
+    std::vector<std::vector<float>> values(net.layers.size() - 1);
+    std::vector<std::vector<float>> acts;
+    std::vector<float> input(opt.window * GESTURE_FRAME_FEATURES);
+    size_t step = std::max<size_t>(1, train.size() / 20000);
+    for (size_t i = 0; i < train.size(); i += step) {
+        windowFloat(opt, train[i], input.data());
+        forward(net, input.data(), acts);
+        for (size_t l = 0; l + 1 < net.layers.size(); l++) {
+            values[l].insert(values[l].end(), acts[l + 1].begin(), acts[l + 1].end());
+        }
+    }
+    std::vector<float> ranges;
+    for (std::vector<float>& v : values) {
+        std::sort(v.begin(), v.end());
+        float top = v.empty() ? 1.0f : v[(size_t)((1 - TRAIN_ACTIVATION_TAIL) * (v.size() - 1))];
+        ranges.push_back(std::max(top, 1e-3f));
+    }
+    return ranges;
+}
+
+static std::vector<uint8_t> quantize(const Options& opt, const Net& net, const gesture::InputQuant* inputs,
+                                     const std::vector<Sample>& train, int classes) {
+    std::vector<float> ranges = activationRanges(opt, net, train);
+    std::vector<uint8_t> body;
+    appendBytes(body, inputs, GESTURE_FRAME_FEATURES * sizeof(gesture::InputQuant));
+
+    double inScale = 1.0 / 127;
+    for (size_t l = 0; l < net.layers.size(); l++) {
+        const Layer& layer = net.layers[l];
+        bool last = l + 1 == net.layers.size();
+        float wmax = 1e-8f;
+        for (float w : layer.w) wmax = std::max(wmax, fabsf(w));
+        double wScale = wmax / 127.0;
+        double accScale = wScale * inScale;
+
+        gesture::LayerHeader header = {};
+        header.inputs = (uint16_t)layer.inputs;
+        header.outputs = (uint16_t)layer.outputs;
+        header.relu = last ? 0 : 1;
+        double outScale = 0;
+        if (!last) {
+            outScale = ranges[l] / 127.0;
+            int exponent;
+            double fraction = frexp(accScale / outScale, &exponent);
+            int64_t multiplier = llround(fraction * 2147483648.0);
+            if (multiplier == 2147483648LL) {
+                multiplier /= 2;
+                exponent++;
+            }
+            header.multiplier = (int32_t)multiplier;
+            header.shift = (int8_t)std::max(-30, std::min(31, -exponent));
+        }
+        appendBytes(body, &header, sizeof(header));
+
+        std::vector<int8_t> weights(gesture::paddedWeights(layer.inputs, layer.outputs), 0);
+        for (size_t i = 0; i < layer.w.size(); i++) {
+            weights[i] = (int8_t)std::max(-127L, std::min(127L, lround(layer.w[i] / wScale)));
+        }
+        appendBytes(body, weights.data(), weights.size());
+        for (int o = 0; o < layer.outputs; o++) {
+            int32_t bias = (int32_t)std::max(-2147483647.0, std::min(2147483647.0, round(layer.b[o] / accScale)));
+            appendBytes(body, &bias, sizeof(bias));
+        }
+        inScale = outScale;
+    }
+
+    gesture::ModelHeader header = {};
+    header.magic = GESTURE_MAGIC;
+    header.version = GESTURE_VERSION;
+    header.header_size = sizeof(header);
+    header.window = (uint8_t)opt.window;
+    header.stride = (uint8_t)opt.stride;
+    header.layer_count = (uint8_t)net.layers.size();
+    header.class_count = (uint8_t)classes;
+    header.body_size = (uint32_t)body.size();
+    header.crc = gesture::crc32(body.data(), body.size());
+    std::vector<uint8_t> blob;
+    appendBytes(blob, &header, sizeof(header));
+    blob.insert(blob.end(), body.begin(), body.end());
+    return blob;
+}
+
+static bool writeOutput(const Options& opt, const std::vector<uint8_t>& blob, const std::string& shape) {
+    bool header = opt.output.size() > 2 && opt.output.compare(opt.output.size() - 2, 2, ".h") == 0;
+    FILE* file = fopen(opt.output.c_str(), header ? "w" : "wb");
+    if (!file) {
+        fprintf(stderr, "%s: %s\n", opt.output.c_str(), strerror(errno));
+        return false;
+    }
+    if (!header) {
+        fwrite(blob.data(), 1, blob.size(), file);
+        return fclose(file) == 0;
+    }
+    fprintf(file, "#ifndef GESTURE_MODEL_DATA_H\n#define GESTURE_MODEL_DATA_H\n\n");
+    fprintf(file, "#include <stddef.h>\n#include <stdint.h>\n\n");
+    fprintf(file, "// The gesture model built into the firmware, kept in flash and run from there.\n");
+    fprintf(file, "// Generated by host/tools/gesture_train: %s.\n\n", shape.c_str());
+    fprintf(file, "alignas(4) static const uint8_t GESTURE_MODEL_DATA[] = {");
+    for (size_t i = 0; i < blob.size(); i++) {
+        fprintf(file, "%s0x%02x,", i % 16 == 0 ? "\n    " : " ", blob[i]);
+    }
+    fprintf(file, "\n};\nstatic const size_t GESTURE_MODEL_SIZE = sizeof(GESTURE_MODEL_DATA);\n\n#endif\n");
+    return fclose(file) == 0;
+}
+
+// --- Main ---
+
+static void usage() {
+    fprintf(stderr,
+            "usage: gesture_train [-o FILE] [--window N] [--stride N] [--hidden A,B] [--epochs N]\n"
+            "                     [--trim-ms MS] [--holdout F] [--seed N] CLASS:SESSION...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<Session> sessions;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-o" && hasValue) {
+            opt.output = argv[++i];
+        } else if (arg == "--window" && hasValue) {
+            opt.window = atoi(argv[++i]);
+        } else if (arg == "--stride" && hasValue) {
+            opt.stride = atoi(argv[++i]);
+        } else if (arg == "--hidden" && hasValue) {
+            opt.hidden.clear();
+            for (char* p = strtok(argv[++i], ","); p; p = strtok(nullptr, ",")) opt.hidden.push_back(atoi(p));
+        } else if (arg == "--epochs" && hasValue) {
+            opt.epochs = atoi(argv[++i]);
+        } else if (arg == "--trim-ms" && hasValue) {
+            opt.trimMs = atoi(argv[++i]);
+        } else if (arg == "--holdout" && hasValue) {
+            opt.holdout = atof(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            opt.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (arg[0] != '-' && arg.find(':') != std::string::npos) {
+            Session session;
+            session.label = atoi(arg.substr(0, arg.find(':')).c_str());
+            session.path = arg.substr(arg.find(':') + 1);
+            sessions.push_back(session);
+        } else {
+            usage();
+        }
+    }
+    if (sessions.empty()) usage();
+    if (opt.window < 1 || opt.window > GESTURE_MAX_WINDOW || opt.stride < 1 || opt.stride > GESTURE_MAX_STRIDE ||
+        opt.hidden.size() + 1 > GESTURE_MAX_LAYERS || opt.holdout < 0 || opt.holdout >= 1) {
+        fprintf(stderr, "window 1-%d, stride 1-%d, at most %d hidden layers, holdout in [0, 1)\n", GESTURE_MAX_WINDOW,
+                GESTURE_MAX_STRIDE, GESTURE_MAX_LAYERS - 1);
+        return 2;
+    }
+
+    int classes = 0;
+    for (Session& session : sessions) {
+        std::string error;
+        bool egds = session.path.size() > 5 && session.path.compare(session.path.size() - 5, 5, ".egds") == 0;
+        if (!(egds ? readDataset(session, error) : readCapture(session, error))) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (session.label < 0 || session.label >= GESTURE_MAX_CLASSES) {
+            fprintf(stderr, "%s: class %d out of range 0-%d\n", session.path.c_str(), session.label, GESTURE_MAX_CLASSES - 1);
+            return 1;
+        }
+        classes = std::max(classes, session.label + 1);
+
+        // Drop the moments of getting into and out of the gesture
+        size_t n = session.timestamps.size();
+        int64_t trim = (int64_t)opt.trimMs * 1000;
+        while (session.first < n && session.timestamps[session.first] - session.timestamps[0] < trim) session.first++;
+        session.end = n;
+        while (session.end > session.first && session.timestamps[n - 1] - session.timestamps[session.end - 1] < trim) {
+            session.end--;
+        }
+        session.split = session.end - (size_t)((session.end - session.first) * opt.holdout);
+    }
+    classes = std::max(classes, 2);
+
+    std::vector<int> sizes = {opt.window * GESTURE_FRAME_FEATURES};
+    sizes.insert(sizes.end(), opt.hidden.begin(), opt.hidden.end());
+    sizes.push_back(classes);
+    uint32_t macs = 0;
+    for (size_t l = 0; l + 1 < sizes.size(); l++) {
+        if (sizes[l + 1] < 1 || sizes[l + 1] > GESTURE_MAX_WIDTH) {
+            fprintf(stderr, "hidden layers hold 1-%d units\n", GESTURE_MAX_WIDTH);
+            return 2;
+        }
+        macs += (uint32_t)sizes[l] * sizes[l + 1];
+    }
+    if (macs > GESTURE_MAX_MACS) {
+        fprintf(stderr, "%u multiply-accumulates per frame, the firmware allows %d\n", macs, GESTURE_MAX_MACS);
+        return 2;
+    }
+
+    gesture::InputQuant inputs[GESTURE_FRAME_FEATURES];
+    fitInputs(sessions, inputs);
+    std::vector<Sample> train, test;
+    std::vector<std::vector<size_t>> byClass(classes);
+    size_t span = (size_t)(opt.window - 1) * opt.stride;
+    for (Session& session : sessions) {
+        session.quantized.resize(session.features.size() * GESTURE_FRAME_FEATURES);
+        for (size_t i = 0; i < session.features.size(); i++) {
+            for (int f = 0; f < GESTURE_FRAME_FEATURES; f++) {
+                session.quantized[i * GESTURE_FRAME_FEATURES + f] = gesture::quantizeInput(inputs[f], session.features[i][f]);
+            }
+        }
+        for (size_t last = session.first + span; last < session.end; last++) {
+            if (last < session.split) {
+                byClass[session.label].push_back(train.size());
+                train.push_back({&session, last});
+            } else if (last >= session.split + span) {
+                test.push_back({&session, last});
+            }
+        }
+    }
+    for (int c = 0; c < classes; c++) {
+        if (byClass[c].empty()) {
+            fprintf(stderr, "no training windows for class %d\n", c);
+            return 1;
+        }
+    }
+    printf("%zu training and %zu held-out windows, %d classes, %u MACs per frame\n", train.size(), test.size(),
+           classes, macs);
+
+    // Classes are drawn evenly so a long "no gesture" session does not swamp the rest
+    std::mt19937 rng(opt.seed);
+    Net net;
+    initNet(net, sizes, rng);
+    std::vector<std::vector<float>> acts;
+    std::vector<float> input(sizes[0]);
+    for (int epoch = 0; epoch < opt.epochs; epoch++) {
+        double loss = 0;
+        size_t batches = std::max<size_t>(1, train.size() / TRAIN_BATCH);
+        for (size_t b = 0; b < batches; b++) {
+            for (int k = 0; k < TRAIN_BATCH; k++) {
+                const std::vector<size_t>& pool = byClass[rng() % classes];
+                const Sample& s = train[pool[rng() % pool.size()]];
+                windowFloat(opt, s, input.data());
+                forward(net, input.data(), acts);
+                loss += backward(net, acts, s.session->label);
+            }
+            adam(net, TRAIN_BATCH);
+        }
+        printf("epoch %d: loss %.4f\n", epoch + 1, loss / (batches * TRAIN_BATCH));
+    }
+
+    std::vector<uint8_t> blob = quantize(opt, net, inputs, train, classes);
+    gesture::Model model;
+    const char* problem = gesture::parseModel(blob.data(), blob.size(), &model);
+    if (problem) {
+        fprintf(stderr, "exported model does not validate: %s\n", problem);
+        return 1;
+    }
+
+    // Float and int8 accuracy on the held-out windows, the int8 one through the firmware kernel
+    const std::vector<Sample>& scored = test.empty() ? train : test;
+    std::vector<std::vector<uint32_t>> confusion(classes, std::vector<uint32_t>(classes, 0));
+    size_t floatRight = 0, int8Right = 0;
+    int8_t q[GESTURE_MAX_WIDTH];
+    int32_t scores[GESTURE_MAX_CLASSES];
+    for (const Sample& s : scored) {
+        windowFloat(opt, s, input.data());
+        forward(net, input.data(), acts);
+        floatRight += argmax(acts.back()) == s.session->label;
+        windowInt8(opt, s, q);
+        int predicted = gesture::classify(model, q, scores);
+        int8Right += predicted == s.session->label;
+        confusion[s.session->label][predicted]++;
+    }
+    printf("%s accuracy: float %.2f%%, int8 %.2f%%\n", test.empty() ? "training" : "held-out",
+           100.0 * floatRight / scored.size(), 100.0 * int8Right / scored.size());
+    printf("confusion (rows true class, columns int8 prediction):\n");
+    for (int c = 0; c < classes; c++) {
+        printf("  %2d:", c);
+        for (int p = 0; p < classes; p++) printf(" %7u", confusion[c][p]);
+        printf("\n");
+    }
+
+    std::string shape = "window " + std::to_string(opt.window) + " x " + std::to_string(opt.stride) + ", layers";
+    for (size_t l = 0; l < sizes.size(); l++) shape += (l ? "-" : " ") + std::to_string(sizes[l]);
+    if (!writeOutput(opt, blob, shape)) return 1;
+    printf("%zu-byte model written to %s\n", blob.size(), opt.output.c_str());
+    return 0;
+}
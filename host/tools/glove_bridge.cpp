@@ -0,0 +1,170 @@
+// Fans one glove out to any number of browser tabs over localhost WebSockets.
+//
+// Reads the glove's USB CDC transport (compressed packets or raw HandFrames,
+// see firmware/lib/Transport/UsbCdcTransport.h) once, and sends every frame
+// to each connected client as one binary WebSocket message holding a
+// HandFrame (firmware/lib/HandFrame/HandFrame.h): full-resolution joints,
+// quaternion, acceleration, gyro, buttons and health, little endian.
+// Clients that fall behind skip frames rather than queue them.
+//
+//   glove_bridge /dev/ttyACM0 [port]     (default port 8765)
+//   glove_bridge - [port] < capture.bin     (replayed at its recorded pace)
+//
+// Turn on the glove's USB CDC transport first ('u' on its serial console).
+// Then pick "Connect Bridge" in web/index.html. Run one bridge per glove on
+// different ports to watch several gloves.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "GloveStream.h"
+#include "HandFrame.h"
+#include "WebSocket.h"
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int) {
+    running = 0;
+}
+
+static int openInput(const char* path) {
+    if (strcmp(path, "-") == 0) {
+        fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+        return STDIN_FILENO;
+    }
+    int fd = open(path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) return -1;
+    if (isatty(fd)) {
+        // Binary stream: no echo, no line editing, no CR/LF translation
+        termios tio;
+        if (tcgetattr(fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+    }
+    return fd;
+}
+
+static int64_t monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void toHandFrame(const stream::DecodedFrame& in, uint32_t sequence, hand::Frame* out) {
+    hand::initFrame(out);
+    out->timestamp_us = (uint32_t)in.frame.timestamp_us;
+    out->sequence = sequence;
+    for (int i = 0; i < HAND_FRAME_JOINT_COUNT; i++) {
+        int32_t v = in.frame.joints[i];
+        out->joints[i] = (int16_t)(v < INT16_MIN ? INT16_MIN : v > INT16_MAX ? INT16_MAX : v);
+    }
+    for (int i = 0; i < 4; i++) out->quat[i] = hand::toFixed(in.frame.quat[i], HAND_FRAME_QUAT_SCALE);
+    for (int i = 0; i < 3; i++) {
+        out->linear[i] = hand::toFixed(in.accel[i], HAND_FRAME_LINEAR_SCALE);
+        out->gyro[i] = hand::toFixed(in.gyro[i], HAND_FRAME_GYRO_SCALE);
+    }
+    out->buttons = in.buttons;
+    out->fault_mask = in.fault_mask;
+    out->imu_status = in.imu_status;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <device|-> [port]\n", argv[0]);
+        return 1;
+    }
+    const char* path = argv[1];
+    uint16_t port = argc > 2 ? (uint16_t)strtoul(argv[2], nullptr, 10) : 8765;
+    bool live = strcmp(path, "-") != 0;
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    signal(SIGPIPE, SIG_IGN);
+
+    ws::Server server;
+    if (!server.listen(port)) {
+        fprintf(stderr, "%s\n", server.error().c_str());
+        return 1;
+    }
+    printf("ws://localhost:%u  <-  %s\n", port, path);
+
+    stream::PacketDecoder decoder;
+    stream::StreamDeframer deframer;
+    std::vector<stream::DecodedFrame> frames;
+    hand::Frame out;
+    uint32_t sequence = 0;
+    uint8_t buf[4096];
+    int64_t replayOffset = 0;
+
+    int fd = -1;
+    time_t lastOpen = 0, lastReport = time(nullptr);
+    size_t lastClients = 0;
+    while (running) {
+        // A replugged glove comes back on the same path; retry once a second
+        if (fd < 0 && time(nullptr) != lastOpen) {
+            lastOpen = time(nullptr);
+            fd = openInput(path);
+            if (fd < 0) {
+                if (!live) {
+                    perror(path);
+                    return 1;
+                }
+            } else {
+                decoder.reset();
+                deframer.reset();
+            }
+        }
+
+        if (server.poll(fd < 0 ? 200 : 100, fd)) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                if (!live) break;
+                fprintf(stderr, "%s: %s, reopening\n", path, n == 0 ? "closed" : strerror(errno));
+                close(fd);
+                fd = -1;
+            } else if (n > 0) {
+                frames.clear();
+                deframer.feed(buf, (size_t)n, decoder, frames);
+                for (const stream::DecodedFrame& frame : frames) {
+                    if (!live) {
+                        // Replay a capture at its recorded pace
+                        int64_t now = monotonicUs();
+                        if (sequence == 0) replayOffset = now - frame.frame.timestamp_us;
+                        int64_t due = frame.frame.timestamp_us + replayOffset;
+                        while (running && now < due) {
+                            server.poll((int)((due - now + 999) / 1000));
+                            now = monotonicUs();
+                        }
+                    }
+                    // Each broadcast replaces what a busy client has not taken
+                    // yet, so a burst only costs the clients that keep up
+                    toHandFrame(frame, sequence++, &out);
+                    server.broadcast(reinterpret_cast<const uint8_t*>(&out), sizeof(out));
+                }
+            }
+        }
+
+        if (server.clientCount() != lastClients) {
+            lastClients = server.clientCount();
+            printf("%zu client(s)\n", lastClients);
+        }
+        if (time(nullptr) - lastReport >= 10) {
+            lastReport = time(nullptr);
+            const ws::ServerStats& stats = server.stats();
+            printf("frames %u  sent %llu  dropped %llu  lost packets %u  skipped bytes %llu\n",
+                   sequence, (unsigned long long)stats.messages, (unsigned long long)stats.dropped,
+                   decoder.lostPackets(), (unsigned long long)deframer.skippedBytes());
+        }
+        fflush(stdout);
+    }
+    return 0;
+}
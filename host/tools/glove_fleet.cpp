@@ -0,0 +1,649 @@
+// Virtual glove fleet for scaling and soak tests of the host ingest path.
+//
+// Emulates N gloves, each producing smooth joint and orientation trajectories
+// (the hand drifts between open, fist, point and pinch poses while the wrist
+// turns) at its own rate, with packet loss, emission jitter and a drifting
+// 32-bit clock that starts close to wrapping. Every glove speaks the USB CDC
+// transport byte for byte: compressed FrameCodec packets of
+// USB_CDC_FRAMES_PER_PACKET frames, or raw HandFrames with --raw, in the
+// FrameCodec stream framing, and drops packets the reader has no room for
+// the same way the firmware does.
+//
+// Streams go through pseudo terminals (the default, like /dev/ttyACM*) or
+// Unix sockets into an ingest thread that does what a capture server does:
+// poll() over all gloves, StreamDeframer + PacketDecoder per glove, and
+// optionally a GloveDataset file per glove. The run reports delivered frame
+// rate, loss, ingest CPU per glove and send-to-decode latency percentiles
+// (from the moment a packet is written, so packet batching is not counted). --sweep repeats the run with 1, 2, 4 ... up to N gloves and
+// marks the first step that misses its frames or the latency budget.
+//
+//   glove_fleet [--gloves 20] [--rate 200] [--seconds 10] [--loss 0.01]
+//               [--jitter-us 500] [--drift-ppm 50] [--budget-ms 20]
+//               [--sink pty|socket] [--raw] [--record DIR] [--sweep]
+//               [--external] [--connect SOCKET] [--seed 1]
+//
+// --external skips the built-in ingest: the pty paths are printed and the
+// gloves run for --seconds so an external capture server can open them, or
+// each glove connects to the Unix socket given with --connect.
+
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <mutex>
+#include <poll.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FrameCodec.h"
+#include "GloveDataset.h"
+#include "GloveStream.h"
+#include "HandFrame.h"
+
+#define FLEET_FRAMES_PER_PACKET 4       // USB_CDC_FRAMES_PER_PACKET on the glove
+#define FLEET_PENDING_BYTES 256         // Room the glove's TX buffer has for a stalled reader
+#define FLEET_HISTORY 4096              // Emitted frames remembered per glove for latency
+
+struct Options {
+    int gloves = 20;
+    float rate = 200;
+    float seconds = 10;
+    float loss = 0.01f;
+    float jitter_us = 500;
+    float drift_ppm = 50;
+    float budget_ms = 20;
+    bool socket = false;
+    bool raw = false;
+    bool sweep = false;
+    bool external = false;
+    std::string record;
+    std::string connect;
+    unsigned seed = 1;
+};
+
+static int64_t monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static double threadCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void makeRaw(int fd) {
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Motion model
+
+// Raw joint values for a few hand poses, in the glove's angles[] order
+static const float poses[][HAND_FRAME_JOINT_COUNT] = {
+    {20, 10, 15, 15,   0, 10, 10,   0, 10, 10,   0, 10, 10,   0, 10, 10},     // Open
+    {180, 60, 200, 200,   0, 230, 240,   0, 230, 240,   0, 230, 240,   0, 230, 240},  // Fist
+    {160, 50, 180, 180,  10, 20, 15,   0, 220, 235,   0, 220, 235,   0, 220, 235},    // Point
+    {140, 90, 150, 150,  20, 140, 150,   0, 40, 40,   0, 40, 40,   0, 40, 40},  // Pinch
+    {30, 110, 20, 20,  60, 15, 10,  20, 15, 10, -20, 15, 10, -50, 15, 10},     // Spread
+};
+static const int poseCount = sizeof(poses) / sizeof(poses[0]);
+
+struct Motion {
+    float joint[HAND_FRAME_JOINT_COUNT];
+    float velocity[HAND_FRAME_JOINT_COUNT];
+    float target[HAND_FRAME_JOINT_COUNT];
+    float quat[4];          // x, y, z, w
+    float omega[3];         // rad/s, wanders slowly
+    float linear[3];
+    float untilNext;        // Seconds until the next pose
+
+    void init(std::mt19937& rng) {
+        memcpy(joint, poses[0], sizeof(joint));
+        memset(velocity, 0, sizeof(velocity));
+        memcpy(target, poses[0], sizeof(target));
+        quat[0] = quat[1] = quat[2] = 0;
+        quat[3] = 1;
+        omega[0] = omega[1] = omega[2] = 0;
+        linear[0] = linear[1] = linear[2] = 0;
+        untilNext = 0;
+        (void)rng;
+    }
+
+    void step(float dt, std::mt19937& rng) {
+        std::uniform_real_distribution<float> uniform(0, 1);
+        std::normal_distribution<float> normal(0, 1);
+
+        // New pose every 0.3-1.5 s, a mix of two presets plus some noise
+        untilNext -= dt;
+        if (untilNext <= 0) {
+            untilNext = 0.3f + 1.2f * uniform(rng);
+            int a = (int)(uniform(rng) * poseCount) % poseCount;
+            int b = (int)(uniform(rng) * poseCount) % poseCount;
+            float mix = uniform(rng);
+            for (int i = 0; i < HAND_FRAME_JOINT_COUNT; i++) {
+                target[i] = poses[a][i] * (1 - mix) + poses[b][i] * mix + 8 * normal(rng);
+            }
+        }
+
+        // Critically damped follow gives finger-like velocity profiles
+        const float w = 12.0f;
+        for (int i = 0; i < HAND_FRAME_JOINT_COUNT; i++) {
+            float accel = w * w * (target[i] - joint[i]) - 2 * w * velocity[i];
+            velocity[i] += accel * dt;
+            joint[i] += velocity[i] * dt;
+        }
+
+        // Wrist: angular velocity as a slow random process, integrated
+        for (int i = 0; i < 3; i++) {
+            omega[i] += (-0.5f * omega[i] + 1.5f * normal(rng)) * dt;
+            linear[i] = 0.9f * linear[i] + 0.3f * normal(rng);
+        }
+        float dq[4] = {
+            0.5f * dt * (omega[0] * quat[3] + omega[1] * quat[2] - omega[2] * quat[1]),
+            0.5f * dt * (-omega[0] * quat[2] + omega[1] * quat[3] + omega[2] * quat[0]),
+            0.5f * dt * (omega[0] * quat[1] - omega[1] * quat[0] + omega[2] * quat[3]),
+            0.5f * dt * (-omega[0] * quat[0] - omega[1] * quat[1] - omega[2] * quat[2]),
+        };
+        float norm = 0;
+        for (int i = 0; i < 4; i++) {
+            quat[i] += dq[i];
+            norm += quat[i] * quat[i];
+        }
+        norm = 1.0f / sqrtf(norm);
+        for (int i = 0; i < 4; i++) quat[i] *= norm;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Gloves
+
+struct Emitted {
+    std::atomic<uint32_t> timestamp;
+    std::atomic<int64_t> wall;
+};
+
+struct Glove {
+    int writeFd = -1;
+    int readFd = -1;
+    int holdFd = -1;                // Slave end kept open for an external reader
+    std::string path;
+
+    // Generator side
+    std::mt19937 rng;
+    Motion motion;
+    codec::Encoder encoder;
+    uint8_t packet[CODEC_STREAM_OVERHEAD + 250];
+    bool open = false;
+    std::vector<uint8_t> pending;   // Bytes the reader has not taken yet
+    int64_t start = 0;
+    int64_t nextUs = 0;             // Next nominal capture, monotonic us
+    int64_t periodUs = 0;
+    double clockScale = 1;          // Glove clock rate over real time
+    uint32_t clockOffset = 0;
+    uint32_t sequence = 0;
+    uint64_t frames = 0;
+    uint64_t sentFrames = 0;
+    uint64_t lostPackets = 0;
+    uint64_t overflowPackets = 0;
+    int framesInPacket = 0;
+
+    // Frames handed to the stream, for the ingest side's latency
+    Emitted history[FLEET_HISTORY];
+    std::atomic<uint64_t> published{0};
+
+    // Ingest side
+    stream::PacketDecoder decoder;
+    stream::StreamDeframer deframer;
+    dataset::DatasetWriter writer;
+    bool recording = false;
+    uint64_t cursor = 0;
+    uint64_t decoded = 0;
+};
+
+static bool openStream(Glove& glove, const Options& options, std::string* error) {
+    if (options.socket || !options.connect.empty()) {
+        if (!options.connect.empty()) {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, options.connect.c_str(), sizeof(addr.sun_path) - 1);
+            if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+                *error = options.connect + ": " + strerror(errno);
+                if (fd >= 0) close(fd);
+                return false;
+            }
+            glove.writeFd = fd;
+            glove.path = options.connect;
+        } else {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+                *error = std::string("socketpair: ") + strerror(errno);
+                return false;
+            }
+            glove.writeFd = fds[0];
+            glove.readFd = fds[1];
+            glove.path = "socketpair";
+        }
+    } else {
+        int master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+            *error = std::string("pty: ") + strerror(errno);
+            if (master >= 0) close(master);
+            return false;
+        }
+        glove.path = ptsname(master);
+        // Holding the slave open keeps the master writable while no reader
+        // has the port open, like a plugged-in glove
+        int slave = open(glove.path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (slave < 0) {
+            *error = glove.path + ": " + strerror(errno);
+            close(master);
+            return false;
+        }
+        makeRaw(slave);
+        glove.writeFd = master;
+        if (options.external) {
+            glove.holdFd = slave;
+        } else {
+            glove.readFd = slave;
+        }
+    }
+    fcntl(glove.writeFd, F_SETFL, fcntl(glove.writeFd, F_GETFL) | O_NONBLOCK);
+    if (glove.readFd >= 0) fcntl(glove.readFd, F_SETFL, fcntl(glove.readFd, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+static void closeStream(Glove& glove) {
+    if (glove.writeFd >= 0) close(glove.writeFd);
+    if (glove.readFd >= 0) close(glove.readFd);
+    if (glove.holdFd >= 0) close(glove.holdFd);
+    glove.writeFd = glove.readFd = glove.holdFd = -1;
+}
+
+// Pushes pending bytes; false if the reader is not keeping up
+static bool drain(Glove& glove) {
+    while (!glove.pending.empty()) {
+        ssize_t n = write(glove.writeFd, glove.pending.data(), glove.pending.size());
+        if (n <= 0) return false;
+        glove.pending.erase(glove.pending.begin(), glove.pending.begin() + n);
+    }
+    return true;
+}
+
+// Frames the payload at packet + CODEC_STREAM_HEADER_BYTES and writes it,
+// as UsbCdcTransport::write() does: a packet that does not fit is dropped
+// and the encoder restarts with a keyframe
+static void writePacket(Glove& glove, size_t len, int frames, const Options& options) {
+    std::uniform_real_distribution<float> uniform(0, 1);
+    if (uniform(glove.rng) < options.loss) {
+        // Lost on the link: the encoder does not know
+        glove.lostPackets++;
+        return;
+    }
+    uint8_t* p = glove.packet;
+    p[0] = CODEC_STREAM_SYNC_0;
+    p[1] = CODEC_STREAM_SYNC_1;
+    p[2] = len & 0xFF;
+    p[3] = len >> 8;
+    p[CODEC_STREAM_HEADER_BYTES + len] = codec::streamChecksum(p + CODEC_STREAM_HEADER_BYTES, len);
+    size_t total = len + CODEC_STREAM_OVERHEAD;
+
+    drain(glove);
+    if (glove.pending.size() + total > FLEET_PENDING_BYTES) {
+        glove.overflowPackets++;
+        glove.encoder.requestKeyframe();
+        return;
+    }
+    glove.pending.insert(glove.pending.end(), p, p + total);
+    glove.sentFrames += frames;
+
+    // Latency counts from here: the frames waited for the packet to fill on
+    // the glove, which says nothing about the host
+    int64_t now = monotonicUs();
+    uint64_t published = glove.published.load(std::memory_order_relaxed);
+    for (uint64_t i = published - frames; i < published; i++) {
+        glove.history[i % FLEET_HISTORY].wall.store(now, std::memory_order_relaxed);
+    }
+    glove.published.store(published, std::memory_order_release);
+    drain(glove);
+}
+
+static void flushPacket(Glove& glove, const Options& options) {
+    if (!glove.open) return;
+    glove.open = false;
+    size_t len = glove.encoder.finishPacket();
+    if (len > 0) writePacket(glove, len, glove.framesInPacket, options);
+    glove.framesInPacket = 0;
+}
+
+// Remembers a frame for the reader's latency match; always before its bytes
+// can reach the reader
+static void publish(Glove& glove, uint32_t timestamp, int64_t now) {
+    uint64_t n = glove.published.load(std::memory_order_relaxed);
+    Emitted& slot = glove.history[n % FLEET_HISTORY];
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+    slot.wall.store(now, std::memory_order_relaxed);
+    glove.published.store(n + 1, std::memory_order_release);
+}
+
+static void emitFrame(Glove& glove, int64_t now, const Options& options) {
+    float dt = glove.periodUs * 1e-6f;
+    glove.motion.step(dt, glove.rng);
+
+    hand::Frame frame;
+    hand::initFrame(&frame);
+    frame.timestamp_us = glove.clockOffset + (uint32_t)(int64_t)((now - glove.start) * glove.clockScale);
+    frame.sequence = glove.sequence++;
+    std::normal_distribution<float> noise(0, 0.7f);
+    for (int i = 0; i < HAND_FRAME_JOINT_COUNT; i++) {
+        frame.joints[i] = (int16_t)lrintf(glove.motion.joint[i] + noise(glove.rng));
+    }
+    for (int i = 0; i < 4; i++) frame.quat[i] = hand::toFixed(glove.motion.quat[i], HAND_FRAME_QUAT_SCALE);
+    for (int i = 0; i < 3; i++) {
+        frame.linear[i] = hand::toFixed(glove.motion.linear[i], HAND_FRAME_LINEAR_SCALE);
+        frame.gyro[i] = hand::toFixed(glove.motion.omega[i], HAND_FRAME_GYRO_SCALE);
+    }
+    frame.imu_status = 3;
+
+    glove.frames++;
+
+    if (options.raw) {
+        publish(glove, frame.timestamp_us, now);
+        memcpy(glove.packet + CODEC_STREAM_HEADER_BYTES, &frame, sizeof(frame));
+        writePacket(glove, sizeof(frame), 1, options);
+        return;
+    }
+
+    codec::Frame fixed;
+    fixed.timestamp_us = frame.timestamp_us;
+    for (int i = 0; i < CODEC_JOINT_COUNT; i++) {
+        int v = frame.joints[i] + CODEC_JOINT_OFFSET;
+        fixed.joints[i] = (uint16_t)(v < 0 ? 0 : v > 4095 ? 4095 : v);
+    }
+    memcpy(fixed.quat, frame.quat, sizeof(fixed.quat));
+    memcpy(fixed.accel, frame.linear, sizeof(fixed.accel));
+
+    uint8_t* payload = glove.packet + CODEC_STREAM_HEADER_BYTES;
+    size_t capacity = sizeof(glove.packet) - CODEC_STREAM_OVERHEAD;
+    if (!glove.open) {
+        glove.encoder.beginPacket(payload, capacity);
+        glove.open = true;
+    }
+    if (!glove.encoder.add(fixed)) {
+        flushPacket(glove, options);
+        glove.encoder.beginPacket(payload, capacity);
+        glove.open = true;
+        glove.encoder.add(fixed);
+    }
+    publish(glove, frame.timestamp_us, now);
+    glove.framesInPacket++;
+    if (glove.encoder.frameCount() >= FLEET_FRAMES_PER_PACKET) {
+        flushPacket(glove, options);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Threads
+
+struct IngestStats {
+    std::mutex lock;
+    std::vector<float> latencyMs;
+    double cpuSeconds = 0;
+};
+
+static void generate(std::vector<Glove*>& gloves, const Options& options, int64_t end, double* cpu) {
+    std::normal_distribution<float> normal(0, 1);
+    while (true) {
+        // Next glove due; jitter is added per frame, so keep the nominal
+        // schedule and sleep until the earliest jittered emission
+        Glove* next = nullptr;
+        for (Glove* glove : gloves) {
+            if (!next || glove->nextUs < next->nextUs) next = glove;
+        }
+        if (!next || next->nextUs >= end) break;
+
+        int64_t jitter = (int64_t)fabsf(normal(next->rng) * options.jitter_us);
+        int64_t due = next->nextUs + jitter;
+        int64_t now = monotonicUs();
+        if (due > now) {
+            timespec ts = {(time_t)((due - now) / 1000000), (long)((due - now) % 1000000) * 1000};
+            nanosleep(&ts, nullptr);
+            now = monotonicUs();
+        }
+        emitFrame(*next, now, options);
+        next->nextUs += next->periodUs;
+
+        // A reader that caught up takes what was waiting
+        for (Glove* glove : gloves) {
+            if (!glove->pending.empty()) drain(*glove);
+        }
+    }
+    for (Glove* glove : gloves) {
+        if (!options.raw) flushPacket(*glove, options);
+        drain(*glove);
+    }
+    *cpu = threadCpuSeconds();
+}
+
+static void ingest(std::vector<Glove*>& gloves, std::atomic<bool>& running, IngestStats& stats) {
+    std::vector<pollfd> fds;
+    for (Glove* glove : gloves) fds.push_back({glove->readFd, POLLIN, 0});
+    std::vector<stream::DecodedFrame> frames;
+    std::vector<float> latency;
+    uint8_t buf[4096];
+
+    while (running.load(std::memory_order_relaxed)) {
+        if (poll(fds.data(), fds.size(), 50) <= 0) continue;
+        latency.clear();
+        for (size_t g = 0; g < gloves.size(); g++) {
+            if (!(fds[g].revents & POLLIN)) continue;
+            Glove& glove = *gloves[g];
+            ssize_t n = read(glove.readFd, buf, sizeof(buf));
+            if (n <= 0) continue;
+            int64_t now = monotonicUs();
+
+            frames.clear();
+            glove.deframer.feed(buf, (size_t)n, glove.decoder, frames);
+            uint64_t published = glove.published.load(std::memory_order_acquire);
+            for (const stream::DecodedFrame& frame : frames) {
+                if (glove.recording) glove.writer.append(frame.frame);
+
+                // Match by timestamp; frames lost on the way are skipped over
+                uint32_t timestamp = (uint32_t)frame.frame.timestamp_us;
+                if (published - glove.cursor > FLEET_HISTORY) glove.cursor = published - FLEET_HISTORY;
+                while (glove.cursor < published) {
+                    const Emitted& slot = glove.history[glove.cursor++ % FLEET_HISTORY];
+                    if (slot.timestamp.load(std::memory_order_relaxed) == timestamp) {
+                        latency.push_back((now - slot.wall.load(std::memory_order_relaxed)) / 1000.0f);
+                        break;
+                    }
+                }
+            }
+            glove.decoded += frames.size();
+        }
+
+        std::lock_guard<std::mutex> guard(stats.lock);
+        stats.latencyMs.insert(stats.latencyMs.end(), latency.begin(), latency.end());
+    }
+    std::lock_guard<std::mutex> guard(stats.lock);
+    stats.cpuSeconds = threadCpuSeconds();
+}
+
+static float percentile(std::vector<float>& values, float p) {
+    if (values.empty()) return 0;
+    size_t k = std::min(values.size() - 1, (size_t)(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// One run with n gloves; returns false if it missed frames or the budget
+static bool run(int n, const Options& options, bool header) {
+    std::vector<Glove*> gloves;
+    std::mt19937 seeder(options.seed);
+    std::uniform_real_distribution<float> uniform(-1, 1);
+    std::string error;
+
+    int64_t start = monotonicUs() + 100000;
+    for (int i = 0; i < n; i++) {
+        Glove* glove = new Glove();
+        if (!openStream(*glove, options, &error)) {
+            fprintf(stderr, "glove %d: %s\n", i, error.c_str());
+            for (Glove* g : gloves) {
+                closeStream(*g);
+                delete g;
+            }
+            delete glove;
+            return false;
+        }
+        glove->rng.seed(seeder());
+        glove->motion.init(glove->rng);
+        glove->start = start;
+        glove->clockScale = 1.0 + uniform(seeder) * options.drift_ppm * 1e-6;
+        // Start within a minute of the 32-bit wrap so every run crosses it
+        glove->clockOffset = 0xFFFFFFFFu - (uint32_t)(seeder() % 60000000u);
+        glove->periodUs = (int64_t)(1e6 / options.rate);
+        // Spread the gloves over one period so they do not all fire together
+        glove->nextUs = start + (int64_t)(glove->periodUs * (double)i / n);
+        if (!options.record.empty() && !options.external) {
+            std::string path = options.record + "/glove" + std::to_string(i) + ".egds";
+            glove->recording = glove->writer.open(path, (uint32_t)i);
+            if (!glove->recording) fprintf(stderr, "%s: %s\n", path.c_str(), glove->writer.error().c_str());
+        }
+        gloves.push_back(glove);
+    }
+
+    if (options.external) {
+        for (int i = 0; i < n; i++) printf("glove %d: %s\n", i, gloves[i]->path.c_str());
+        fflush(stdout);
+    }
+
+    IngestStats stats;
+    std::atomic<bool> running(true);
+    std::thread reader;
+    if (!options.external) {
+        reader = std::thread(ingest, std::ref(gloves), std::ref(running), std::ref(stats));
+    }
+
+    int64_t end = start + (int64_t)(options.seconds * 1e6);
+    double generatorCpu = 0;
+    std::thread writer(generate, std::ref(gloves), std::cref(options), end, &generatorCpu);
+    writer.join();
+
+    // Let the reader take the tail before stopping it
+    usleep(200000);
+    running = false;
+    if (reader.joinable()) reader.join();
+    double elapsed = (monotonicUs() - start) * 1e-6;
+
+    uint64_t frames = 0, sent = 0, lost = 0, overflow = 0, decoded = 0, undecodable = 0, decoderLost = 0;
+    for (Glove* glove : gloves) {
+        frames += glove->frames;
+        sent += glove->sentFrames;
+        lost += glove->lostPackets;
+        overflow += glove->overflowPackets;
+        decoded += glove->decoded;
+        undecodable += glove->decoder.droppedFrames();
+        decoderLost += glove->decoder.lostPackets();
+        if (glove->recording) glove->writer.close();
+        closeStream(*glove);
+        delete glove;
+    }
+
+    if (header) {
+        printf("%6s %10s %10s %8s %8s %9s %9s %8s %8s %8s %8s\n", "gloves", "frames/s", "decoded/s", "lost", "overflow",
+               "cpu/glove", "generator", "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    }
+    if (options.external) {
+        printf("%6d %10.0f %10s %8llu %8llu %9s %8.1f%%\n", n, frames / options.seconds, "-",
+               (unsigned long long)lost, (unsigned long long)overflow, "-", generatorCpu / elapsed * 100);
+        return true;
+    }
+
+    float p50 = percentile(stats.latencyMs, 0.5f);
+    float p99 = percentile(stats.latencyMs, 0.99f);
+    float p999 = percentile(stats.latencyMs, 0.999f);
+    float worst = stats.latencyMs.empty() ? 0 : *std::max_element(stats.latencyMs.begin(), stats.latencyMs.end());
+
+    // Everything that made it onto the stream must come out of the decoder,
+    // apart from the delta frames the codec discards after a lost packet
+    // until its next keyframe
+    bool kept = decoded + undecodable + sent / 1000 >= sent;
+    bool ok = kept && overflow == 0 && p99 <= options.budget_ms;
+    printf("%6d %10.0f %10.0f %8llu %8llu %8.2f%% %8.1f%% %8.2f %8.2f %8.2f %8.2f%s\n", n, frames / options.seconds,
+           decoded / options.seconds, (unsigned long long)(options.raw ? lost : decoderLost), (unsigned long long)overflow,
+           stats.cpuSeconds / elapsed / n * 100, generatorCpu / elapsed * 100, p50, p99, p999, worst,
+           ok ? "" : kept && overflow == 0 ? "  <- over latency budget" : "  <- falling behind");
+    fflush(stdout);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool used = true;
+        if (arg == "--gloves" && value) options.gloves = atoi(value);
+        else if (arg == "--rate" && value) options.rate = atof(value);
+        else if (arg == "--seconds" && value) options.seconds = atof(value);
+        else if (arg == "--loss" && value) options.loss = atof(value);
+        else if (arg == "--jitter-us" && value) options.jitter_us = atof(value);
+        else if (arg == "--drift-ppm" && value) options.drift_ppm = atof(value);
+        else if (arg == "--budget-ms" && value) options.budget_ms = atof(value);
+        else if (arg == "--sink" && value) options.socket = strcmp(value, "socket") == 0;
+        else if (arg == "--record" && value) options.record = value;
+        else if (arg == "--connect" && value) options.connect = value;
+        else if (arg == "--seed" && value) options.seed = (unsigned)atoi(value);
+        else used = false;
+        if (used) {
+            i++;
+            continue;
+        }
+        if (arg == "--raw") options.raw = true;
+        else if (arg == "--sweep") options.sweep = true;
+        else if (arg == "--external") options.external = true;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return 1;
+        }
+    }
+    if (!options.connect.empty()) options.external = true;
+    if (options.gloves < 1 || options.rate <= 0 || options.seconds <= 0) {
+        fprintf(stderr, "need --gloves >= 1, --rate > 0 and --seconds > 0\n");
+        return 1;
+    }
+
+    printf("%s, %s, %.0f Hz, loss %.1f%%, jitter %.0f us, drift +-%.0f ppm, %.0f s per run\n",
+           options.socket ? "sockets" : "ptys", options.raw ? "raw HandFrames" : "compressed",
+           options.rate, options.loss * 100, options.jitter_us, options.drift_ppm, options.seconds);
+
+    if (!options.sweep) {
+        return run(options.gloves, options, true) ? 0 : 2;
+    }
+    bool header = true;
+    bool allOk = true;
+    for (int n = 1;; n = std::min(n * 2, options.gloves)) {
+        allOk &= run(n, options, header);
+        header = false;
+        if (n == options.gloves) break;
+    }
+    return allOk ? 0 : 2;
+}
@@ -0,0 +1,75 @@
+// Decodes a binary deferred-log stream (firmware built with
+// -DDEFERRED_LOG_BINARY) into text.
+//
+//   g++ -std=c++17 -O2 -Ifirmware/lib/DeferredLog host/tools/logdecode.cpp -o logdecode
+//   logdecode /dev/ttyACM0        or        logdecode < capture.bin
+//
+// Other Serial output interleaved with the records (boot messages, etc.) is
+// skipped by scanning for the record magic.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "LogRecord.h"
+
+static const char* levelName(uint8_t level) {
+    switch (level) {
+        case LOG_LEVEL_ERROR: return "E";
+        case LOG_LEVEL_WARN: return "W";
+        case LOG_LEVEL_INFO: return "I";
+        case LOG_LEVEL_DEBUG: return "D";
+        default: return "?";
+    }
+}
+
+static bool plausible(const uint8_t* bytes) {
+    LogRecord record;
+    memcpy(&record, bytes, sizeof(record));
+    return record.magic == LOG_RECORD_MAGIC && record.format < LOG_FORMAT_COUNT;
+}
+
+int main(int argc, char** argv) {
+    FILE* in = stdin;
+    if (argc > 1) {
+        in = fopen(argv[1], "rb");
+        if (!in) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    uint8_t window[sizeof(LogRecord)];
+    size_t filled = 0;
+    unsigned long skipped = 0;
+    char line[256];
+    int c;
+
+    while ((c = fgetc(in)) != EOF) {
+        window[filled++] = (uint8_t)c;
+        if (filled < sizeof(window)) {
+            continue;
+        }
+        if (!plausible(window)) {
+            // Slide one byte and keep hunting for the magic
+            memmove(window, window + 1, --filled);
+            skipped++;
+            continue;
+        }
+
+        LogRecord record;
+        memcpy(&record, window, sizeof(record));
+        filled = 0;
+
+        logFormatRecord(record, line, sizeof(line));
+        printf("%10.6f %s %s\n", record.timestamp_us / 1e6, levelName(logFormatLevels[record.format]), line);
+        fflush(stdout);
+    }
+
+    if (skipped > 0) {
+        fprintf(stderr, "logdecode: skipped %lu bytes outside records\n", skipped);
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+// Throughput benchmark for the retargeting engine.
+//
+// Drives a HandSkeleton + Retargeter pipeline with a synthetic, smoothly
+// moving glove and reports frames per second on one core, solver work per
+// frame and the tip residual, warm started (the normal case) and cold.
+//
+//   retarget_bench [robot.hand] [frames]
+//
+// Without a description file it uses a built-in four-finger, 16-joint hand.
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "HandSkeleton.h"
+#include "Retarget.h"
+
+static const char* const builtinHand = R"(
+hand four_finger_16dof
+scale 1.3
+
+chain thumb thumb
+joint thumb_rotation  0.020 -0.010 -0.030   0 0 1      -15 80
+joint thumb_abduction 0.020  0.000 -0.005   0 1 0      -20 70
+joint thumb_mcp       0.020  0.000 -0.020  -1 0 0      -15 90
+joint thumb_ip        0.000  0.000 -0.050  -1 0 0      -15 90
+tip 0 0 -0.060
+
+chain index index
+joint index_abduction 0.045 0 -0.095   0 -1 0   -27 27
+joint index_mcp       0.000 0  0.000  -1  0 0   -15 95
+joint index_pip       0.000 0 -0.054  -1  0 0   -15 100
+joint index_dip       0.000 0 -0.038  -1  0 0   -15 95
+tip 0 0 -0.071
+
+chain middle middle
+joint middle_abduction 0.000 0 -0.095   0 -1 0   -27 27
+joint middle_mcp       0.000 0  0.000  -1  0 0   -15 95
+joint middle_pip       0.000 0 -0.054  -1  0 0   -15 100
+joint middle_dip       0.000 0 -0.038  -1  0 0   -15 95
+tip 0 0 -0.071
+
+chain ring ring
+joint ring_abduction -0.045 0 -0.095   0 -1 0   -27 27
+joint ring_mcp        0.000 0  0.000  -1  0 0   -15 95
+joint ring_pip        0.000 0 -0.054  -1  0 0   -15 100
+joint ring_dip        0.000 0 -0.038  -1  0 0   -15 95
+tip 0 0 -0.071
+)";
+
+// Glove moving through open hand, fist and spread poses at a few Hz, sampled at 200 Hz
+static void syntheticGlove(size_t count, std::vector<dataset::Frame>& frames) {
+    static const float maxima[SKELETON_CHANNEL_COUNT] = {
+        255, 125, 255, 255,
+        80, 240, 255,  80, 240, 255,  80, 240, 255,  80, 240, 255,
+    };
+    frames.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        float t = i / 200.0f;
+        dataset::Frame& frame = frames[i];
+        frame.timestamp_us = (int64_t)i * 5000;
+        for (int c = 0; c < SKELETON_CHANNEL_COUNT; c++) {
+            float phase = 0.7f * c;
+            float wave = 0.5f + 0.5f * sinf(2.0f * 3.14159265f * (0.6f + 0.05f * c) * t + phase);
+            // Abduction channels swing both ways, flexion from 0
+            bool abduction = (c == 1) || (c >= 4 && (c - 4) % 3 == 0);
+            frame.joints[c] = (int32_t)(abduction ? (2.0f * wave - 1.0f) * maxima[c] : wave * maxima[c]);
+        }
+        frame.quat[0] = frame.quat[1] = frame.quat[2] = 0;
+        frame.quat[3] = 1;
+    }
+}
+
+static void run(const char* label, retarget::Retargeter& solver, const std::vector<float>& tips, size_t count, bool cold) {
+    solver.reset();
+    double residual = 0;
+    uint64_t iterations = 0, jacobians = 0, forward = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        if (cold) {
+            solver.reset();
+        }
+        retarget::SolverStats before = solver.stats();
+        solver.solve(reinterpret_cast<const float(*)[3]>(&tips[i * SKELETON_FINGER_COUNT * 3]));
+        const retarget::SolverStats& after = solver.stats();
+        iterations += after.iterations - before.iterations;
+        jacobians += after.jacobians - before.jacobians;
+        forward += after.forward - before.forward;
+        residual += after.residual * after.residual;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double solves = (double)count * solver.hand().chains.size();
+    printf("%-5s %9.0f frames/s  %6.2f us/frame  per chain: %.2f iterations, %.2f jacobians, %.2f fk  rms tip error %.2f mm\n",
+           label, count / seconds, seconds * 1e6 / count,
+           iterations / solves, jacobians / solves, forward / solves, sqrt(residual / count) * 1000);
+}
+
+int main(int argc, char** argv) {
+    retarget::RobotHand hand;
+    std::string error;
+    bool ok = argc > 1 ? retarget::loadRobotHand(argv[1], &hand, &error)
+                       : retarget::parseRobotHand(builtinHand, &hand, &error);
+    if (!ok) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    size_t count = argc > 2 ? strtoul(argv[2], nullptr, 10) : 200000;
+
+    // Human fingertips in the hand frame, solved once up front so only the
+    // retargeting is timed
+    std::vector<dataset::Frame> frames;
+    syntheticGlove(count, frames);
+    skeleton::Engine engine;
+    skeleton::PoseBatch poses;
+    engine.solve(frames.data(), count, poses);
+    static const int tipJoint[SKELETON_FINGER_COUNT] = {
+        skeleton::JOINT_THUMB_TIP, skeleton::JOINT_INDEX_TIP, skeleton::JOINT_MIDDLE_TIP,
+        skeleton::JOINT_RING_TIP, skeleton::JOINT_LITTLE_TIP,
+    };
+    std::vector<float> tips(count * SKELETON_FINGER_COUNT * 3);
+    for (size_t i = 0; i < count; i++) {
+        for (int f = 0; f < SKELETON_FINGER_COUNT; f++) {
+            poses.position(tipJoint[f], i, &tips[(i * SKELETON_FINGER_COUNT + f) * 3]);
+        }
+    }
+
+    retarget::Retargeter solver;
+    if (!solver.setHand(hand, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    printf("%s: %zu chains, %zu joints, %zu frames\n", hand.name.c_str(), hand.chains.size(), solver.dof(), count);
+
+    run("warm", solver, tips, count, false);
+    size_t coldCount = count / 10 > 0 ? count / 10 : count;
+    run("cold", solver, tips, coldCount, true);
+    return 0;
+}
@@ -25,6 +25,7 @@ let ignoreExternalInput = false; // Flag to ignore glove/gamepad input during pl
 
 // DOM elements
 const connectButton = document.getElementById('connect-button');
+const bridgeButton = document.getElementById('bridge-button');
 const disconnectButton = document.getElementById('disconnect-button');
 const statusIndicator = document.getElementById('status-indicator');
 const jointsContainer = document.getElementById('joints-container');
@@ -74,6 +75,12 @@ let hidDevices = new Map(); // Using Map to store devices by their ID
 const REPORT_ID = 1;
 const GLOVE_REPORT_SIZE = 24;
 const TRACKER_REPORT_SIZE = 3;
+// The glove sends three independently rate-limited input reports
+const FINGER_REPORT_ID = 1;       // 16 joint bytes + uint16 sensor fault mask
+const ORIENTATION_REPORT_ID = 2;  // Quaternion x,y,z,w + linear accel x,y,z + IMU status byte
+const BUTTON_REPORT_ID = 3;       // uint16 button bitmap
+const FAULT_MASK_OFFSET = 16;
+const IMU_STATUS_OFFSET = 7;
 const trackers = new Map(); // Map to store tracker data by deviceId
 
 // Add at the start of the file, with other global variables
@@ -601,8 +608,12 @@ resetViewBtn.addEventListener('click', () => {
 
 // Event listeners for serial connection
 connectButton.addEventListener('click', connectToDevice);
+bridgeButton.addEventListener('click', connectToBridge);
 disconnectButton.addEventListener('click', () => {
     // Disconnect all devices
+    for (const deviceId of Array.from(bridges.keys())) {
+        disconnectFromBridge(deviceId);
+    }
     disconnectFromDevice();
 });
 
@@ -610,7 +621,7 @@ disconnectButton.addEventListener('click', () => {
 if (!navigator.hid) {
     statusIndicator.textContent = 'Status: WebHID API not supported in this browser';
     connectButton.disabled = true;
-    addLogMessage('ERROR: WebHID API is not supported in this browser. Try Chrome or Edge.');
+    addLogMessage('ERROR: WebHID API is not supported in this browser. Try Chrome or Edge, or use Connect Bridge.');
 }
 
 // Initialize Three.js scene
@@ -1233,8 +1244,8 @@ async function autoConnectToLastDevice() {
 
 // Update updateConnectionStatus to show more device details
 function updateConnectionStatus() {
-    if (hidDevices.size > 0) {
-        statusIndicator.textContent = `Status: Connected to ${hidDevices.size} device(s)`;
+    if (hidDevices.size + bridges.size > 0) {
+        statusIndicator.textContent = `Status: Connected to ${hidDevices.size + bridges.size} device(s)`;
         statusIndicator.className = 'status connected';
         connectButton.disabled = false;
         disconnectButton.disabled = false;
@@ -1259,6 +1270,18 @@ function updateConnectionStatus() {
             `;
             deviceList.appendChild(deviceDiv);
         }
+        for (const [deviceId, bridge] of bridges) {
+            const deviceDiv = document.createElement('div');
+            deviceDiv.className = 'device-item';
+            deviceDiv.innerHTML = `
+                Glove bridge
+                <span class="device-details">
+                    (${bridge.url})
+                </span>
+                <button onclick="disconnectFromBridge('${deviceId}')">Disconnect</button>
+            `;
+            deviceList.appendChild(deviceDiv);
+        }
     } else {
             statusIndicator.textContent = 'Status: Disconnected';
             statusIndicator.className = 'status disconnected';
@@ -1330,48 +1353,192 @@ function handleHIDInput(event) {
         }
 
         const gloveData = gloves.get(deviceId);
-        let hasChanges = false;
-        
-        // Process joint values
-        for (let i = 0; i < 16; i++) {
-            const rawValue = data.getUint8(i + 3);
-            let finalValue = rawValue;
-            
-            if (gloveData.jointInversions[i]) {
-                if (fingerJointMap[i].type.includes('ABDUCTION')) {
-                    finalValue = 255 - rawValue;
-                } else {
-                    const min = fingerJointMap[i].min;
-                    const max = fingerJointMap[i].max;
-                    finalValue = max - (rawValue - min);
-                }
-            }
-            
-            if (gloveData.jointValues[i] !== finalValue) {
-                gloveData.jointValues[i] = finalValue;
-                updateJointDisplay(deviceId, i, finalValue);
-                hasChanges = true;
+
+        switch (event.reportId) {
+            case FINGER_REPORT_ID:
+                handleFingerReport(deviceId, gloveData, data);
+                break;
+            case ORIENTATION_REPORT_ID:
+                handleOrientationReport(deviceId, gloveData, data);
+                break;
+            case BUTTON_REPORT_ID:
+                gloveData.buttons = data.getUint16(0, true);
+                break;
+        }
+    }
+}
+
+function handleFingerReport(deviceId, gloveData, data) {
+    const values = new Array(16);
+    for (let i = 0; i < 16; i++) {
+        values[i] = data.getUint8(i);
+    }
+    const faultMask = data.byteLength >= FAULT_MASK_OFFSET + 2
+        ? data.getUint16(FAULT_MASK_OFFSET, true)
+        : gloveData.faultMask;
+    applyJointValues(deviceId, gloveData, values, faultMask);
+}
+
+// Shared by HID reports and bridge frames: joint values in glove units
+// (0-255 from HID, full resolution from the bridge) plus the sensor fault mask
+function applyJointValues(deviceId, gloveData, values, faultMask) {
+    let hasChanges = false;
+
+    // Process joint values
+    for (let i = 0; i < 16; i++) {
+        const rawValue = values[i];
+        let finalValue = rawValue;
+
+        if (gloveData.jointInversions[i]) {
+            if (fingerJointMap[i].type.includes('ABDUCTION')) {
+                finalValue = 255 - rawValue;
+            } else {
+                const min = fingerJointMap[i].min;
+                const max = fingerJointMap[i].max;
+                finalValue = max - (rawValue - min);
             }
         }
 
-        // Process quaternion values
-        const quaternionX = (data.getUint8(19) - 127) / 127;
-        const quaternionY = (data.getUint8(20) - 127) / 127;
-        const quaternionZ = (data.getUint8(21) - 127) / 127;
-        const quaternionW = (data.getUint8(22) - 127) / 127;
-        
-        gloveData.quaternion = { x: quaternionX, y: quaternionY, z: quaternionZ, w: quaternionW };
-        const euler = quaternionToEuler(quaternionX, quaternionY, quaternionZ, quaternionW);
-        gloveData.euler = euler;
+        if (gloveData.jointValues[i] !== finalValue) {
+            gloveData.jointValues[i] = finalValue;
+            updateJointDisplay(deviceId, i, finalValue);
+            hasChanges = true;
+        }
+    }
+
+    // Sensor health: flag joints whose sensor the glove reports as faulted
+    if (faultMask !== undefined && faultMask !== gloveData.faultMask) {
+        addLogMessage(faultMask
+            ? `Glove ${deviceId}: sensor fault mask 0x${faultMask.toString(16).padStart(4, '0')}`
+            : `Glove ${deviceId}: all sensors healthy`);
+        gloveData.faultMask = faultMask;
+        for (let i = 0; i < 16; i++) {
+            updateJointDisplay(deviceId, i, gloveData.jointValues[i]);
+        }
+    }
 
-        // Update displays
-        updateQuaternionDisplay(deviceId, quaternionX, quaternionY, quaternionZ, quaternionW);
+    // Update this specific hand model
+    if (hasChanges) {
+        updateHandModel(deviceId);
+    }
+}
+
+function handleOrientationReport(deviceId, gloveData, data) {
+    // Process quaternion values
+    const quaternionX = (data.getUint8(0) - 127) / 127;
+    const quaternionY = (data.getUint8(1) - 127) / 127;
+    const quaternionZ = (data.getUint8(2) - 127) / 127;
+    const quaternionW = (data.getUint8(3) - 127) / 127;
 
-        // Update this specific hand model
-        if (hasChanges) {
-            updateHandModel(deviceId);
+    gloveData.quaternion = { x: quaternionX, y: quaternionY, z: quaternionZ, w: quaternionW };
+    gloveData.euler = quaternionToEuler(quaternionX, quaternionY, quaternionZ, quaternionW);
+
+    if (data.byteLength > IMU_STATUS_OFFSET) {
+        gloveData.imuStatus = data.getUint8(IMU_STATUS_OFFSET);
+    }
+
+    // Update displays
+    updateQuaternionDisplay(deviceId, quaternionX, quaternionY, quaternionZ, quaternionW);
+    updateHandModel(deviceId);
+}
+
+// Host bridge (host/tools/glove_bridge.cpp): one process reads the glove and
+// sends every frame to each tab as a binary HandFrame over a localhost
+// WebSocket, at full resolution (firmware/lib/HandFrame/HandFrame.h)
+const DEFAULT_BRIDGE_URL = 'ws://localhost:8765';
+const HAND_FRAME_MAGIC = 0x48;
+const HAND_FRAME_MIN_SIZE = 69;
+const HAND_FRAME_QUAT_SCALE = 16384;
+const bridges = new Map(); // Map of bridge sockets by deviceId
+
+function connectToBridge() {
+    const url = prompt('Glove bridge address', localStorage.getItem('bridgeUrl') || DEFAULT_BRIDGE_URL);
+    if (!url) return;
+    localStorage.setItem('bridgeUrl', url);
+
+    const deviceId = `bridge-${url.replace(/^wss?:\/\//, '').replace(/[^A-Za-z0-9]+/g, '-')}`;
+    if (bridges.has(deviceId)) {
+        addLogMessage(`Already connected to bridge ${url}`);
+        return;
+    }
+
+    const socket = new WebSocket(url);
+    socket.binaryType = 'arraybuffer';
+    const bridge = { url, socket, latest: null, scheduled: false };
+    bridges.set(deviceId, bridge);
+
+    socket.onopen = () => {
+        addLogMessage(`Connected to glove bridge ${url}`);
+        updateConnectionStatus();
+    };
+    socket.onmessage = (event) => {
+        // Keep only the newest frame and apply it on the next paint, so a busy
+        // tab skips frames instead of falling behind
+        bridge.latest = event.data;
+        if (!bridge.scheduled) {
+            bridge.scheduled = true;
+            requestAnimationFrame(() => {
+                bridge.scheduled = false;
+                handleBridgeFrame(deviceId, bridge.latest);
+            });
         }
+    };
+    socket.onclose = () => {
+        if (bridges.get(deviceId) === bridge) {
+            bridges.delete(deviceId);
+            cleanupDevice(deviceId);
+            addLogMessage(`Glove bridge ${url} closed`);
+            updateConnectionStatus();
+        }
+    };
+    socket.onerror = () => {
+        addLogMessage(`Glove bridge ${url}: connection error (is glove_bridge running?)`);
+    };
+}
+
+function disconnectFromBridge(deviceId) {
+    const bridge = bridges.get(deviceId);
+    if (!bridge) return;
+    bridges.delete(deviceId);
+    bridge.socket.close();
+    cleanupDevice(deviceId);
+    addLogMessage(`Disconnected from glove bridge ${bridge.url}`);
+    updateConnectionStatus();
+}
+
+function handleBridgeFrame(deviceId, buffer) {
+    if (ignoreExternalInput || !buffer) return;
+
+    const data = new DataView(buffer);
+    // Frames from newer firmware are longer; the fields read here keep their offsets
+    if (data.byteLength < HAND_FRAME_MIN_SIZE || data.getUint8(0) !== HAND_FRAME_MAGIC ||
+        data.getUint16(2, true) < HAND_FRAME_MIN_SIZE) {
+        return;
+    }
+
+    if (!gloves.has(deviceId)) {
+        addGloveDisplay(deviceId);
+        createHandModel(deviceId);
     }
+    const gloveData = gloves.get(deviceId);
+
+    const values = new Array(16);
+    for (let i = 0; i < 16; i++) {
+        values[i] = data.getInt16(12 + i * 2, true);
+    }
+    applyJointValues(deviceId, gloveData, values, data.getUint16(66, true));
+
+    const x = data.getInt16(44, true) / HAND_FRAME_QUAT_SCALE;
+    const y = data.getInt16(46, true) / HAND_FRAME_QUAT_SCALE;
+    const z = data.getInt16(48, true) / HAND_FRAME_QUAT_SCALE;
+    const w = data.getInt16(50, true) / HAND_FRAME_QUAT_SCALE;
+    gloveData.quaternion = { x, y, z, w };
+    gloveData.euler = quaternionToEuler(x, y, z, w);
+    gloveData.buttons = data.getUint16(64, true);
+    gloveData.imuStatus = data.getUint8(68);
+
+    updateQuaternionDisplay(deviceId, x, y, z, w);
+    updateHandModel(deviceId);
 }
 
 // Add log message function (needs to be defined early)
@@ -1782,7 +1949,10 @@ function addGloveDisplay(deviceId) {
         jointValues: new Array(MAX_JOINTS).fill(0),
         jointInversions: new Array(MAX_JOINTS).fill(false),
         quaternion: { x: 0, y: 0, z: 0, w: 1 },
-        euler: { roll: 0, pitch: 0, yaw: 0 }
+        euler: { roll: 0, pitch: 0, yaw: 0 },
+        faultMask: 0,
+        imuStatus: 0,
+        buttons: 0
     });
 }
 
@@ -1792,7 +1962,8 @@ function updateJointDisplay(deviceId, jointIndex, value) {
     const barElement = document.getElementById(`joint-bar-${deviceId}-${jointIndex}`);
     
     if (valueElement && barElement) {
-        valueElement.textContent = `Value: ${value}`;
+        const faulted = ((gloves.get(deviceId)?.faultMask || 0) >> jointIndex) & 1;
+        valueElement.textContent = faulted ? `Value: ${value} (sensor fault)` : `Value: ${value}`;
         
         const jointInfo = fingerJointMap[jointIndex];
         const min = jointInfo?.min || 0;